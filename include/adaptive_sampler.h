@@ -0,0 +1,30 @@
+#pragma once
+
+/*
+ * Variance-driven sampling interval, per metric.
+ *
+ * Readings are treated as sample-and-hold: what the rest of the firmware
+ * sees between two readings is the older one, so the change from one
+ * reading to the next is the error that slower sampling would have made.
+ * Per metric, that change is compared with a tolerance (about one display
+ * step) and a short EWMA of its square tracks how busy the signal is:
+ *   change > tolerance        -> straight back to the minimum interval
+ *   change > tolerance / 2    -> interval halved
+ *   RMS change < tolerance/2  -> interval grows by half, up to the maximum
+ * So a flat room backs off to the slow bound within a minute or so, and a
+ * door or HVAC cycle is sampled at the fast rate from the first reading
+ * that shows it (at most one slow interval late).
+ * The bounds are hard limits, set per metric (config.h). Pressure's fast
+ * bound is the period of the QMP6988 profile, so the sampler never asks for
+ * results faster than the sensor makes them, and its slow bound is longer:
+ * pressure moves over hours.
+ */
+
+#include <stdint.h>
+#include "history.h"
+
+void samplerSetBounds(Metric metric, uint32_t minIntervalMs, uint32_t maxIntervalMs);
+// Feed a new reading of a metric
+void samplerAdd(Metric metric, float value);
+// How long to wait before the next reading of the metric
+uint32_t samplerIntervalMs(Metric metric);
@@ -0,0 +1,23 @@
+#pragma once
+
+/*
+ * BLE GATT server (build with -DENABLE_BLE=1, see config.h).
+ *
+ * Environmental Sensing Service with the standard temperature, humidity
+ * and pressure characteristics. Values are notified only when they cross
+ * the change thresholds in config.h, and crossings are batched into one
+ * notification round per BLE_NOTIFY_MIN_INTERVAL_MS. The central is asked
+ * for a long connection interval except while history is being pulled.
+ *
+ * Bulk history: write a u32 start time (seconds since boot) to the history
+ * control characteristic; matching records then arrive as notifications on
+ * the history data characteristic, packed to the negotiated MTU (format in
+ * ess_codec.h). Chunks are paced on the stack: one is sent only after the
+ * previous one was accepted and while the link is not congested. Record
+ * times are seconds since boot; the boot time characteristic holds the Unix
+ * time of boot (u32, 0 while the clock is not set) to turn them into real
+ * time.
+ */
+
+void bleBegin();
+void blePoll(float temp, float humidity, float pressure);
@@ -0,0 +1,146 @@
+#pragma once
+
+/*
+ * Columnar log format for SD history (.ecl).
+ *
+ * File:   header | block* | [footer]
+ * Header: "ECL1" u32 | version u16 | blockCapacity u16
+ * Block:  BlockHeader (zone map: series, count, seq, time and value
+ *         range, CRC-32) | time column u32[count] | value column f32[count]
+ * Footer: "IDX1" u32 | entries u32 | ColLogZone[entries]
+ *         | footerOffset u32 | "ECLF" u32
+ *
+ * Each block holds one series only, so a query reads just the column it
+ * needs, and the zone map lets it skip blocks outside the time range
+ * without touching their payload. The footer is a compact copy of all zone
+ * maps, written when a file is closed; files without one (still open, or
+ * cut short) are indexed by walking the block headers instead. A reopened
+ * file simply gets a new footer at the end; readers skip the old one.
+ *
+ * Power loss: every block carries a sequence number and a CRC over its
+ * header and columns, and is on the card before its index entry. On open,
+ * recovery starts from the last index entry (the checkpoint), steps back
+ * past any entry whose block fails its CRC, and scans only the file tail
+ * after it for blocks the index missed. A torn block is never rewritten;
+ * new blocks go after it and scans resync on the next block magic.
+ *
+ * Index (<name>.idx next to each log): "EIX1" u32 | ColLogIndexEntry*
+ * One sparse entry per block, in file order, appended as blocks are
+ * written. tMaxPrefix is the largest tMax of that block and every block
+ * before it, so it never decreases: a binary search over the entries finds
+ * the first block that can hold a given time in O(log n) small reads,
+ * however long the log is. A missing or stale index is rebuilt from the
+ * block headers when the log is opened.
+ */
+
+#include <FS.h>
+
+const uint16_t colLogBlockCapacity = 64;  // Samples per block (512 B payload)
+const int colLogZoneMax = 512;            // Blocks indexed per file
+const int colLogSeriesMax = 4;
+
+struct __attribute__((packed)) ColLogZone {
+  uint32_t offset;  // File offset of the block header
+  uint8_t series;
+  uint16_t count;
+  uint32_t tMin;
+  uint32_t tMax;
+  float vMin;
+  float vMax;
+};
+
+struct __attribute__((packed)) ColLogIndexEntry {
+  uint32_t offset;      // File offset of the block header
+  uint32_t tMin;
+  uint32_t tMaxPrefix;  // Max tMax over this and all earlier blocks
+  uint8_t series;
+  uint16_t count;
+};
+
+struct ColLogStats {
+  uint32_t blocksRead;    // Block payloads read from the card
+  uint32_t blocksSkipped; // Blocks answered from their zone map alone
+  uint32_t indexReads;    // Index entries read while seeking
+};
+
+struct ColLogRecovery {
+  int dropped;  // Index entries whose block was torn
+  int added;    // Intact blocks found after the last index entry
+};
+
+// "<dir>/<name>.idx" for "<dir>/<name>.ecl"
+void colLogIndexPath(char* buf, int size, const char* logPath);
+// Check the index of a log against its blocks and rewrite it if missing
+// or stale. Returns the number of entries, -1 on error.
+int colLogEnsureIndex(fs::FS& fs, const char* logPath, ColLogRecovery* recovery = nullptr);
+
+// Load the zone maps of a file from its footer, or by walking block headers
+// when there is no valid footer. Returns the number of zones (-1 on error).
+int colLogLoadZones(File& f, ColLogZone* zones, int maxZones);
+
+class ColLogWriter {
+ public:
+  bool open(fs::FS& fs, const char* path, ColLogRecovery* recovery = nullptr);
+  bool isOpen() const { return _open; }
+  // False if the sample was not taken: the writer is not open, the file is
+  // full(), or writing the block it completes failed
+  bool append(uint8_t series, uint32_t time, float value);
+  // No room for more full blocks; the caller should close and rotate files
+  bool full() const { return _zoneCount >= colLogZoneMax - colLogSeriesMax; }
+  // Samples of a series buffered but not yet on the card (also after a
+  // close() that failed to write them)
+  uint16_t pending(uint8_t series) const { return _pending[series].count; }
+  // Buffered samples of `series` within [t0, t1], as ColLogReader::query();
+  // they are newer than anything the writer has put on the card
+  int queryPending(uint8_t series, uint32_t t0, uint32_t t1,
+                   bool (*fn)(uint32_t time, float value, void* ctx), void* ctx) const;
+  bool flush();   // Write partially filled blocks
+  bool close();   // Flush and write the footer
+  // Blocks written by this writer across all files it has had open
+  uint32_t blocksWritten() const { return _blocksWritten; }
+
+ private:
+  struct Pending {
+    uint16_t count;
+    uint32_t times[colLogBlockCapacity];
+    float values[colLogBlockCapacity];
+  };
+  bool writeBlock(uint8_t series);
+
+  File _file;
+  File _index;
+  uint32_t _tMaxPrefix = 0;
+  uint32_t _nextSeq = 0;
+  bool _open = false;
+  Pending _pending[colLogSeriesMax];
+  ColLogZone _zones[colLogZoneMax];
+  int _zoneCount = 0;
+  uint32_t _blocksWritten = 0;
+};
+
+class ColLogReader {
+ public:
+  bool open(fs::FS& fs, const char* path);
+  void close();
+
+  // Index of the first block that can hold a sample at or after t
+  int seek(uint32_t t);
+
+  // Calls fn(time, value, ctx) for samples of `series` within [t0, t1] in
+  // time order, until fn returns false. Returns the samples fn accepted.
+  int query(uint8_t series, uint32_t t0, uint32_t t1,
+            bool (*fn)(uint32_t time, float value, void* ctx), void* ctx);
+  // Min/max over [t0, t1]; blocks wholly inside the range are answered
+  // from their zone map alone
+  bool range(uint8_t series, uint32_t t0, uint32_t t1, float& lo, float& hi);
+
+  const ColLogStats& stats() const { return _stats; }
+
+ private:
+  bool readEntry(int i, ColLogIndexEntry& e);
+
+  File _file;
+  File _index;
+  int _entries = 0;
+  ColLogStats _stats = {0, 0, 0};
+};
@@ -0,0 +1,19 @@
+#pragma once
+
+/*
+ * 256-entry RGB565 colormap (dark blue - cyan - green - yellow - red,
+ * perceptually ordered) for heatmaps. Index 0 is the low end.
+ */
+
+#include <stdint.h>
+
+extern const uint16_t colormap[256];
+
+// Color for v within [lo, hi], clamped
+inline uint16_t colormapColor(float v, float lo, float hi) {
+  if (hi <= lo) return colormap[128];
+  int i = (int)((v - lo) / (hi - lo) * 255.0f + 0.5f);
+  if (i < 0) i = 0;
+  if (i > 255) i = 255;
+  return colormap[i];
+}
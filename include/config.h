@@ -0,0 +1,221 @@
+#pragma once
+
+/*
+ * Build-time options. Override any of these from platformio.ini, e.g.
+ *   build_flags = -DENABLE_MQTT=1 -DWIFI_SSID=\"lab\" -DWIFI_PASSWORD=\"secret\"
+ */
+
+//----------------------------------------------------------
+// Wi-Fi (shared by all network features)
+//----------------------------------------------------------
+
+#ifndef WIFI_SSID
+#define WIFI_SSID ""
+#endif
+#ifndef WIFI_PASSWORD
+#define WIFI_PASSWORD ""
+#endif
+#ifndef WIFI_CONNECT_TIMEOUT_MS
+#define WIFI_CONNECT_TIMEOUT_MS 15000
+#endif
+#ifndef NTP_SERVER
+#define NTP_SERVER "pool.ntp.org"
+#endif
+// POSIX TZ string for local day boundaries (e.g. "CET-1CEST,M3.5.0,M10.5.0/3")
+#ifndef TIME_ZONE
+#define TIME_ZONE "UTC0"
+#endif
+
+//----------------------------------------------------------
+// Sensors
+//----------------------------------------------------------
+
+// SHT30 periodic measurement rate (Sht30Rate): 0 = 0.5/s, 1 = 1/s, 2 = 2/s,
+// 3 = 4/s, 4 = 10/s, 5 = 4/s with ART. Faster rates self-heat the sensor.
+#ifndef SHT30_RATE
+#define SHT30_RATE 1
+#endif
+// Adaptive sampling: each metric is read between its two intervals,
+// slower while readings are steady (see include/adaptive_sampler.h)
+#ifndef ENABLE_ADAPTIVE_SAMPLING
+#define ENABLE_ADAPTIVE_SAMPLING 1
+#endif
+// Temperature and humidity (SHT30)
+#ifndef SAMPLE_MIN_INTERVAL_MS
+#define SAMPLE_MIN_INTERVAL_MS 1000
+#endif
+#ifndef SAMPLE_MAX_INTERVAL_MS
+#define SAMPLE_MAX_INTERVAL_MS 15000
+#endif
+// Pressure (QMP6988); the fast bound is the acquisition profile's period
+#ifndef PRESSURE_MAX_INTERVAL_MS
+#define PRESSURE_MAX_INTERVAL_MS 60000
+#endif
+
+//----------------------------------------------------------
+// MQTT publisher
+//----------------------------------------------------------
+
+#ifndef ENABLE_MQTT
+#define ENABLE_MQTT 0
+#endif
+#ifndef MQTT_HOST
+#define MQTT_HOST ""
+#endif
+#ifndef MQTT_PORT
+#define MQTT_PORT 1883
+#endif
+#ifndef MQTT_USER
+#define MQTT_USER ""
+#endif
+#ifndef MQTT_PASSWORD
+#define MQTT_PASSWORD ""
+#endif
+#ifndef MQTT_TOPIC
+#define MQTT_TOPIC "cardenv"
+#endif
+// One batch message per interval; Wi-Fi is only up while a batch is sent
+#ifndef MQTT_PUBLISH_INTERVAL_MS
+#define MQTT_PUBLISH_INTERVAL_MS 300000
+#endif
+
+//----------------------------------------------------------
+// Prometheus /metrics endpoint
+//----------------------------------------------------------
+
+// Keeps Wi-Fi up permanently while enabled
+#ifndef ENABLE_METRICS
+#define ENABLE_METRICS 0
+#endif
+#ifndef METRICS_PORT
+#define METRICS_PORT 9100
+#endif
+
+//----------------------------------------------------------
+// InfluxDB line protocol writer
+//----------------------------------------------------------
+
+#ifndef ENABLE_INFLUX
+#define ENABLE_INFLUX 0
+#endif
+// Full write URL, e.g. "http://influx:8086/api/v2/write?org=lab&bucket=env&precision=s"
+#ifndef INFLUX_URL
+#define INFLUX_URL ""
+#endif
+// Sent as "Authorization: Token <token>" when set
+#ifndef INFLUX_TOKEN
+#define INFLUX_TOKEN ""
+#endif
+// Measurement and tag set prefix of every line
+#ifndef INFLUX_SERIES
+#define INFLUX_SERIES "environment,device=cardenv"
+#endif
+// Flush when the batch is full or its oldest bin is this old
+#ifndef INFLUX_FLUSH_AGE_MS
+#define INFLUX_FLUSH_AGE_MS 600000
+#endif
+
+//----------------------------------------------------------
+// BLE Environmental Sensing Service
+//----------------------------------------------------------
+
+// BLE plus any Wi-Fi feature may need a larger app partition
+// (board_build.partitions = default_8MB.csv)
+#ifndef ENABLE_BLE
+#define ENABLE_BLE 0
+#endif
+#ifndef BLE_DEVICE_NAME
+#define BLE_DEVICE_NAME "CardENV"
+#endif
+// Change needed before a new notification is sent
+#ifndef BLE_TEMP_THRESHOLD
+#define BLE_TEMP_THRESHOLD 0.1
+#endif
+#ifndef BLE_HUMIDITY_THRESHOLD
+#define BLE_HUMIDITY_THRESHOLD 0.5
+#endif
+#ifndef BLE_PRESSURE_THRESHOLD
+#define BLE_PRESSURE_THRESHOLD 0.2
+#endif
+// Threshold crossings are batched into one notification round at most this often
+#ifndef BLE_NOTIFY_MIN_INTERVAL_MS
+#define BLE_NOTIFY_MIN_INTERVAL_MS 5000
+#endif
+
+//----------------------------------------------------------
+// SD card history log
+//----------------------------------------------------------
+
+// Does nothing when no card is inserted
+#ifndef ENABLE_SD_LOG
+#define ENABLE_SD_LOG 1
+#endif
+// Partially filled blocks are written at least this often
+#ifndef SD_LOG_FLUSH_INTERVAL_MS
+#define SD_LOG_FLUSH_INTERVAL_MS 3600000
+#endif
+
+//----------------------------------------------------------
+// Display
+//----------------------------------------------------------
+
+// How far past a rounding boundary a value must move before the displayed
+// digit changes, as a fraction of one display step (0 = plain rounding).
+// At 0.5 the text changes once the value is a whole step from it; 0.25 still
+// let SHT30 noise flip 0.1 C digits (see test/test_display_filter).
+#ifndef DISPLAY_HYSTERESIS
+#define DISPLAY_HYSTERESIS 0.5
+#endif
+
+//----------------------------------------------------------
+// Power
+//----------------------------------------------------------
+
+// Battery capacity for the battery life estimate on the energy page
+#ifndef BATTERY_CAPACITY_MAH
+#define BATTERY_CAPACITY_MAH 1750
+#endif
+
+//----------------------------------------------------------
+// Loop watchdog
+//----------------------------------------------------------
+
+// Monitor task and task watchdog (include/loop_watchdog.h); the loop
+// iteration histogram is kept either way
+#ifndef ENABLE_LOOP_WATCHDOG
+#define ENABLE_LOOP_WATCHDOG 1
+#endif
+#ifndef LOOP_WATCH_POLL_MS
+#define LOOP_WATCH_POLL_MS 50
+#endif
+// An iteration this long is logged as a stall
+#ifndef LOOP_STALL_MS
+#define LOOP_STALL_MS 250
+#endif
+// An iteration this long restarts the device. The slowest legitimate
+// blocking calls are the network connects, each at most ~19 s:
+//   DNS lookup with no answer    ~14 s (lwIP retries, once per cache miss)
+//   Influx post                  + 2 s TCP connect + 3 s response wait
+//   MQTT connect                 + 3 s TCP connect (WiFiClient default)
+//                                + 2 s CONNACK wait
+// Everything else (SD flush, the benchmark page) takes a few seconds.
+#ifndef LOOP_HANG_MS
+#define LOOP_HANG_MS 30000
+#endif
+// Hardware task watchdog, in case the monitor task itself stops running
+#ifndef LOOP_WDT_TIMEOUT_S
+#define LOOP_WDT_TIMEOUT_S 5
+#endif
+
+//----------------------------------------------------------
+// Profiling
+//----------------------------------------------------------
+
+// Cycle-counter trace points in the hot paths (include/trace.h)
+#ifndef ENABLE_TRACE
+#define ENABLE_TRACE 0
+#endif
+// Events kept in RAM (8 bytes each, power of two)
+#ifndef TRACE_RING_SIZE
+#define TRACE_RING_SIZE 1024
+#endif
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CRC-32 (IEEE 802.3, reflected, poly 0xEDB88320) - same value as zlib's crc32().
+// Pass the previous result as `crc` to checksum data in several pieces.
+uint32_t crc32Update(uint32_t crc, const void* data, size_t len);
+
+inline uint32_t crc32(const void* data, size_t len) {
+  return crc32Update(0, data, len);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+/*
+ * Daily summary archive - min, max, mean and time of min/max per metric for
+ * each local day, kept for a year in a fixed 10 KB flash file (27 bytes a
+ * day: min and max in fixed point, the mean as its position between them,
+ * times in 10 minute steps).
+ *
+ * The current day is accumulated in RAM from every history sample
+ * (dailyAdd() from updateHistory()) and written to its slot every few
+ * samples and when the day ends, so a reboot loses at most a few minutes.
+ * The slot of a day is day % dailyDays: looking up any day of the past
+ * year is one seek and one small read, whatever the date. Each record
+ * carries its day number and a CRC; a slot failing either is a day
+ * without data. Days only exist once the wall clock is valid.
+ */
+
+#include <stdint.h>
+#include "history.h"
+
+const int dailyDays = 366;
+
+struct DayStats {
+  float min;
+  float max;
+  float mean;
+  uint16_t minAt;  // Minutes after local midnight
+  uint16_t maxAt;
+};
+
+struct DaySummary {
+  uint32_t day;      // Local day number (clockLocalDay)
+  uint16_t samples;
+  DayStats metric[METRIC_COUNT];
+};
+
+bool dailyBegin();
+void dailyAdd(uint32_t unixTime, float temp, float humidity, float pressure);
+
+// Summary of a day (today's is the running one); false if there is none
+bool dailyGet(uint32_t day, DaySummary& out);
+// Local day number of now, 0 while the clock is not set
+uint32_t dailyToday();
@@ -0,0 +1,27 @@
+#pragma once
+
+/*
+ * Temperature x humidity 2D histogram for the density scatter page.
+ *
+ * A fixed grid of sample counts, one increment per history sample, so
+ * both updating and drawing cost depend only on the grid size, never on
+ * how many samples were collected. Samples outside the grid are counted
+ * separately. When a cell would overflow every cell is halved, which
+ * keeps the shape while letting old data fade. Saved to flash every hour.
+ */
+
+#include <stdint.h>
+
+const int densityTempBins = 50;
+const int densityHumBins = 50;
+const float densityTempMin = 0.0f;   // deg C
+const float densityTempMax = 40.0f;
+const float densityHumMin = 0.0f;    // %RH
+const float densityHumMax = 100.0f;
+
+bool densityBegin();
+void densityAdd(float temp, float humidity);
+
+uint16_t densityCell(int tempBin, int humBin);
+uint16_t densityMax();          // Largest cell count
+uint32_t densityOutOfRange();   // Samples that fell outside the grid
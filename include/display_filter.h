@@ -0,0 +1,36 @@
+#pragma once
+
+/*
+ * Change detection for numbers shown on screen.
+ *
+ * A value is compared in display units: it is redrawn only when its
+ * rounded text would change, and only once it has moved at least
+ * DISPLAY_HYSTERESIS of a display step past the rounding boundary, so
+ * sensor noise around a boundary cannot make a digit flicker.
+ *
+ * Every update is also checked against the old rule (redraw on any move of
+ * 0.05 since the last redraw), and the difference is counted as avoided
+ * redraws, per clock hour and in total, for the diagnostics page.
+ */
+
+#include <stdint.h>
+
+struct DisplayFilter {
+  float step;      // Display resolution: 0.1 for "%.1f", 1 for "%.0f"
+  bool valid;      // Something is on screen
+  float shown;     // Rounded value on screen
+  float legacy;    // Raw value at the last redraw the old rule would have done
+};
+
+struct DisplayCounts {
+  uint32_t redraws;  // Values repainted
+  uint32_t avoided;  // Repaints the old 0.05 rule would have done on top
+};
+
+// True if value must be redrawn; it is then taken as shown
+bool displayFilterUpdate(DisplayFilter& f, float value);
+// Force a redraw on the next update (page repaint, unit change)
+void displayFilterReset(DisplayFilter& f);
+
+const DisplayCounts& displayCountsTotal();
+const DisplayCounts& displayCountsLastHour();  // Last complete hour
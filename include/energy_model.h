@@ -0,0 +1,82 @@
+#pragma once
+
+/*
+ * Energy accounting. The firmware counts how long each subsystem was active
+ * and how many operations it did; energyEstimate() turns those counters and
+ * a calibration table into the average current each part draws, in mAh per
+ * hour (which is the same number as mA).
+ *
+ * Counted:
+ *   CPU        awake time, plus time spent running loop code (not in delay())
+ *   Backlight  time at each brightness step, screen off as step 0
+ *   Display    bytes pushed to the panel over SPI
+ *   I2C        sensor transactions (SHT30 fetches, QMP6988 reads and starts)
+ *   SD         log block writes (each one a flushed data + index write)
+ *   Radio      Wi-Fi and BLE on-time
+ *
+ * The estimate only depends on EnergyCounters and EnergyCalibration, so a
+ * host replay can fill the counters for a configuration (brightness,
+ * timeout, sampling, exporters) and call energyEstimate() and
+ * energyBatteryHours() directly to predict battery life.
+ */
+
+#include <stdint.h>
+
+enum EnergyPart : uint8_t {
+  ENERGY_CPU,
+  ENERGY_BACKLIGHT,
+  ENERGY_DISPLAY,
+  ENERGY_I2C,
+  ENERGY_SD,
+  ENERGY_RADIO,
+  ENERGY_PART_COUNT
+};
+
+// Screen off, then 20, 40, 60, 80 and 100 % brightness
+const int energyBrightnessSteps = 6;
+
+struct EnergyCounters {
+  uint64_t awakeMs;
+  uint64_t cpuBusyUs;
+  uint64_t backlightMs[energyBrightnessSteps];
+  uint64_t spiBytes;
+  uint32_t i2cTransactions;
+  uint32_t sdBlockWrites;
+  uint64_t wifiOnMs;
+  uint64_t bleOnMs;
+};
+
+// Currents in mA while a state lasts; charges in uA*s (uC) per operation
+struct EnergyCalibration {
+  float cpuIdleMa;   // Awake, blocked in delay()
+  float cpuBusyMa;   // Added while running loop code
+  float backlightMa[energyBrightnessSteps];
+  float spiUasPerKB;
+  float i2cUasPerTransaction;
+  float sdUasPerBlock;
+  float wifiMa;
+  float bleMa;
+};
+
+extern const EnergyCalibration energyDefaultCalibration;
+
+const char* energyPartName(EnergyPart part);
+
+// Average mAh per hour of each part over the counted time (all zero if
+// no time has been counted)
+void energyEstimate(const EnergyCounters& c, const EnergyCalibration& cal,
+                    float mAhPerHour[ENERGY_PART_COUNT]);
+// Hours a full battery of capacityMah lasts at the estimated draw
+float energyBatteryHours(const float mAhPerHour[ENERGY_PART_COUNT], float capacityMah);
+
+// Brightness step of a backlight setting (0..100 %, 0 = off)
+int energyBrightnessStep(int brightnessPercent);
+
+// Counting on the device. energyTick() accounts the time since the previous
+// call to the states passed in; the others add operations as they happen.
+void energyTick(unsigned long nowMs, int brightnessStep, bool wifiOn, bool bleOn);
+void energyAddCpuBusy(uint32_t us);
+void energyAddSpiBytes(uint32_t bytes);
+void energyAddI2c(uint32_t transactions);
+void energyAddSdBlocks(uint32_t blocks);
+const EnergyCounters& energyCounters();
@@ -0,0 +1,41 @@
+#pragma once
+
+/*
+ * Encoding for the Bluetooth Environmental Sensing Service (0x181A) and the
+ * bulk history characteristic. Pure functions, no BLE stack dependency.
+ *
+ * Standard characteristic formats (little-endian):
+ *   Temperature 0x2A6E  sint16, 0.01 deg C
+ *   Humidity    0x2A6F  uint16, 0.01 %RH
+ *   Pressure    0x2A6D  uint32, 0.1 Pa
+ *
+ * History chunk (one notification, at most MTU - 3 bytes):
+ *   seq u16 (bit 15 set on the last chunk) | record * n
+ * History record (12 bytes):
+ *   time u32 (s since boot) | temp sint16 | humidity uint16 | pressure uint32
+ * Boot time (read): u32 Unix time of boot, 0 while the clock is not set
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+const size_t essRecordSize = 12;
+const size_t essChunkHeaderSize = 2;
+const uint16_t essLastChunkFlag = 0x8000;
+
+int16_t essEncodeTemperature(float tempC);
+uint16_t essEncodeHumidity(float humidity);
+uint32_t essEncodePressure(float pressureHpa);
+
+// Records that fit in one notification for a given ATT MTU
+size_t essRecordsPerChunk(uint16_t mtu);
+
+void essPutChunkHeader(uint8_t* out, uint16_t seq, bool last);
+void essPutRecord(uint8_t* out, uint32_t time, float tempC, float humidity, float pressureHpa);
+
+// Notify only when the value has moved at least `threshold` since the last
+// notified value; avoids streaming sensor noise over the air
+inline bool essCrossed(float value, float lastNotified, float threshold) {
+  float d = value - lastNotified;
+  return d >= threshold || -d >= threshold;
+}
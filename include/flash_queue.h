@@ -0,0 +1,52 @@
+#pragma once
+
+/*
+ * Bounded FIFO of byte messages persisted in a flash file, for data that
+ * must survive network outages and reboots.
+ *
+ * The file is a small header followed by a fixed number of equal slots, so
+ * it never grows. head/tail are running counters (slot = counter % slots).
+ * When full, push() overwrites the oldest message and counts it as dropped.
+ *
+ * Power loss: each slot carries the counter it was pushed at and a CRC, and
+ * the header is kept twice, written alternately with a generation number
+ * and its own CRC, so a torn write only ever costs the copy being written.
+ * begin() takes the newer intact header as a checkpoint and rolls forward
+ * over slots pushed after it; peek() rejects a slot whose CRC fails.
+ */
+
+#include <FS.h>
+
+const int flashQueueRetry = -1;
+const int flashQueueBadSlot = -2;
+
+class FlashQueue {
+ public:
+  bool begin(fs::FS& fs, const char* path, uint16_t slots, uint16_t slotSize);
+
+  bool push(const uint8_t* data, uint16_t len);
+  // Copy the oldest message into buf; returns its length, flashQueueRetry
+  // if the queue is empty or the file could not be read (the message is
+  // still there), or flashQueueBadSlot if the slot fails its checks (pop it)
+  int peek(uint8_t* buf, uint16_t bufSize);
+  // Remove the oldest message (after it was delivered)
+  bool pop();
+
+  uint32_t size() const { return _tail - _head; }
+  bool empty() const { return _tail == _head; }
+  uint32_t dropped() const { return _dropped; }
+
+ private:
+  bool writeHeader();
+  bool slotValid(File& f, uint32_t counter);
+  uint32_t slotOffset(uint32_t counter) const;
+
+  fs::FS* _fs = nullptr;
+  const char* _path = nullptr;
+  uint16_t _slots = 0;
+  uint16_t _slotSize = 0;  // Payload bytes per slot (excludes length prefix)
+  uint32_t _head = 0;
+  uint32_t _tail = 0;
+  uint32_t _dropped = 0;
+  uint32_t _generation = 0;
+};
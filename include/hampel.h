@@ -0,0 +1,31 @@
+#pragma once
+
+/*
+ * Spike rejection ahead of the smoothing stage, per metric.
+ *
+ * A causal Hampel filter over the last hampelWindow raw readings: a
+ * reading further than hampelSigmas robust standard deviations (1.4826 x
+ * the median absolute deviation) from the window median is replaced by
+ * that median. Both medians come from a fixed 7-input sorting network,
+ * so each reading costs the same 32 compare-exchanges whatever the data.
+ * Rejected readings still enter the window, so a genuine step passes
+ * after hampelWindow / 2 + 1 readings.
+ *
+ * The MAD is floored per metric at a few times the sensor noise, so on a
+ * flat signal ordinary noise and slow drift are never taken for spikes.
+ */
+
+#include <stdint.h>
+#include "history.h"
+
+const int hampelWindow = 7;
+const float hampelSigmas = 3.0f;
+
+// Feed a raw reading; returns it, or the window median if it was a spike
+float hampelFilter(Metric metric, float raw);
+// Readings replaced since boot
+uint32_t hampelRejected(Metric metric);
+// Empty the windows (e.g. after a sensor restart); counters are kept
+void hampelReset();
+// Median of hampelWindow values by the sorting network; reorders v
+float hampelMedian7(float* v);
@@ -0,0 +1,56 @@
+#pragma once
+
+/*
+ * Reading history - one ring buffer of timestamped samples per metric,
+ * shared by the graph pages and everything that exports history (serial
+ * protocol, loggers).
+ *
+ * Each metric has its own bin width and ring length: temperature and
+ * humidity move within a minute and are kept at 30 s, pressure moves over
+ * hours and is kept at 5 min, each for a little over a day. Exporters with
+ * one record per time step follow the temperature ring and take the other
+ * metrics from historyValueAt(), the last sample at or before that time.
+ *
+ * Times are seconds since boot. Index 0 is the oldest retained sample of a
+ * metric and historyCount(metric) - 1 the newest. historySeq(metric) counts
+ * every sample of that metric ever added, so a reader can tell which
+ * samples it has already seen.
+ */
+
+#include <stdint.h>
+
+enum Metric : uint8_t {
+  METRIC_TEMP = 0,      // deg C
+  METRIC_HUMIDITY = 1,  // %RH
+  METRIC_PRESSURE = 2,  // hPa
+  METRIC_COUNT
+};
+
+// Bin width per metric
+constexpr unsigned long historyIntervals[METRIC_COUNT] = {30000, 30000, 300000};
+// A day plus the span of its graph page and some slack, so the sample
+// 24 h before anything on screen is always at hand
+constexpr int historySizes[METRIC_COUNT] = {3000, 3000, 372};
+
+// Samples covering the last hour
+inline int historyWindow(Metric metric) {
+  return 3600000 / historyIntervals[metric];
+}
+
+void historyClear();
+void historyAdd(Metric metric, uint32_t timeSec, float value);
+
+int historyCount(Metric metric);
+uint32_t historySeq(Metric metric);
+float historyValue(Metric metric, int i);
+uint32_t historyTime(Metric metric, int i);
+
+// Index of the first sample at or after timeSec (historyCount() if none)
+int historyFind(Metric metric, uint32_t timeSec);
+// Index of the last sample at or before timeSec, -1 if none. Guesses the
+// slot from the nominal interval and corrects by a few steps, so this is
+// O(1) however long the ring is.
+int historyAt(Metric metric, uint32_t timeSec);
+// Value of the last sample at or before timeSec (the oldest sample if
+// there is none that early, 0 if the ring is empty)
+float historyValueAt(Metric metric, uint32_t timeSec);
@@ -0,0 +1,16 @@
+#pragma once
+
+/*
+ * InfluxDB writer (build with -DENABLE_INFLUX=1, see config.h).
+ *
+ * History bins are encoded into a fixed batch buffer in line protocol and
+ * POSTed when the buffer is full or its oldest bin reaches
+ * INFLUX_FLUSH_AGE_MS. A cursor over the history sequence only advances
+ * after the server accepts a batch, so after an outage the backlog is
+ * replayed in full batches, one per poll, until it catches up.
+ * Bins are exported once the wall clock is valid, so every line carries
+ * a real timestamp.
+ */
+
+void influxBegin();
+void influxPoll();
@@ -0,0 +1,23 @@
+#pragma once
+
+/*
+ * InfluxDB line protocol encoder for history bins. Writes into a caller
+ * buffer with integer-only formatting - no heap, no printf - so a long
+ * backlog can be serialized quickly.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Dew point (deg C) from temperature and relative humidity, Magnus formula
+float dewPoint(float tempC, float humidity);
+
+// Longest series (measurement and tags) a line can carry
+const size_t lineProtocolSeriesMax = 80;
+
+// Append one line:
+//   <series> temp=..,humidity=..,pressure=..,dewpoint=.. <unixTime>\n
+// Returns the new length, or `len` unchanged if the line does not fit or
+// the series is longer than lineProtocolSeriesMax.
+size_t lineProtocolAppend(char* buf, size_t len, size_t cap, const char* series,
+                          uint32_t unixTime, float temp, float humidity, float pressure);
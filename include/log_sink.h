@@ -0,0 +1,23 @@
+#pragma once
+
+/*
+ * Non-blocking log sink.
+ *
+ * Log calls format into a fixed RAM ring and return immediately. logDrain()
+ * (once per loop) moves buffered text to the port, but never more than the
+ * port reports as free TX space, so a host that is not reading can never
+ * stall the UI. When the ring is full, whole messages are dropped and
+ * counted; the count is reported in the stream once there is room again.
+ */
+
+#include <Arduino.h>
+
+void logBegin(Print& port);
+void logPrintf(const char* format, ...) __attribute__((format(printf, 1, 2)));
+void logPrintln(const char* text);
+// Raw text of any length (logPrintf truncates at one line of 127 chars)
+void logWrite(const char* text, int len);
+
+// Write buffered text to the port, limited to its free TX space
+void logDrain();
+uint32_t logDroppedTotal();
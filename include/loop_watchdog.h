@@ -0,0 +1,60 @@
+#pragma once
+
+/*
+ * Loop latency watchdog.
+ *
+ * loop() brackets each iteration with loopWatchIterationStart() and
+ * loopWatchIterationEnd() and marks what it is doing with loopWatchPhase().
+ * Every iteration time goes into a histogram. A monitor task on the other
+ * core checks the running iteration every LOOP_WATCH_POLL_MS:
+ *   - running for LOOP_STALL_MS or more: counted once as a stall, with the
+ *     phase it is stuck in; loop() logs it when it gets going again
+ *   - running for LOOP_HANG_MS or more: the phase and time are kept in RTC
+ *     memory and the chip restarts
+ * The monitor is subscribed to the task watchdog and feeds it, so if the
+ * monitor itself cannot run (core starved, interrupts off) the hardware
+ * watchdog resets instead. The current phase also lives in RTC memory, so
+ * after a watchdog or panic reset the phase that was running is known too.
+ */
+
+#include <stdint.h>
+
+enum LoopPhase : uint8_t {
+  LOOP_PHASE_IDLE = 0,  // Between iterations (delay())
+  LOOP_PHASE_KEYBOARD,
+  LOOP_PHASE_PROTOCOL,
+  LOOP_PHASE_LOG,
+  LOOP_PHASE_SENSORS,
+  LOOP_PHASE_HISTORY,
+  LOOP_PHASE_SD_LOG,
+  LOOP_PHASE_NETWORK,
+  LOOP_PHASE_DISPLAY,
+  LOOP_PHASE_COUNT
+};
+
+// Iteration times in buckets of x4: <1, 1-4, 4-16, 16-64, 64-256, >=256 ms
+const int loopHistBuckets = 6;
+
+struct LoopWatchStats {
+  uint32_t iterations;
+  uint32_t slowestUs;
+  uint32_t stalls;
+  LoopPhase lastStallPhase;
+  uint32_t histogram[loopHistBuckets];
+};
+
+const char* loopPhaseName(LoopPhase phase);
+
+// Reads the reset record left by the previous boot, starts the monitor
+// task and subscribes it to the task watchdog
+void loopWatchBegin();
+
+void loopWatchIterationStart();
+void loopWatchPhase(LoopPhase phase);
+// Records the iteration time; logs a stall the monitor flagged
+void loopWatchIterationEnd();
+
+const LoopWatchStats& loopWatchStats();
+// Why the previous boot ended, at most 17 chars: e.g. "hang sensors 15s",
+// "wdt display", "panic sd log" or "power on"
+const char* loopWatchLastReset();
@@ -0,0 +1,24 @@
+#pragma once
+
+/*
+ * Prometheus text-format /metrics endpoint (build with -DENABLE_METRICS=1).
+ *
+ * The complete HTTP response lives in one fixed buffer. metricsPoll() only
+ * records the latest inputs; the buffer is re-rendered when a scrape arrives
+ * and those inputs have changed since the last render, and the response is
+ * then written straight from the buffer a chunk per poll. Scrapes never
+ * touch the sensors and never wait on the client inside loop().
+ */
+
+#include <stdint.h>
+
+struct MetricsInputs {
+  float temp;
+  float humidity;
+  float pressure;
+  int battery;
+  bool charging;
+};
+
+void metricsBegin();
+void metricsPoll(const MetricsInputs& inputs);
@@ -0,0 +1,39 @@
+#pragma once
+
+/*
+ * MQTT batch encoding and publish window schedule (message format in
+ * mqtt_publisher.h). Kept apart from the PubSubClient and Wi-Fi code so it
+ * builds and is tested on the host.
+ */
+
+#include <stdint.h>
+#include "wifi_link.h"
+
+// One message from the reading plus the temperature bins from nextSeq on,
+// each with humidity and pressure at its time. Returns the length written
+// to buf (at most cap, not terminated); nextSeq advances past the bins
+// included, and past any the ring no longer holds.
+int mqttBuildBatch(uint8_t* buf, int cap, uint32_t& nextSeq, uint32_t uptimeS, uint32_t unixTime,
+                   float temp, float humidity, float pressure);
+
+struct MqttSchedule {
+  unsigned long interval;  // Between batches
+  unsigned long timeout;   // Longest a publish window stays open
+  unsigned long lastBatch;
+  bool windowOpen;
+  unsigned long windowStart;
+};
+
+enum MqttWindowStep {
+  MQTT_WINDOW_IDLE,   // Closed, nothing to do
+  MQTT_WINDOW_CLOSE,  // Queue drained, timed out or Wi-Fi failed
+  MQTT_WINDOW_WAIT,   // Wi-Fi still connecting
+  MQTT_WINDOW_SEND    // Connect if needed and publish
+};
+
+// True once per interval, when a batch should be queued. The publish
+// window opens with it unless it is already open.
+bool mqttBatchDue(MqttSchedule& s, unsigned long now);
+// What to do with the publish window on this poll
+MqttWindowStep mqttWindowStep(const MqttSchedule& s, unsigned long now, bool queueEmpty,
+                              WifiLinkState link);
@@ -0,0 +1,19 @@
+#pragma once
+
+/*
+ * MQTT publisher (build with -DENABLE_MQTT=1, see config.h).
+ *
+ * Once per MQTT_PUBLISH_INTERVAL_MS the current reading and every history
+ * bin added since the previous batch are packed into one JSON message:
+ *   {"up":<uptime s>,"ts":<unix s or 0>,"temp":..,"hum":..,"press":..,
+ *    "bins":[[<uptime s>,temp,hum,press],...]}
+ * Bin times are seconds since boot; "up"/"ts" anchor them to wall time.
+ *
+ * Batches always go through a flash-backed queue first, then Wi-Fi is
+ * powered up for a short publish window that drains the queue in order.
+ * Batches that could not be sent stay queued across outages and reboots.
+ * The encoding and the window schedule are in mqtt_batch.h.
+ */
+
+void mqttBegin();
+void mqttPoll(float temp, float humidity, float pressure);
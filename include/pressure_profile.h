@@ -0,0 +1,43 @@
+#pragma once
+
+/*
+ * QMP6988 acquisition profiles and the polling that goes with them.
+ *
+ * A profile sets pressure and temperature oversampling, the IIR filter,
+ * the power mode and how often a new result is produced:
+ *   Fast      - normal mode, light oversampling, ~20 results/s, highest
+ *               current, for following quick changes (doors, lifts)
+ *   Balanced  - normal mode, 16x/2x oversampling, IIR 4, one result every
+ *               0.5 s from the sensor's own standby timer
+ *   Low power - forced mode: one 8x/1x conversion every 10 s, asleep in
+ *               between, IIR off (it would span minutes)
+ * pressurePoll() only touches the bus when the profile has a new result:
+ * in normal mode once per output period, in forced mode once to start a
+ * conversion and once to read it after the conversion time, without
+ * blocking in between.
+ */
+
+#include <stdint.h>
+
+class QMP6988;
+class TwoWire;
+
+enum PressureProfile : uint8_t {
+  PRESSURE_FAST = 0,
+  PRESSURE_BALANCED = 1,
+  PRESSURE_LOW_POWER = 2,
+  PRESSURE_PROFILE_COUNT
+};
+
+const char* pressureProfileName(PressureProfile profile);
+// Time between new results of a profile
+uint32_t pressureProfilePeriodMs(PressureProfile profile);
+
+// The sensor must already have been started with sensor.begin()
+void pressureBegin(QMP6988& sensor, TwoWire& wire, uint8_t address,
+                   PressureProfile profile, unsigned long nowMs);
+void pressureSetProfile(PressureProfile profile, unsigned long nowMs);
+// True when sensor.pressure holds a new result
+bool pressurePoll(unsigned long nowMs);
+// Bus operations so far (result reads and forced-mode starts)
+uint32_t pressureTransfers();
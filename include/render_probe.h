@@ -0,0 +1,62 @@
+#pragma once
+
+/*
+ * Render probe - headless draw target for measuring page rendering.
+ *
+ * CountingCanvas is an off-screen M5Canvas that counts the primitives and
+ * pixels written through it. Point the page draw functions at it instead of
+ * the panel to get per-page render cost, a CRC of the resulting image, and a
+ * binary PPM dump that tools/render_probe.py compares against golden images.
+ */
+
+#include <Arduino.h>
+#include <M5GFX.h>
+
+struct RenderStats {
+  uint32_t primitives;  // Top-level draw calls (one transaction each)
+  uint32_t pixels;      // Pixels written, including overdraw
+  uint32_t elapsedUs;   // Wall time spent drawing into the canvas
+  uint32_t crc;         // CRC-32 of the RGB888 image (same bytes as the PPM dump)
+};
+
+class CountingCanvas : public M5Canvas {
+ public:
+  explicit CountingCanvas(lgfx::LovyanGFX* parent = nullptr) : M5Canvas(parent) {}
+
+  void resetCounters() {
+    _primitives = 0;
+    _pixels = 0;
+  }
+  uint32_t primitives() const { return _primitives; }
+  uint32_t pixels() const { return _pixels; }
+
+ protected:
+  // Every high-level primitive opens exactly one transaction; pixels land
+  // through the two write hooks below. pushImage paths are not counted as
+  // none of the pages use them.
+  void beginTransaction() override {
+    _primitives++;
+    M5Canvas::beginTransaction();
+  }
+  void drawPixel_impl(uint_fast16_t x, uint_fast16_t y) override {
+    _pixels++;
+    M5Canvas::drawPixel_impl(x, y);
+  }
+  void writeFillRectPreclipped(int32_t x, int32_t y, int32_t w, int32_t h) override {
+    _pixels += w * h;
+    M5Canvas::writeFillRectPreclipped(x, y, w, h);
+  }
+
+ private:
+  uint32_t _primitives = 0;
+  uint32_t _pixels = 0;
+};
+
+// CRC-32 over the canvas contents as RGB888, row by row
+uint32_t renderProbeCrc(CountingCanvas& canvas);
+
+// One machine-readable line: "probe page=<name> prims=.. pixels=.. us=.. crc=.."
+void renderProbeReport(Print& out, const char* page, const RenderStats& stats);
+
+// "ppm <name> <bytes>\n" followed by a binary P6 image of the canvas
+void renderProbeDumpPpm(Print& out, const char* page, CountingCanvas& canvas);
@@ -0,0 +1,31 @@
+#pragma once
+
+/*
+ * SD card history log. Every history bin is appended to a per-day columnar
+ * log (/envlog/YYYYMMDD.ecl, UTC days, format in col_log.h) once the wall
+ * clock is valid; bins recorded before that are written as soon as it is.
+ * The previous day's file is closed with its footer index at midnight. A
+ * file whose index is full is closed and the day continues in
+ * /envlog/YYYYMMDD-1.ecl, -2 and so on.
+ */
+
+#include <stdint.h>
+
+void sdLogBegin();
+void sdLogPoll();
+bool sdLogReady();
+// Log blocks written to the card since boot
+uint32_t sdLogBlocksWritten();
+
+// "/envlog/YYYYMMDD.ecl" for the UTC day containing unixTime, or
+// "/envlog/YYYYMMDD-N.ecl" for its continuation file `part`
+void sdLogPath(char* buf, int size, uint32_t unixTime, int part = 0);
+
+// Samples of one metric in [t0, t1] (Unix time) across the daily files, in
+// time order, until fn returns false. Only the files for days in the range
+// (clipped to the days on the card) are opened, and each is entered through
+// its time index, so cost follows the window, not the log size. Samples not
+// yet written are read from the writer's buffers. Returns the samples fn
+// accepted.
+int sdLogQuery(uint8_t metric, uint32_t t0, uint32_t t1,
+               bool (*fn)(uint32_t time, float value, void* ctx), void* ctx);
@@ -0,0 +1,41 @@
+#pragma once
+
+/*
+ * On-device self-benchmark: display, I2C, storage and NVS throughput of
+ * the unit at hand (panels, sensors and SD cards vary between batches).
+ *
+ * Each part runs for well under a second and blocks while it does; the
+ * display part draws over the whole panel. Results are -1 where a part
+ * could not run (no SD card, no memory for the sprite, sensor missing).
+ * benchFormat() turns them into one "bench key=value ..." line, in the same
+ * style as the render probe.
+ */
+
+#include <FS.h>
+#include <M5GFX.h>
+
+class Sht30Bus;
+class TwoWire;
+
+struct BenchResults {
+  float fillMpixPerSec;    // Full-screen fills
+  float rectsPerSec;       // 8x8 filled rectangles
+  float linesPerSec;       // Short diagonal lines
+  float spritePushUs;      // Full-screen 16-bit sprite to the panel
+  float sht30Us;           // Status register read (command + 3 bytes)
+  float qmp6988Us;         // One-register read
+  float flashWriteKBps;    // LittleFS, sequential
+  float flashReadKBps;
+  float sdWriteKBps;       // SD card, sequential
+  float sdReadKBps;
+  float nvsCommitUs;       // Preferences put, committed
+};
+
+void benchDisplay(lgfx::LovyanGFX& panel, BenchResults& out);
+void benchI2c(Sht30Bus& sht30, TwoWire& wire, uint8_t qmpAddress, BenchResults& out);
+// Sequential write then read of a scratch file, removed afterwards
+void benchStorage(fs::FS& fs, uint32_t bytes, float& writeKBps, float& readKBps);
+void benchNvs(BenchResults& out);
+
+// Returns the length written (including the newline)
+int benchFormat(char* buf, int size, const BenchResults& r);
@@ -0,0 +1,134 @@
+#pragma once
+
+/*
+ * Serial command protocol - framed binary request/response over USB CDC.
+ *
+ * Frame (both directions, little-endian):
+ *   0xA5 | type u8 | len u16 | payload[len] | crc32 u32
+ * The CRC covers type, len and payload. Bytes outside a valid frame (e.g.
+ * log text) are skipped, so the protocol can share the port with logging.
+ *
+ * Requests and their responses:
+ *   CMD_GET_READING                      -> RSP_READING
+ *   CMD_DUMP_HISTORY {tier u8, t0 u32, t1 u32}
+ *                                        -> RSP_DUMP_BEGIN, RSP_DUMP_DATA..., RSP_DUMP_END
+ *   CMD_GET_STATS                        -> RSP_STATS
+ *   CMD_SET_SETTING {key u8, value i32}  -> RSP_SETTING {key u8, value i32}
+ *   CMD_SET_TIME {unixTime u32}          -> RSP_TIME {unixTime u32}
+ *   CMD_DUMP_TRACE                       -> RSP_TRACE_BEGIN {cpuMhz u16, count u16, recordSize u8},
+ *                                           RSP_TRACE_DATA..., RSP_TRACE_END {sent u16}
+ *   CMD_DUMP_SD {metric u8, t0 u32, t1 u32}
+ *                                        -> RSP_SD_BEGIN {metric u8, recordSize u8},
+ *                                           RSP_SD_DATA..., RSP_SD_END {sent u32}
+ * Any request can instead get RSP_ERROR {code u8}.
+ *
+ * History dumps copy records straight from the ring buffers into
+ * RSP_DUMP_DATA frames, up to 4 frames per protoPoll() call. Each frame is
+ * written as far as the port has room; the rest is kept and drained on the
+ * following calls, and no new frame is started until it is out (txIdle()),
+ * so a large dump never stalls loop(). There is one record per temperature
+ * bin; humidity and pressure are the latest of their own (coarser or equal)
+ * bins at that time. Trace dumps stream the trace ring (TraceEvent records,
+ * trace.h) the same way, with recording paused until the dump ends. SD
+ * dumps read one frame of one metric's samples from the SD log per call
+ * (ProtoSdRecord, Unix time); each read enters the day's file through its
+ * time index.
+ */
+
+#include <Arduino.h>
+#include "history.h"
+
+const uint8_t PROTO_SYNC = 0xA5;
+const uint16_t PROTO_MAX_PAYLOAD = 256;
+
+enum ProtoType : uint8_t {
+  CMD_GET_READING = 0x01,
+  CMD_DUMP_HISTORY = 0x02,
+  CMD_GET_STATS = 0x03,
+  CMD_SET_SETTING = 0x04,
+  CMD_SET_TIME = 0x05,
+  CMD_DUMP_TRACE = 0x06,
+  CMD_DUMP_SD = 0x07,
+
+  RSP_READING = 0x81,
+  RSP_DUMP_BEGIN = 0x82,
+  RSP_DUMP_DATA = 0x83,
+  RSP_DUMP_END = 0x84,
+  RSP_STATS = 0x85,
+  RSP_SETTING = 0x86,
+  RSP_TIME = 0x87,
+  RSP_TRACE_BEGIN = 0x88,
+  RSP_TRACE_DATA = 0x89,
+  RSP_TRACE_END = 0x8A,
+  RSP_SD_BEGIN = 0x8B,
+  RSP_SD_DATA = 0x8C,
+  RSP_SD_END = 0x8D,
+  RSP_ERROR = 0xFF
+};
+
+enum ProtoError : uint8_t {
+  PROTO_ERR_UNKNOWN_CMD = 1,
+  PROTO_ERR_BAD_LENGTH = 2,
+  PROTO_ERR_BAD_TIER = 3,
+  PROTO_ERR_BAD_SETTING = 4,
+  PROTO_ERR_BUSY = 5,
+  PROTO_ERR_BAD_TIME = 6,
+  PROTO_ERR_NO_TRACE = 7,  // Built without ENABLE_TRACE
+  PROTO_ERR_NO_SD = 8,     // No card, or the clock is not set
+  PROTO_ERR_BAD_METRIC = 9
+};
+
+enum ProtoSetting : uint8_t {
+  SETTING_BRIGHTNESS = 1,      // 20..100
+  SETTING_FAHRENHEIT = 2,      // 0 = C, 1 = F
+  SETTING_SCREEN_TIMEOUT = 3,  // 0 = 10s, 1 = 30s, 2 = Always On
+  SETTING_SMOOTHING = 4,       // SmoothMode: 0 = off, 1 = EMA, 2 = Kalman
+  SETTING_SMOOTH_TIME = 5,     // Time constant: 0 = 10s, 1 = 30s, 2 = 2 min
+  SETTING_PRESSURE_PROFILE = 6 // PressureProfile: 0 = fast, 1 = balanced, 2 = low power
+};
+
+// History record as sent in RSP_DUMP_DATA (packed, 16 bytes)
+struct __attribute__((packed)) ProtoHistoryRecord {
+  uint32_t time;  // Seconds since boot
+  float temp;
+  float humidity;
+  float pressure;
+};
+
+// SD log sample as sent in RSP_SD_DATA (packed, 8 bytes)
+struct __attribute__((packed)) ProtoSdRecord {
+  uint32_t time;  // Unix time
+  float value;
+};
+
+struct __attribute__((packed)) ProtoReading {
+  uint32_t uptime;  // Seconds since boot
+  float temp;
+  float humidity;
+  float pressure;
+  int8_t battery;   // Percent
+  uint8_t charging;
+};
+
+struct __attribute__((packed)) ProtoStats {
+  uint32_t uptime;
+  uint32_t freeHeap;
+  uint16_t historyCount;  // Temperature ring
+  uint32_t historySeq;
+  uint32_t rxFrames;
+  uint32_t rxErrors;
+  uint32_t txFrames;
+  uint32_t logDropped;
+};
+
+// Implemented by the application
+void protoFillReading(ProtoReading& reading);
+bool protoApplySetting(uint8_t key, int32_t value);
+
+void protoBegin(Stream& port);
+// Parse pending input and advance any running dump; never blocks
+void protoPoll();
+bool protoBusy();  // True while a history or trace dump is being streamed
+// True while a frame is only partly written; other output must wait
+bool protoTxPending();
+void protoFillStats(ProtoStats& stats);
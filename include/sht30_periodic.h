@@ -0,0 +1,116 @@
+#pragma once
+
+/*
+ * SHT30 driver for periodic acquisition mode.
+ *
+ * The sensor is started once in periodic mode (0.5 to 10 measurements per
+ * second, high repeatability, or 4 Hz with ART, its accelerated response
+ * time). It then measures on its own, and a reading is a single FETCH DATA
+ * command plus a 6-byte read, with no conversion wait on the bus. poll()
+ * only talks to the sensor once a measurement period has passed since the
+ * last sample. A fetch before the next result is ready is NACKed and
+ * retried on a later poll. A sensor whose fetches keep failing for several
+ * periods (e.g. unplugged and replugged) is stopped and started again.
+ *
+ * The bus is behind Sht30Bus, so the driver can run against the simulated
+ * sensor below on the host.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+class TwoWire;
+
+const uint8_t sht30DefaultAddress = 0x44;
+
+// Measurements per second, high repeatability
+enum Sht30Rate : uint8_t {
+  SHT30_MPS_0_5 = 0,
+  SHT30_MPS_1,
+  SHT30_MPS_2,
+  SHT30_MPS_4,
+  SHT30_MPS_10,
+  SHT30_ART,  // 4 Hz with accelerated response time
+  SHT30_RATE_COUNT
+};
+
+// Start command and measurement period of a rate
+uint16_t sht30RateCommand(Sht30Rate rate);
+uint32_t sht30RatePeriodMs(Sht30Rate rate);
+// Sensirion CRC-8 (poly 0x31, init 0xFF) over one data word
+uint8_t sht30Crc(const uint8_t* data, size_t len);
+
+class Sht30Bus {
+ public:
+  virtual ~Sht30Bus() {}
+  // Send a 16-bit command; false if not acknowledged
+  virtual bool command(uint16_t cmd) = 0;
+  // Read len bytes; false if the read header was NACKed
+  virtual bool read(uint8_t* buf, size_t len) = 0;
+};
+
+class Sht30WireBus : public Sht30Bus {
+ public:
+  Sht30WireBus(TwoWire& wire, uint8_t address = sht30DefaultAddress)
+      : _wire(wire), _address(address) {}
+  bool command(uint16_t cmd) override;
+  bool read(uint8_t* buf, size_t len) override;
+
+ private:
+  TwoWire& _wire;
+  uint8_t _address;
+};
+
+struct Sht30Stats {
+  uint32_t samples;    // Good readings
+  uint32_t notReady;   // Fetches NACKed because no new result was ready
+  uint32_t crcErrors;
+  uint32_t restarts;   // Periodic mode restarted after a silent spell
+  uint32_t transfers;  // I2C transactions (commands and reads)
+};
+
+class Sht30Periodic {
+ public:
+  bool begin(Sht30Bus& bus, Sht30Rate rate, unsigned long nowMs);
+  // Fetch a new result if one is due; true when cTemp/humidity were updated
+  bool poll(unsigned long nowMs);
+  void stop();
+
+  float cTemp = 0;
+  float humidity = 0;
+  const Sht30Stats& stats() const { return _stats; }
+
+ private:
+  bool start(unsigned long nowMs);
+  bool command(uint16_t cmd);
+
+  Sht30Bus* _bus = nullptr;
+  Sht30Rate _rate = SHT30_MPS_1;
+  uint32_t _periodMs = 1000;
+  unsigned long _lastSampleMs = 0;
+  unsigned long _failSinceMs = 0;  // Start of the current run of failed fetches
+  bool _failing = false;
+  Sht30Stats _stats = {0, 0, 0, 0, 0};
+};
+
+// Simulated sensor on a simulated bus: follows the periodic-mode command
+// set, produces a result every period of the started rate (by the clock
+// in nowMs, advanced by the caller) and NACKs fetches in between.
+class Sht30SimBus : public Sht30Bus {
+ public:
+  bool command(uint16_t cmd) override;
+  bool read(uint8_t* buf, size_t len) override;
+
+  unsigned long nowMs = 0;
+  float temperature = 21.5f;  // Values the next measurement will report
+  float humidity = 45.0f;
+  bool corrupt = false;       // Flip a bit of the next result
+  bool present = true;        // Unplugged: nothing is acknowledged
+
+ private:
+  bool _periodic = false;
+  bool _fetchPending = false;
+  uint32_t _periodMs = 0;
+  unsigned long _startMs = 0;
+  unsigned long _lastFetchedMs = 0;  // Time of the last result handed out
+};
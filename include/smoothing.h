@@ -0,0 +1,35 @@
+#pragma once
+
+/*
+ * Smoothing stage between the sensors and everything downstream (display,
+ * history, exports), per metric.
+ *
+ * Each metric runs a bank of exponential moving averages with different
+ * time constants and a scalar Kalman filter (random-walk model), all
+ * updated on every reading in O(1) with static state. The configured mode
+ * picks which one is passed on. The Kalman process noise is derived from
+ * the chosen time constant, so in steady state it follows like the EMA of
+ * that time constant, but it converges from the first reading within a
+ * few samples instead of creeping up from it.
+ */
+
+#include <stdint.h>
+#include "history.h"
+
+enum SmoothMode : uint8_t {
+  SMOOTH_OFF = 0,
+  SMOOTH_EMA = 1,
+  SMOOTH_KALMAN = 2,
+  SMOOTH_MODE_COUNT
+};
+
+const int smoothTauCount = 3;
+extern const float smoothTaus[smoothTauCount];  // Seconds: 10, 30, 120
+
+void smoothConfigure(SmoothMode mode, int tauIndex);
+// Feed a raw reading taken at nowMs; returns the value to pass on
+float smoothUpdate(Metric metric, float raw, unsigned long nowMs);
+// Current output of one EMA of the bank
+float smoothEma(Metric metric, int tauIndex);
+// Start over from the next reading (e.g. after a sensor restart)
+void smoothReset();
@@ -0,0 +1,103 @@
+#pragma once
+
+/*
+ * Firmware trace points (build with -DENABLE_TRACE=1).
+ *
+ * TRACE_BEGIN(id) / TRACE_END(id), or TRACE_SCOPE(id) for a whole block,
+ * write a CPU cycle-counter timestamp and the event id into a fixed RAM
+ * ring of TRACE_RING_SIZE events; the oldest are overwritten. A trace
+ * point is a register read and two stores into the ring, inlined. With
+ * tracing disabled the macros expand to nothing.
+ *
+ * The ring is pulled over the serial protocol (CMD_DUMP_TRACE) and turned
+ * into Chrome trace JSON for Perfetto by tools/trace2chrome.py, which
+ * keeps its own copy of the id names below.
+ */
+
+#include <stdint.h>
+#include "config.h"
+
+// Keep in step with NAMES in tools/trace2chrome.py
+enum TraceId : uint8_t {
+  TRACE_LOOP = 0,
+  TRACE_KEYBOARD,
+  TRACE_SENSORS,
+  TRACE_HISTORY,
+  TRACE_BATTERY,
+  TRACE_DRAW_MAIN,
+  TRACE_UPDATE_MAIN,
+  TRACE_DRAW_GRAPH,
+  TRACE_UPDATE_GRAPH,
+  TRACE_DRAW_SETTINGS,
+  TRACE_DRAW_YEAR,
+  TRACE_DRAW_WEEK,
+  TRACE_DRAW_DENSITY,
+  TRACE_DRAW_DIAG,
+  TRACE_UPDATE_DIAG,
+  TRACE_ID_COUNT
+};
+
+enum TracePhase : uint8_t {
+  TRACE_PHASE_BEGIN = 0,
+  TRACE_PHASE_END = 1
+};
+
+// As stored in the ring and sent in RSP_TRACE_DATA (8 bytes)
+struct __attribute__((packed)) TraceEvent {
+  uint32_t cycles;
+  uint8_t id;
+  uint8_t phase;
+  uint16_t reserved;
+};
+
+// Stops recording while the ring is being read out
+void tracePause(bool paused);
+// Events held, and the ring position of the oldest
+uint32_t traceSnapshot(uint32_t& first);
+const TraceEvent& traceEventAt(uint32_t pos);
+
+#if ENABLE_TRACE
+
+static_assert((TRACE_RING_SIZE & (TRACE_RING_SIZE - 1)) == 0, "TRACE_RING_SIZE must be a power of two");
+
+extern TraceEvent traceRing[TRACE_RING_SIZE];
+extern uint32_t traceHead;
+extern bool tracePaused;
+
+static inline uint32_t traceCycles() {
+#if defined(__XTENSA__)
+  uint32_t ccount;
+  __asm__ __volatile__("rsr %0, ccount" : "=a"(ccount));
+  return ccount;
+#else
+  return 0;
+#endif
+}
+
+static inline void traceRecord(uint8_t id, uint8_t phase) {
+  if (tracePaused) return;
+  TraceEvent& e = traceRing[traceHead++ & (TRACE_RING_SIZE - 1)];
+  e.cycles = traceCycles();
+  e.id = id;
+  e.phase = phase;
+}
+
+struct TraceScope {
+  uint8_t id;
+  explicit TraceScope(uint8_t traceId) : id(traceId) { traceRecord(id, TRACE_PHASE_BEGIN); }
+  ~TraceScope() { traceRecord(id, TRACE_PHASE_END); }
+};
+
+#define TRACE_BEGIN(id) traceRecord((id), TRACE_PHASE_BEGIN)
+#define TRACE_END(id) traceRecord((id), TRACE_PHASE_END)
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(id) TraceScope TRACE_CONCAT(traceScope_, __LINE__)(id)
+
+#else
+
+#define TRACE_BEGIN(id)
+#define TRACE_END(id)
+#define TRACE_SCOPE(id)
+
+#endif
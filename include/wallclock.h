@@ -0,0 +1,25 @@
+#pragma once
+
+/*
+ * Wall clock. The Cardputer has no RTC, so real time is only known once it
+ * has been set (NTP while Wi-Fi is up). Until then clockValid() is false and
+ * history keeps using seconds since boot.
+ *
+ * Local time follows TIME_ZONE (config.h); day numbers count local days
+ * since 1970-01-01, so consecutive days always differ by one.
+ */
+
+#include <stdint.h>
+#include <time.h>
+
+bool clockValid();
+uint32_t clockNow();  // Unix time, 0 if not valid
+void clockSet(uint32_t unixTime);
+
+// Unix time of a seconds-since-boot timestamp, 0 if the clock is not valid
+uint32_t clockFromUptime(uint32_t uptimeSec);
+
+// Broken-down local time of a Unix time
+void clockLocal(uint32_t unixTime, struct tm& tm);
+// Local day number of a Unix time
+uint32_t clockLocalDay(uint32_t unixTime);
@@ -0,0 +1,27 @@
+#pragma once
+
+/*
+ * Hour-of-day x day-of-week accumulators (24 x 7 cells per metric) for the
+ * week heatmap page.
+ *
+ * Every history sample adds to the running sum and count of the cell of its
+ * local weekday and hour: O(1) per sample, and drawing the page only reads
+ * the 168 cached cell means. A cell that reaches heatmapCellMax samples has
+ * its sum and count halved, so old weeks gradually fade out. The grid is
+ * saved to flash whenever the hour changes and reloaded at boot.
+ */
+
+#include <stdint.h>
+#include "history.h"
+
+const int heatmapDays = 7;
+const int heatmapHours = 24;
+const uint16_t heatmapCellMax = 600;  // ~10 weeks of 1/min samples
+
+bool heatmapBegin();
+void heatmapAdd(uint32_t unixTime, float temp, float humidity, float pressure);
+
+// Mean of a cell; day 0 = Monday. False if the cell has no samples.
+bool heatmapCell(Metric metric, int day, int hour, float& mean);
+// Lowest and highest cell mean; false if the grid is empty
+bool heatmapRange(Metric metric, float& lo, float& hi);
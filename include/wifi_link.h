@@ -0,0 +1,20 @@
+#pragma once
+
+/*
+ * Shared Wi-Fi link. Features that need the network hold a reference while
+ * they use it; the radio is powered up on the first wifiAcquire() and off
+ * again when the last holder calls wifiRelease(). The first successful
+ * connection also starts NTP so the wall clock becomes valid.
+ */
+
+enum WifiLinkState {
+  WIFI_LINK_OFF,
+  WIFI_LINK_CONNECTING,
+  WIFI_LINK_UP,
+  WIFI_LINK_FAILED  // Timed out; stays off until all holders release
+};
+
+void wifiAcquire();
+void wifiRelease();
+void wifiPoll();
+WifiLinkState wifiState();
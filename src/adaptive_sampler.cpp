@@ -0,0 +1,62 @@
+#include "adaptive_sampler.h"
+
+// Change between readings that is worth catching, per metric
+static const float tolerance[METRIC_COUNT] = {
+  0.1f,  // deg C
+  0.5f,  // %RH
+  0.2f,  // hPa
+};
+
+// EWMA weight of the newest squared change
+static const float varianceAlpha = 0.3f;
+
+struct SamplerState {
+  bool primed;
+  float last;
+  float meanSquare;  // EWMA of the squared change between readings
+  uint32_t intervalMs;
+  uint32_t minMs;
+  uint32_t maxMs;
+};
+
+static SamplerState states[METRIC_COUNT];
+
+void samplerSetBounds(Metric metric, uint32_t minIntervalMs, uint32_t maxIntervalMs) {
+  SamplerState& s = states[metric];
+  s.minMs = minIntervalMs;
+  s.maxMs = maxIntervalMs > minIntervalMs ? maxIntervalMs : minIntervalMs;
+  s.primed = false;
+  s.intervalMs = s.minMs;
+}
+
+void samplerAdd(Metric metric, float value) {
+  SamplerState& s = states[metric];
+  if (!s.primed) {
+    s.primed = true;
+    s.last = value;
+    s.meanSquare = 0;
+    s.intervalMs = s.minMs;
+    return;
+  }
+
+  float change = value - s.last;
+  s.last = value;
+  s.meanSquare += varianceAlpha * (change * change - s.meanSquare);
+  float absChange = change < 0 ? -change : change;
+  float tol = tolerance[metric];
+
+  if (absChange > tol) {
+    s.intervalMs = s.minMs;
+    s.meanSquare = tol * tol;  // Stay fast until things settle again
+  } else if (absChange > tol / 2) {
+    s.intervalMs /= 2;
+  } else if (s.meanSquare < (tol / 2) * (tol / 2)) {
+    s.intervalMs += s.intervalMs / 2;
+  }
+  if (s.intervalMs < s.minMs) s.intervalMs = s.minMs;
+  if (s.intervalMs > s.maxMs) s.intervalMs = s.maxMs;
+}
+
+uint32_t samplerIntervalMs(Metric metric) {
+  return states[metric].intervalMs;
+}
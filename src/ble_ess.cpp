@@ -0,0 +1,252 @@
+#include "ble_ess.h"
+#include "config.h"
+
+#if ENABLE_BLE
+
+#include <BLE2902.h>
+#include <BLEDevice.h>
+#include "ess_codec.h"
+#include "history.h"
+#include "log_sink.h"
+#include "wallclock.h"
+
+#define HISTORY_SERVICE_UUID "6b1d0001-4c6f-4e9a-9a0e-43617264454e"
+#define HISTORY_CONTROL_UUID "6b1d0002-4c6f-4e9a-9a0e-43617264454e"
+#define HISTORY_DATA_UUID "6b1d0003-4c6f-4e9a-9a0e-43617264454e"
+#define HISTORY_BOOT_TIME_UUID "6b1d0004-4c6f-4e9a-9a0e-43617264454e"
+
+// Connection parameters in 1.25 ms units; supervision timeout in 10 ms units
+const uint16_t slowIntervalMin = 400;  // 500 ms
+const uint16_t slowIntervalMax = 800;  // 1 s
+const uint16_t slowLatency = 4;
+const uint16_t fastIntervalMin = 12;   // 15 ms, only while history streams
+const uint16_t fastIntervalMax = 24;   // 30 ms
+const uint16_t supervisionTimeout = 600;  // 6 s
+const int chunksPerPoll = 4;
+
+static BLEServer* server = nullptr;
+static BLECharacteristic* tempChar = nullptr;
+static BLECharacteristic* humidChar = nullptr;
+static BLECharacteristic* pressChar = nullptr;
+static BLECharacteristic* historyData = nullptr;
+static BLECharacteristic* bootTimeChar = nullptr;
+
+static volatile bool connected = false;
+static volatile uint16_t peerMtu = 23;
+static esp_bd_addr_t peerAddr;
+
+static float lastTemp = NAN;
+static float lastHumidity = NAN;
+static float lastPressure = NAN;
+static unsigned long lastNotify = 0;
+
+// History transfer, requested from the BLE task and run from blePoll()
+static volatile bool historyRequested = false;
+static volatile uint32_t historyFrom = 0;
+static bool historyActive = false;
+static uint32_t historyNextSeq = 0;
+static uint16_t historyChunkSeq = 0;
+
+// Set from the BLE task: the stack's TX queue for the link is full
+static volatile bool congested = false;
+// Outcome of the last history notify(), reported synchronously by onStatus
+static bool historyNotifyOk = false;
+static bool historyNotifyRefused = false;
+
+static void setConnParams(bool fast) {
+  if (!connected) return;
+  if (fast) {
+    server->updateConnParams(peerAddr, fastIntervalMin, fastIntervalMax, 0, supervisionTimeout);
+  } else {
+    server->updateConnParams(peerAddr, slowIntervalMin, slowIntervalMax, slowLatency, supervisionTimeout);
+  }
+}
+
+class ServerCallbacks : public BLEServerCallbacks {
+  void onConnect(BLEServer* s, esp_ble_gatts_cb_param_t* param) override {
+    memcpy(peerAddr, param->connect.remote_bda, sizeof(esp_bd_addr_t));
+    connected = true;
+    setConnParams(false);
+  }
+  void onDisconnect(BLEServer* s) override {
+    connected = false;
+    congested = false;
+    peerMtu = 23;
+    historyRequested = false;
+    BLEDevice::startAdvertising();
+  }
+  void onMtuChanged(BLEServer* s, esp_ble_gatts_cb_param_t* param) override {
+    peerMtu = param->mtu.mtu;
+  }
+};
+
+class HistoryControlCallbacks : public BLECharacteristicCallbacks {
+  void onWrite(BLECharacteristic* c) override {
+    if (c->getLength() < 4) return;
+    uint8_t* p = c->getData();
+    historyFrom = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+    historyRequested = true;
+  }
+};
+
+class HistoryDataCallbacks : public BLECharacteristicCallbacks {
+  void onStatus(BLECharacteristic* c, Status s, uint32_t code) override {
+    historyNotifyOk = s == SUCCESS_NOTIFY;
+    // Notifications off or nobody there: retrying will not help
+    historyNotifyRefused = s == ERROR_NOTIFY_DISABLED || s == ERROR_NO_CLIENT;
+  }
+};
+
+static void gattsEvent(esp_gatts_cb_event_t event, esp_gatt_if_t gattsIf, esp_ble_gatts_cb_param_t* param) {
+  if (event == ESP_GATTS_CONGEST_EVT) congested = param->congest.congested;
+}
+
+static BLECharacteristic* addNotifyChar(BLEService* service, uint16_t uuid) {
+  BLECharacteristic* c = service->createCharacteristic(
+      BLEUUID(uuid), BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_NOTIFY);
+  c->addDescriptor(new BLE2902());
+  return c;
+}
+
+static void notifyReadings(float temp, float humidity, float pressure) {
+  int16_t t = essEncodeTemperature(temp);
+  uint16_t h = essEncodeHumidity(humidity);
+  uint32_t p = essEncodePressure(pressure);
+  tempChar->setValue((uint8_t*)&t, sizeof(t));
+  humidChar->setValue((uint8_t*)&h, sizeof(h));
+  pressChar->setValue((uint8_t*)&p, sizeof(p));
+  if (!connected) return;
+
+  // One round: every metric past its threshold goes out together
+  if (essCrossed(temp, lastTemp, BLE_TEMP_THRESHOLD) || isnan(lastTemp)) {
+    tempChar->notify();
+    lastTemp = temp;
+  }
+  if (essCrossed(humidity, lastHumidity, BLE_HUMIDITY_THRESHOLD) || isnan(lastHumidity)) {
+    humidChar->notify();
+    lastHumidity = humidity;
+  }
+  if (essCrossed(pressure, lastPressure, BLE_PRESSURE_THRESHOLD) || isnan(lastPressure)) {
+    pressChar->notify();
+    lastPressure = pressure;
+  }
+}
+
+static void endHistory() {
+  historyActive = false;
+  setConnParams(false);
+}
+
+// Chunks go out one at a time while the stack accepts them. A chunk that
+// fails, or finds the link congested, is built again on the next poll.
+static void streamHistory() {
+  uint8_t chunk[512];
+  size_t perChunk = essRecordsPerChunk(peerMtu);
+  if (perChunk > (sizeof(chunk) - essChunkHeaderSize) / essRecordSize) {
+    perChunk = (sizeof(chunk) - essChunkHeaderSize) / essRecordSize;
+  }
+
+  for (int c = 0; c < chunksPerPoll && historyActive && !congested; c++) {
+    uint32_t oldestSeq = historySeq(METRIC_TEMP) - historyCount(METRIC_TEMP);
+    if (historyNextSeq < oldestSeq) historyNextSeq = oldestSeq;
+
+    uint32_t seq = historyNextSeq;
+    size_t n = 0;
+    uint8_t* out = chunk + essChunkHeaderSize;
+    while (n < perChunk && seq < historySeq(METRIC_TEMP)) {
+      int i = seq - oldestSeq;
+      uint32_t t = historyTime(METRIC_TEMP, i);
+      essPutRecord(out, t, historyValue(METRIC_TEMP, i),
+                   historyValueAt(METRIC_HUMIDITY, t), historyValueAt(METRIC_PRESSURE, t));
+      out += essRecordSize;
+      n++;
+      seq++;
+    }
+    bool last = seq >= historySeq(METRIC_TEMP);
+    essPutChunkHeader(chunk, historyChunkSeq, last);
+    historyData->setValue(chunk, essChunkHeaderSize + n * essRecordSize);
+    historyNotifyOk = false;
+    historyNotifyRefused = false;
+    historyData->notify();
+    if (historyNotifyRefused) {
+      endHistory();
+      return;
+    }
+    if (!historyNotifyOk) return;
+
+    historyNextSeq = seq;
+    historyChunkSeq++;
+    if (last) endHistory();
+  }
+}
+
+// Unix time at boot, 0 until the clock is set
+static void updateBootTime() {
+  uint32_t bootTime = clockValid() ? clockFromUptime(0) : 0;
+  bootTimeChar->setValue((uint8_t*)&bootTime, sizeof(bootTime));
+}
+
+void bleBegin() {
+  BLEDevice::init(BLE_DEVICE_NAME);
+  BLEDevice::setMTU(247);
+  BLEDevice::setCustomGattsHandler(gattsEvent);
+  server = BLEDevice::createServer();
+  server->setCallbacks(new ServerCallbacks());
+
+  BLEService* ess = server->createService(BLEUUID((uint16_t)0x181A));
+  tempChar = addNotifyChar(ess, 0x2A6E);
+  humidChar = addNotifyChar(ess, 0x2A6F);
+  pressChar = addNotifyChar(ess, 0x2A6D);
+  ess->start();
+
+  BLEService* hist = server->createService(BLEUUID(HISTORY_SERVICE_UUID));
+  BLECharacteristic* control = hist->createCharacteristic(
+      BLEUUID(HISTORY_CONTROL_UUID), BLECharacteristic::PROPERTY_WRITE);
+  control->setCallbacks(new HistoryControlCallbacks());
+  historyData = hist->createCharacteristic(BLEUUID(HISTORY_DATA_UUID), BLECharacteristic::PROPERTY_NOTIFY);
+  historyData->addDescriptor(new BLE2902());
+  historyData->setCallbacks(new HistoryDataCallbacks());
+  bootTimeChar = hist->createCharacteristic(BLEUUID(HISTORY_BOOT_TIME_UUID), BLECharacteristic::PROPERTY_READ);
+  updateBootTime();
+  hist->start();
+
+  BLEAdvertising* adv = BLEDevice::getAdvertising();
+  adv->addServiceUUID(BLEUUID((uint16_t)0x181A));
+  adv->setMinInterval(1600);  // 1 s, in 0.625 ms units
+  adv->setMaxInterval(3200);  // 2 s
+  BLEDevice::startAdvertising();
+  logPrintln("BLE ESS advertising");
+}
+
+void blePoll(float temp, float humidity, float pressure) {
+  if (!server) return;
+
+  if (historyRequested) {
+    historyRequested = false;
+    historyNextSeq = historySeq(METRIC_TEMP) - historyCount(METRIC_TEMP) + historyFind(METRIC_TEMP, historyFrom);
+    historyChunkSeq = 0;
+    historyActive = true;
+    setConnParams(true);
+  }
+  if (historyActive) {
+    if (connected) {
+      streamHistory();
+    } else {
+      historyActive = false;
+    }
+  }
+
+  unsigned long now = millis();
+  if (now - lastNotify >= BLE_NOTIFY_MIN_INTERVAL_MS) {
+    lastNotify = now;
+    updateBootTime();
+    notifyReadings(temp, humidity, pressure);
+  }
+}
+
+#else
+
+void bleBegin() {}
+void blePoll(float, float, float) {}
+
+#endif
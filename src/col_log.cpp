@@ -0,0 +1,550 @@
+#include "col_log.h"
+#include "crc32.h"
+
+const uint32_t fileMagic = 0x314C4345;    // "ECL1"
+const uint32_t blockMagic = 0x314B4C42;   // "BLK1"
+const uint32_t indexMagic = 0x31584449;   // "IDX1"
+const uint32_t trailerMagic = 0x464C4345; // "ECLF"
+const uint32_t indexFileMagic = 0x31584945; // "EIX1"
+const uint16_t formatVersion = 2;
+
+struct __attribute__((packed)) FileHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t blockCapacity;
+};
+
+struct __attribute__((packed)) BlockHeader {
+  uint32_t magic;
+  uint8_t series;
+  uint8_t reserved;
+  uint16_t count;
+  uint32_t seq;    // Block number within the file, never reused
+  uint32_t tMin;
+  uint32_t tMax;
+  float vMin;
+  float vMax;
+  uint32_t crc;    // Over this header (crc = 0) and both columns
+};
+
+struct __attribute__((packed)) Trailer {
+  uint32_t footerOffset;
+  uint32_t magic;
+};
+
+//----------------------------------------------------------
+// Zone loading
+//----------------------------------------------------------
+
+static bool readAt(File& f, uint32_t offset, void* buf, size_t len) {
+  return f.seek(offset) && f.read((uint8_t*)buf, len) == len;
+}
+
+static int loadFromFooter(File& f, ColLogZone* zones, int maxZones) {
+  uint32_t size = f.size();
+  Trailer t;
+  if (size < sizeof(FileHeader) + sizeof(Trailer) ||
+      !readAt(f, size - sizeof(Trailer), &t, sizeof(t)) || t.magic != trailerMagic) {
+    return -1;
+  }
+  uint32_t head[2];
+  if (!readAt(f, t.footerOffset, head, sizeof(head)) || head[0] != indexMagic) return -1;
+  uint32_t n = head[1];
+  if (n > (uint32_t)maxZones ||
+      t.footerOffset + sizeof(head) + n * sizeof(ColLogZone) + sizeof(Trailer) != size) {
+    return -1;
+  }
+  if (n > 0 && f.read((uint8_t*)zones, n * sizeof(ColLogZone)) != n * sizeof(ColLogZone)) return -1;
+  return n;
+}
+
+static uint32_t blockSize(const BlockHeader& h) {
+  return sizeof(BlockHeader) + h.count * 8;
+}
+
+static uint32_t headerCrc(const BlockHeader& h) {
+  BlockHeader c = h;
+  c.crc = 0;
+  return crc32(&c, sizeof(c));
+}
+
+// Check the header fields and the CRC of the block at pos; expects the
+// file positioned just after its header
+static bool blockValid(File& f, uint32_t pos, const BlockHeader& h) {
+  static uint8_t payload[colLogBlockCapacity * 8];
+  if (h.magic != blockMagic || h.count == 0 || h.count > colLogBlockCapacity ||
+      pos + blockSize(h) > f.size() || f.read(payload, h.count * 8) != h.count * 8u) {
+    return false;
+  }
+  return crc32Update(headerCrc(h), payload, h.count * 8) == h.crc;
+}
+
+// Offset of the next block or footer magic at or after pos, or the file
+// size if there is none
+static uint32_t findMagic(File& f, uint32_t pos) {
+  uint32_t size = f.size();
+  uint8_t buf[256];
+  while (pos + 4 <= size) {
+    uint32_t n = size - pos;
+    if (n > sizeof(buf)) n = sizeof(buf);
+    if (!readAt(f, pos, buf, n)) break;
+    for (uint32_t i = 0; i + 4 <= n; i++) {
+      uint32_t word;
+      memcpy(&word, buf + i, 4);
+      if (word == blockMagic || word == indexMagic) return pos + i;
+    }
+    pos += n - 3;
+  }
+  return size;
+}
+
+// Find the next intact block at or after pos with a seq of at least minSeq,
+// skipping footers left by earlier closes. Torn or stale bytes (a block cut
+// short by power loss, and anything written after it) are stepped over by
+// searching for the next block magic. False at the end of the file.
+static bool nextBlock(File& f, uint32_t& pos, BlockHeader& h, uint32_t minSeq = 0) {
+  uint32_t size = f.size();
+  while (pos + sizeof(BlockHeader) <= size) {
+    if (!readAt(f, pos, &h, sizeof(h))) return false;
+    if (h.magic == indexMagic) {
+      uint32_t entries;
+      memcpy(&entries, (uint8_t*)&h + 4, 4);
+      uint32_t footerSize = 8 + entries * sizeof(ColLogZone) + sizeof(Trailer);
+      if (entries <= (uint32_t)colLogZoneMax && pos + footerSize <= size) {
+        pos += footerSize;
+        continue;
+      }
+    } else if (h.seq >= minSeq && blockValid(f, pos, h)) {
+      return true;
+    }
+    pos = findMagic(f, pos + 1);
+  }
+  return false;
+}
+
+static int loadByScan(File& f, ColLogZone* zones, int maxZones) {
+  uint32_t pos = sizeof(FileHeader);
+  int n = 0;
+  BlockHeader h;
+  while (n < maxZones && nextBlock(f, pos, h)) {
+    zones[n].offset = pos;
+    zones[n].series = h.series;
+    zones[n].count = h.count;
+    zones[n].tMin = h.tMin;
+    zones[n].tMax = h.tMax;
+    zones[n].vMin = h.vMin;
+    zones[n].vMax = h.vMax;
+    n++;
+    pos += blockSize(h);
+  }
+  return n;
+}
+
+int colLogLoadZones(File& f, ColLogZone* zones, int maxZones) {
+  FileHeader h;
+  if (!readAt(f, 0, &h, sizeof(h)) || h.magic != fileMagic || h.version != formatVersion) {
+    return -1;
+  }
+  int n = loadFromFooter(f, zones, maxZones);
+  return n >= 0 ? n : loadByScan(f, zones, maxZones);
+}
+
+//----------------------------------------------------------
+// Time index
+//----------------------------------------------------------
+
+void colLogIndexPath(char* buf, int size, const char* logPath) {
+  snprintf(buf, size, "%s", logPath);
+  char* dot = strrchr(buf, '.');
+  if (dot && (dot - buf) + 4 < size) strcpy(dot, ".idx");
+}
+
+static bool readIndexEntry(File& idx, int i, ColLogIndexEntry& e) {
+  return readAt(idx, 4 + i * sizeof(ColLogIndexEntry), &e, sizeof(e));
+}
+
+// True if the block an index entry points at is intact
+static bool entryValid(File& log, const ColLogIndexEntry& e, BlockHeader& h) {
+  return readAt(log, e.offset, &h, sizeof(h)) && h.series == e.series && h.count == e.count &&
+         blockValid(log, e.offset, h);
+}
+
+int colLogEnsureIndex(fs::FS& fs, const char* logPath, ColLogRecovery* recovery) {
+  char idxPath[48];
+  colLogIndexPath(idxPath, sizeof(idxPath), logPath);
+  File log = fs.open(logPath, "r");
+  if (!log) return -1;
+  FileHeader fh;
+  if (!readAt(log, 0, &fh, sizeof(fh)) || fh.magic != fileMagic || fh.version != formatVersion) {
+    log.close();
+    return -1;
+  }
+
+  File idx = fs.open(idxPath, "r");
+  int entries = 0;
+  bool exact = false;
+  uint32_t magic;
+  if (idx && idx.size() >= 4 && readAt(idx, 0, &magic, 4) && magic == indexFileMagic) {
+    entries = (idx.size() - 4) / sizeof(ColLogIndexEntry);
+    exact = (idx.size() - 4) % sizeof(ColLogIndexEntry) == 0;
+  }
+
+  // Checkpoint: the newest entry whose block is intact. Blocks are written
+  // before their entry, so this is normally the last one.
+  int keep = entries;
+  uint32_t pos = sizeof(FileHeader);
+  uint32_t prefix = 0;
+  uint32_t nextSeq = 0;
+  BlockHeader h;
+  while (keep > 0) {
+    ColLogIndexEntry e;
+    if (readIndexEntry(idx, keep - 1, e) && entryValid(log, e, h)) {
+      pos = e.offset + blockSize(h);
+      prefix = e.tMaxPrefix;
+      nextSeq = h.seq + 1;
+      break;
+    }
+    keep--;
+  }
+
+  // Only the tail after the checkpoint is scanned for unindexed blocks
+  uint32_t tailPos = pos;
+  bool tail = nextBlock(log, tailPos, h, nextSeq);
+  if (recovery) {
+    recovery->dropped = entries - keep;
+    recovery->added = 0;
+  }
+  if (keep == entries && exact && !tail) {
+    if (idx) idx.close();
+    log.close();
+    return entries;
+  }
+
+  // Rewrite: the entries up to the checkpoint, then the tail blocks. Written
+  // aside and renamed, so a power cut here leaves the old index to redo
+  // this from.
+  char tmpPath[52];
+  snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", idxPath);
+  File out = fs.open(tmpPath, "w");
+  if (!out) {
+    if (idx) idx.close();
+    log.close();
+    return -1;
+  }
+  out.write((const uint8_t*)&indexFileMagic, 4);
+  int n = 0;
+  ColLogIndexEntry chunk[16];
+  while (n < keep) {
+    int count = keep - n < 16 ? keep - n : 16;
+    if (!readAt(idx, 4 + n * sizeof(ColLogIndexEntry), chunk, count * sizeof(ColLogIndexEntry))) {
+      idx.close();
+      out.close();
+      log.close();
+      return -1;
+    }
+    out.write((const uint8_t*)chunk, count * sizeof(ColLogIndexEntry));
+    n += count;
+  }
+  if (idx) idx.close();
+  while (nextBlock(log, pos, h, nextSeq)) {
+    if (h.tMax > prefix) prefix = h.tMax;
+    ColLogIndexEntry e = {pos, h.tMin, prefix, h.series, h.count};
+    out.write((const uint8_t*)&e, sizeof(e));
+    n++;
+    if (recovery) recovery->added++;
+    nextSeq = h.seq + 1;
+    pos += blockSize(h);
+  }
+  out.close();
+  log.close();
+  fs.remove(idxPath);
+  return fs.rename(tmpPath, idxPath) ? n : -1;
+}
+
+//----------------------------------------------------------
+// Writer
+//----------------------------------------------------------
+
+// Zone maps of the indexed blocks, for files without a current footer
+static int loadFromIndex(File& log, File& idx, int entries, ColLogZone* zones, int maxZones) {
+  int n = 0;
+  while (n < entries && n < maxZones) {
+    ColLogIndexEntry e;
+    BlockHeader h;
+    if (!readIndexEntry(idx, n, e) || !readAt(log, e.offset, &h, sizeof(h))) break;
+    zones[n].offset = e.offset;
+    zones[n].series = h.series;
+    zones[n].count = h.count;
+    zones[n].tMin = h.tMin;
+    zones[n].tMax = h.tMax;
+    zones[n].vMin = h.vMin;
+    zones[n].vMax = h.vMax;
+    n++;
+  }
+  return n;
+}
+
+bool ColLogWriter::open(fs::FS& fs, const char* path, ColLogRecovery* recovery) {
+  close();
+  _zoneCount = 0;
+  _tMaxPrefix = 0;
+  _nextSeq = 0;
+  for (int s = 0; s < colLogSeriesMax; s++) _pending[s].count = 0;
+
+  // A file shorter than its header was cut off while being created (or
+  // holds nothing) and starts over; anything longer that is not a log is
+  // refused by colLogEnsureIndex() below
+  bool fresh = !fs.exists(path);
+  if (!fresh) {
+    File f = fs.open(path, "r");
+    fresh = f && f.size() < sizeof(FileHeader);
+    if (f) f.close();
+  }
+  if (fresh) {
+    _file = fs.open(path, "w");
+    if (!_file) return false;
+    FileHeader h = {fileMagic, formatVersion, colLogBlockCapacity};
+    bool ok = _file.write((const uint8_t*)&h, sizeof(h)) == sizeof(h);
+    _file.flush();
+    _file.close();
+    if (!ok) return false;
+  }
+
+  // Recover the index from its last intact block; anything torn after that
+  // is left in place and skipped by readers
+  char idxPath[48];
+  colLogIndexPath(idxPath, sizeof(idxPath), path);
+  int entries = colLogEnsureIndex(fs, path, recovery);
+  if (entries < 0) return false;  // Not ours; leave it alone
+
+  _file = fs.open(path, "r");
+  _index = fs.open(idxPath, "r");
+  if (!_file || !_index) {
+    close();
+    return false;
+  }
+  _zoneCount = loadFromFooter(_file, _zones, colLogZoneMax);
+  if (_zoneCount != entries) _zoneCount = loadFromIndex(_file, _index, entries, _zones, colLogZoneMax);
+  if (entries > 0) {
+    ColLogIndexEntry e;
+    BlockHeader h;
+    if (readIndexEntry(_index, entries - 1, e) && readAt(_file, e.offset, &h, sizeof(h))) {
+      _tMaxPrefix = e.tMaxPrefix;
+      _nextSeq = h.seq + 1;
+    }
+  }
+  _file.close();
+  _index.close();
+
+  _file = fs.open(path, "a");
+  _index = fs.open(idxPath, "a");
+  _open = _file && _index;
+  if (!_open) close();
+  return _open;
+}
+
+bool ColLogWriter::append(uint8_t series, uint32_t time, float value) {
+  if (!_open || series >= colLogSeriesMax) return false;
+  Pending& p = _pending[series];
+  // The last zones are kept for the partial blocks close() writes
+  if (p.count == colLogBlockCapacity - 1 && full()) return false;
+  p.times[p.count] = time;
+  p.values[p.count] = value;
+  p.count++;
+  if (p.count < colLogBlockCapacity || writeBlock(series)) return true;
+  // The block stays buffered without this sample; the caller offers it again
+  p.count--;
+  return false;
+}
+
+bool ColLogWriter::writeBlock(uint8_t series) {
+  Pending& p = _pending[series];
+  if (p.count == 0) return true;
+  if (_zoneCount >= colLogZoneMax) return false;
+
+  BlockHeader h = {blockMagic, series, 0, p.count, _nextSeq,
+                   p.times[0], p.times[0], p.values[0], p.values[0], 0};
+  for (int i = 1; i < p.count; i++) {
+    if (p.times[i] < h.tMin) h.tMin = p.times[i];
+    if (p.times[i] > h.tMax) h.tMax = p.times[i];
+    if (p.values[i] < h.vMin) h.vMin = p.values[i];
+    if (p.values[i] > h.vMax) h.vMax = p.values[i];
+  }
+  h.crc = crc32Update(crc32Update(headerCrc(h), p.times, p.count * 4), p.values, p.count * 4);
+  uint32_t offset = _file.size();
+  bool ok = _file.write((const uint8_t*)&h, sizeof(h)) == sizeof(h) &&
+            _file.write((const uint8_t*)p.times, p.count * 4) == p.count * 4u &&
+            _file.write((const uint8_t*)p.values, p.count * 4) == p.count * 4u;
+  _file.flush();
+  if (!ok) return false;
+
+  // The entry goes after the block is on the card, so an index entry always
+  // points at a complete block (recovery checks the CRC anyway)
+  _nextSeq++;
+  _blocksWritten++;
+  if (h.tMax > _tMaxPrefix) _tMaxPrefix = h.tMax;
+  ColLogIndexEntry e = {offset, h.tMin, _tMaxPrefix, series, p.count};
+  _index.write((const uint8_t*)&e, sizeof(e));
+  _index.flush();
+
+  ColLogZone& z = _zones[_zoneCount++];
+  z.offset = offset;
+  z.series = series;
+  z.count = p.count;
+  z.tMin = h.tMin;
+  z.tMax = h.tMax;
+  z.vMin = h.vMin;
+  z.vMax = h.vMax;
+  p.count = 0;
+  return true;
+}
+
+int ColLogWriter::queryPending(uint8_t series, uint32_t t0, uint32_t t1,
+                               bool (*fn)(uint32_t time, float value, void* ctx), void* ctx) const {
+  if (!_open || series >= colLogSeriesMax) return 0;
+  const Pending& p = _pending[series];
+  int n = 0;
+  for (int i = 0; i < p.count; i++) {
+    if (p.times[i] < t0 || p.times[i] > t1) continue;
+    if (!fn(p.times[i], p.values[i], ctx)) break;
+    n++;
+  }
+  return n;
+}
+
+bool ColLogWriter::flush() {
+  bool ok = true;
+  for (int s = 0; s < colLogSeriesMax; s++) ok &= writeBlock(s);
+  return ok;
+}
+
+bool ColLogWriter::close() {
+  if (!_open) {
+    if (_file) _file.close();
+    if (_index) _index.close();
+    return true;
+  }
+  bool ok = flush();
+  uint32_t footerOffset = _file.size();
+  uint32_t head[2] = {indexMagic, (uint32_t)_zoneCount};
+  Trailer t = {footerOffset, trailerMagic};
+  ok &= _file.write((const uint8_t*)head, sizeof(head)) == sizeof(head);
+  ok &= _file.write((const uint8_t*)_zones, _zoneCount * sizeof(ColLogZone)) ==
+        _zoneCount * sizeof(ColLogZone);
+  ok &= _file.write((const uint8_t*)&t, sizeof(t)) == sizeof(t);
+  _file.close();
+  _index.close();
+  _open = false;
+  return ok;
+}
+
+//----------------------------------------------------------
+// Reader
+//----------------------------------------------------------
+
+bool ColLogReader::open(fs::FS& fs, const char* path) {
+  close();
+  _entries = colLogEnsureIndex(fs, path);
+  if (_entries < 0) return false;
+  char idxPath[48];
+  colLogIndexPath(idxPath, sizeof(idxPath), path);
+  _file = fs.open(path, "r");
+  _index = fs.open(idxPath, "r");
+  if (!_file || !_index) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void ColLogReader::close() {
+  if (_file) _file.close();
+  if (_index) _index.close();
+  _entries = 0;
+}
+
+bool ColLogReader::readEntry(int i, ColLogIndexEntry& e) {
+  _stats.indexReads++;
+  return readAt(_index, 4 + i * sizeof(ColLogIndexEntry), &e, sizeof(e));
+}
+
+int ColLogReader::seek(uint32_t t) {
+  int lo = 0;
+  int hi = _entries;
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    ColLogIndexEntry e;
+    if (!readEntry(mid, e)) return _entries;
+    if (e.tMaxPrefix < t) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+int ColLogReader::query(uint8_t series, uint32_t t0, uint32_t t1,
+                        bool (*fn)(uint32_t time, float value, void* ctx), void* ctx) {
+  static uint32_t times[colLogBlockCapacity];
+  static float values[colLogBlockCapacity];
+  int n = 0;
+  for (int b = seek(t0); b < _entries; b++) {
+    ColLogIndexEntry e;
+    if (!readEntry(b, e)) break;
+    // A damaged entry must not size the column reads below
+    if (e.count == 0 || e.count > colLogBlockCapacity) continue;
+    if (e.series != series) continue;
+    // Blocks of one series are in time order
+    if (e.tMin > t1) break;
+    _stats.blocksRead++;
+    uint32_t base = e.offset + sizeof(BlockHeader);
+    if (!readAt(_file, base, times, e.count * 4) ||
+        _file.read((uint8_t*)values, e.count * 4) != e.count * 4u) {
+      break;
+    }
+    for (int i = 0; i < e.count; i++) {
+      if (times[i] >= t0 && times[i] <= t1) {
+        if (!fn(times[i], values[i], ctx)) return n;
+        n++;
+      }
+    }
+  }
+  return n;
+}
+
+bool ColLogReader::range(uint8_t series, uint32_t t0, uint32_t t1, float& lo, float& hi) {
+  static uint32_t times[colLogBlockCapacity];
+  static float values[colLogBlockCapacity];
+  bool any = false;
+  for (int b = seek(t0); b < _entries; b++) {
+    ColLogIndexEntry e;
+    if (!readEntry(b, e)) break;
+    if (e.series != series) continue;
+    if (e.tMin > t1) break;
+    BlockHeader h;
+    if (!readAt(_file, e.offset, &h, sizeof(h))) break;
+    if (h.count == 0 || h.count > colLogBlockCapacity || h.series != series) continue;
+    if (h.tMax < t0) continue;
+    if (h.tMin >= t0 && h.tMax <= t1) {
+      // Entire block in range: the zone map is the answer
+      if (!any || h.vMin < lo) lo = h.vMin;
+      if (!any || h.vMax > hi) hi = h.vMax;
+      any = true;
+      _stats.blocksSkipped++;
+      continue;
+    }
+    _stats.blocksRead++;
+    if (_file.read((uint8_t*)times, h.count * 4) != h.count * 4u ||
+        _file.read((uint8_t*)values, h.count * 4) != h.count * 4u) {
+      break;
+    }
+    for (int i = 0; i < h.count; i++) {
+      if (times[i] < t0 || times[i] > t1) continue;
+      if (!any || values[i] < lo) lo = values[i];
+      if (!any || values[i] > hi) hi = values[i];
+      any = true;
+    }
+  }
+  return any;
+}
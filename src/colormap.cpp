@@ -0,0 +1,37 @@
+#include "colormap.h"
+
+// Linear interpolation between eight anchors of the "turbo" map, rounded to RGB565
+const uint16_t colormap[256] = {
+  0x3087, 0x30A7, 0x30A8, 0x30C9, 0x30C9, 0x30EA, 0x310A, 0x310B,
+  0x312B, 0x312C, 0x314C, 0x316D, 0x316E, 0x318E, 0x398F, 0x39AF,
+  0x39B0, 0x39D0, 0x39F1, 0x39F1, 0x3A12, 0x3A12, 0x3A33, 0x3A54,
+  0x3A54, 0x3A75, 0x3A75, 0x4296, 0x4296, 0x42B7, 0x42D7, 0x42D8,
+  0x42F9, 0x42F9, 0x431A, 0x431A, 0x433B, 0x435B, 0x435C, 0x437C,
+  0x437C, 0x439C, 0x439C, 0x43BC, 0x43BC, 0x43DC, 0x43DC, 0x3BFC,
+  0x3BFC, 0x3C1C, 0x3C3C, 0x3C3C, 0x3C5C, 0x3C5C, 0x3C7C, 0x3C7C,
+  0x3C9C, 0x349C, 0x34BD, 0x34BD, 0x34DD, 0x34DD, 0x34FD, 0x34FD,
+  0x351D, 0x351D, 0x353D, 0x2D3D, 0x2D5D, 0x2D5D, 0x2D7D, 0x2D7D,
+  0x2D9D, 0x2DBD, 0x2DBD, 0x2DDD, 0x2DDD, 0x2DFD, 0x2DFD, 0x2DFC,
+  0x2E1C, 0x2E1C, 0x2E1C, 0x2E3B, 0x2E3B, 0x2E3B, 0x2E5A, 0x2E5A,
+  0x2E5A, 0x2E7A, 0x2E79, 0x2E79, 0x2E99, 0x2E98, 0x2EB8, 0x2EB8,
+  0x2EB8, 0x2ED7, 0x2ED7, 0x2ED7, 0x2EF7, 0x2EF6, 0x2EF6, 0x2F16,
+  0x2F15, 0x2F15, 0x3735, 0x3735, 0x3734, 0x3754, 0x3754, 0x3773,
+  0x3773, 0x3773, 0x3793, 0x3792, 0x3792, 0x3F92, 0x3F91, 0x3F91,
+  0x4791, 0x4791, 0x4F90, 0x4F90, 0x4FB0, 0x57AF, 0x57AF, 0x57AF,
+  0x5FAE, 0x5FAE, 0x5FAE, 0x67AE, 0x67AD, 0x6FAD, 0x6FAD, 0x6FAC,
+  0x77AC, 0x77AC, 0x77CC, 0x7FCB, 0x7FCB, 0x87CB, 0x87CA, 0x87CA,
+  0x8FCA, 0x8FC9, 0x8FC9, 0x97C9, 0x97C9, 0x9FC8, 0x9FC8, 0x9FC8,
+  0xA7E7, 0xA7E7, 0xA7C7, 0xAFC7, 0xAFC7, 0xAFA7, 0xAFA7, 0xB7A7,
+  0xB7A7, 0xB787, 0xB787, 0xBF87, 0xBF67, 0xBF67, 0xBF67, 0xBF47,
+  0xC747, 0xC747, 0xC747, 0xC727, 0xCF27, 0xCF26, 0xCF06, 0xCF06,
+  0xD706, 0xD6E6, 0xD6E6, 0xD6E6, 0xDEE6, 0xDEC6, 0xDEC6, 0xDEC6,
+  0xE6A6, 0xE6A6, 0xE6A6, 0xE686, 0xEE86, 0xEE86, 0xEE86, 0xEE66,
+  0xEE66, 0xF646, 0xF626, 0xF626, 0xF606, 0xF5E6, 0xF5E5, 0xF5C5,
+  0xF5C5, 0xF5A5, 0xF585, 0xF585, 0xF565, 0xF545, 0xF545, 0xF525,
+  0xF525, 0xF505, 0xF4E5, 0xF4E5, 0xF4C4, 0xF4A4, 0xF4A4, 0xF484,
+  0xF464, 0xFC64, 0xFC44, 0xFC44, 0xFC24, 0xFC04, 0xFC04, 0xFBE4,
+  0xFBC4, 0xFBC3, 0xF3A3, 0xF383, 0xF363, 0xEB43, 0xEB23, 0xEB23,
+  0xEB03, 0xE2E3, 0xE2C2, 0xE2A2, 0xDA82, 0xDA82, 0xDA62, 0xDA42,
+  0xD222, 0xD202, 0xD1E2, 0xC9E1, 0xC9C1, 0xC9A1, 0xC981, 0xC161,
+  0xC141, 0xC141, 0xB921, 0xB901, 0xB8E0, 0xB8C0, 0xB0A0, 0xB0A0,
+};
@@ -0,0 +1,175 @@
+#include "daily_archive.h"
+
+#include <LittleFS.h>
+#include "crc32.h"
+#include "log_sink.h"
+#include "wallclock.h"
+
+static const char* archivePath = "/daily.bin";
+// History samples between saves of the day in progress
+const int saveEvery = 15;
+// Fixed-point scale on flash: 0.01 C, 0.01 %RH, 0.1 hPa
+static const float metricScale[METRIC_COUNT] = {100.0f, 100.0f, 10.0f};
+// Times of min/max are kept in steps of this many minutes
+const int timeStep = 10;
+
+struct __attribute__((packed)) DayRecord {
+  uint16_t day;  // Low 16 bits of the day number (good until 2149)
+  uint16_t samples;
+  struct __attribute__((packed)) {
+    int16_t min;
+    int16_t max;
+    uint8_t mean;   // Position between min and max, 0-255
+    uint8_t minAt;  // timeStep minutes after local midnight
+    uint8_t maxAt;
+  } metric[METRIC_COUNT];
+  uint16_t crc;  // Low half of the CRC-32
+};
+static_assert(sizeof(DayRecord) == 27, "daily record layout");
+
+static File file;
+static DaySummary today = {0, 0, {}};  // day 0 = nothing accumulated yet
+static float sums[METRIC_COUNT];
+static int unsaved = 0;
+
+//----------------------------------------------------------
+// Records
+//----------------------------------------------------------
+
+static int16_t toFixed(float v, Metric m) {
+  float f = v * metricScale[m];
+  if (f > 32767.0f) return 32767;
+  if (f < -32768.0f) return -32768;
+  return (int16_t)lroundf(f);
+}
+
+static uint16_t recordCrc(const DayRecord& r) {
+  return crc32(&r, sizeof(r) - 2) & 0xFFFF;
+}
+
+static uint32_t slotOffset(uint32_t day) {
+  return (day % dailyDays) * sizeof(DayRecord);
+}
+
+static bool readSlot(uint32_t day, DaySummary& out) {
+  DayRecord r;
+  if (!file || !file.seek(slotOffset(day)) || file.read((uint8_t*)&r, sizeof(r)) != sizeof(r) ||
+      r.day != (uint16_t)day || r.samples == 0 || r.crc != recordCrc(r)) {
+    return false;
+  }
+  out.day = day;
+  out.samples = r.samples;
+  for (int m = 0; m < METRIC_COUNT; m++) {
+    DayStats& s = out.metric[m];
+    int lo = r.metric[m].min;
+    int hi = r.metric[m].max;
+    s.min = lo / metricScale[m];
+    s.max = hi / metricScale[m];
+    s.mean = (lo + (hi - lo) * r.metric[m].mean / 255.0f) / metricScale[m];
+    s.minAt = r.metric[m].minAt * timeStep;
+    s.maxAt = r.metric[m].maxAt * timeStep;
+  }
+  return true;
+}
+
+static bool writeSlot(const DaySummary& in) {
+  DayRecord r;
+  r.day = in.day;
+  r.samples = in.samples;
+  for (int m = 0; m < METRIC_COUNT; m++) {
+    const DayStats& s = in.metric[m];
+    int lo = toFixed(s.min, (Metric)m);
+    int hi = toFixed(s.max, (Metric)m);
+    int mean = toFixed(s.mean, (Metric)m);
+    if (mean < lo) mean = lo;
+    if (mean > hi) mean = hi;
+    r.metric[m].min = lo;
+    r.metric[m].max = hi;
+    r.metric[m].mean = hi > lo ? ((mean - lo) * 255 + (hi - lo) / 2) / (hi - lo) : 0;
+    r.metric[m].minAt = s.minAt / timeStep;
+    r.metric[m].maxAt = s.maxAt / timeStep;
+  }
+  r.crc = recordCrc(r);
+  bool ok = file && file.seek(slotOffset(in.day)) &&
+            file.write((const uint8_t*)&r, sizeof(r)) == sizeof(r);
+  file.flush();
+  return ok;
+}
+
+//----------------------------------------------------------
+// Public
+//----------------------------------------------------------
+
+bool dailyBegin() {
+  const uint32_t fileSize = dailyDays * sizeof(DayRecord);
+  file = LittleFS.open(archivePath, "r+");
+  if (file && file.size() != fileSize) file.close();
+  if (!file) {
+    // Allocate every slot up front so writes never grow the file
+    File f = LittleFS.open(archivePath, "w");
+    if (!f) {
+      logPrintln("Daily archive: cannot create");
+      return false;
+    }
+    uint8_t zeros[sizeof(DayRecord)] = {0};
+    for (int i = 0; i < dailyDays; i++) f.write(zeros, sizeof(zeros));
+    f.close();
+    file = LittleFS.open(archivePath, "r+");
+  }
+  return file;
+}
+
+void dailyAdd(uint32_t unixTime, float temp, float humidity, float pressure) {
+  if (!file || unixTime == 0) return;
+  uint32_t day = clockLocalDay(unixTime);
+  if (day != today.day) {
+    if (today.day != 0) writeSlot(today);  // Close the previous day
+    if (readSlot(day, today)) {
+      // Same day as before a reboot: carry on from the saved record
+      for (int m = 0; m < METRIC_COUNT; m++) sums[m] = today.metric[m].mean * today.samples;
+    } else {
+      today.day = day;
+      today.samples = 0;
+    }
+    unsaved = 0;
+  }
+
+  struct tm tm;
+  clockLocal(unixTime, tm);
+  uint16_t minute = tm.tm_hour * 60 + tm.tm_min;
+  const float values[METRIC_COUNT] = {temp, humidity, pressure};
+  for (int m = 0; m < METRIC_COUNT; m++) {
+    DayStats& s = today.metric[m];
+    float v = values[m];
+    if (today.samples == 0) sums[m] = 0;
+    if (today.samples == 0 || v < s.min) {
+      s.min = v;
+      s.minAt = minute;
+    }
+    if (today.samples == 0 || v > s.max) {
+      s.max = v;
+      s.maxAt = minute;
+    }
+    sums[m] += v;
+    s.mean = sums[m] / (today.samples + 1);
+  }
+  if (today.samples < 0xFFFF) today.samples++;
+
+  if (++unsaved >= saveEvery) {
+    writeSlot(today);
+    unsaved = 0;
+  }
+}
+
+bool dailyGet(uint32_t day, DaySummary& out) {
+  if (day != 0 && day == today.day && today.samples > 0) {
+    out = today;
+    return true;
+  }
+  return readSlot(day, out);
+}
+
+uint32_t dailyToday() {
+  uint32_t now = clockNow();
+  return now ? clockLocalDay(now) : 0;
+}
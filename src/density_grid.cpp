@@ -0,0 +1,79 @@
+#include "density_grid.h"
+
+#include <LittleFS.h>
+#include "crc32.h"
+
+static const char* densityPath = "/density.bin";
+const uint32_t densityMagic = 0x31534E44;  // "DNS1"
+// History samples between saves
+const int saveEvery = 60;
+
+static uint16_t grid[densityTempBins][densityHumBins];
+static uint16_t maxCount = 0;
+static uint32_t outOfRange = 0;
+static int unsaved = 0;
+
+static void save() {
+  File f = LittleFS.open(densityPath, "w");
+  if (!f) return;
+  uint32_t crc = crc32(grid, sizeof(grid));
+  f.write((const uint8_t*)&densityMagic, 4);
+  f.write((const uint8_t*)grid, sizeof(grid));
+  f.write((const uint8_t*)&crc, 4);
+  f.close();
+}
+
+bool densityBegin() {
+  memset(grid, 0, sizeof(grid));
+  maxCount = 0;
+  File f = LittleFS.open(densityPath, "r");
+  if (!f) return false;
+  uint32_t magic = 0, crc = 0;
+  bool ok = f.read((uint8_t*)&magic, 4) == 4 && magic == densityMagic &&
+            f.read((uint8_t*)grid, sizeof(grid)) == sizeof(grid) &&
+            f.read((uint8_t*)&crc, 4) == 4 && crc == crc32(grid, sizeof(grid));
+  f.close();
+  if (!ok) {
+    memset(grid, 0, sizeof(grid));
+    return false;
+  }
+  for (int t = 0; t < densityTempBins; t++) {
+    for (int h = 0; h < densityHumBins; h++) {
+      if (grid[t][h] > maxCount) maxCount = grid[t][h];
+    }
+  }
+  return true;
+}
+
+void densityAdd(float temp, float humidity) {
+  int t = (int)((temp - densityTempMin) / (densityTempMax - densityTempMin) * densityTempBins);
+  int h = (int)((humidity - densityHumMin) / (densityHumMax - densityHumMin) * densityHumBins);
+  if (temp < densityTempMin || t >= densityTempBins || humidity < densityHumMin || h >= densityHumBins) {
+    outOfRange++;
+    return;
+  }
+  if (grid[t][h] == 0xFFFF) {
+    for (int i = 0; i < densityTempBins; i++) {
+      for (int j = 0; j < densityHumBins; j++) grid[i][j] /= 2;
+    }
+    maxCount /= 2;
+  }
+  if (++grid[t][h] > maxCount) maxCount = grid[t][h];
+
+  if (++unsaved >= saveEvery) {
+    save();
+    unsaved = 0;
+  }
+}
+
+uint16_t densityCell(int tempBin, int humBin) {
+  return grid[tempBin][humBin];
+}
+
+uint16_t densityMax() {
+  return maxCount;
+}
+
+uint32_t densityOutOfRange() {
+  return outOfRange;
+}
@@ -0,0 +1,58 @@
+#include "display_filter.h"
+#include "config.h"
+
+#include <Arduino.h>
+#include <math.h>
+
+// Threshold of the redraw rule this replaced
+const float legacyThreshold = 0.05f;
+const unsigned long hourMs = 3600000;
+
+static DisplayCounts total = {0, 0};
+static DisplayCounts hour = {0, 0};
+static DisplayCounts lastHour = {0, 0};
+static unsigned long hourStart = 0;
+
+static void rollHour() {
+  unsigned long now = millis();
+  if (now - hourStart < hourMs) return;
+  lastHour = hour;
+  hour = {0, 0};
+  hourStart = now;
+}
+
+bool displayFilterUpdate(DisplayFilter& f, float value) {
+  rollHour();
+  bool legacyRedraw = !f.valid || fabsf(value - f.legacy) >= legacyThreshold;
+  if (legacyRedraw) f.legacy = value;
+
+  bool redraw = !f.valid;
+  if (!redraw) {
+    float rounded = roundf(value / f.step) * f.step;
+    // Beyond half a step plus the band: the new digit is unambiguous
+    redraw = rounded != f.shown &&
+             fabsf(value - f.shown) >= f.step * (0.5f + DISPLAY_HYSTERESIS);
+  }
+  if (redraw) {
+    f.shown = roundf(value / f.step) * f.step;
+    f.valid = true;
+    total.redraws++;
+    hour.redraws++;
+  } else if (legacyRedraw) {
+    total.avoided++;
+    hour.avoided++;
+  }
+  return redraw;
+}
+
+void displayFilterReset(DisplayFilter& f) {
+  f.valid = false;
+}
+
+const DisplayCounts& displayCountsTotal() {
+  return total;
+}
+
+const DisplayCounts& displayCountsLastHour() {
+  return lastHour;
+}
@@ -0,0 +1,102 @@
+#include "energy_model.h"
+
+// Starting values from the datasheets and a bench supply, to be replaced by
+// measurements of the actual unit. The backlight steps are the settings'
+// 20..100 passed to setBrightness(), which takes 0..255, so "100 %" is
+// about 40 % PWM duty.
+const EnergyCalibration energyDefaultCalibration = {
+  32.0f,   // ESP32-S3 at 240 MHz in the idle task, plus board quiescent
+  25.0f,   // Running loop code on top of idle
+  {0.0f, 3.5f, 7.0f, 10.5f, 14.0f, 17.5f},
+  4.0f,    // ~0.2 ms per KB at 40 MHz SPI
+  1.0f,    // ~0.2 ms at 400 kHz, pull-ups and CPU waiting
+  300.0f,  // Data + index write with flush, ~5 ms at ~60 mA
+  50.0f,   // Associated, default modem sleep
+  15.0f,   // Advertising / connected, no modem sleep
+};
+
+static const char* partNames[ENERGY_PART_COUNT] = {
+  "CPU", "Backlight", "Display SPI", "Sensor I2C", "SD log", "Radio"
+};
+
+const char* energyPartName(EnergyPart part) {
+  return part < ENERGY_PART_COUNT ? partNames[part] : "?";
+}
+
+void energyEstimate(const EnergyCounters& c, const EnergyCalibration& cal,
+                    float mAhPerHour[ENERGY_PART_COUNT]) {
+  for (int i = 0; i < ENERGY_PART_COUNT; i++) mAhPerHour[i] = 0;
+  if (c.awakeMs == 0) return;
+  float hours = c.awakeMs / 3600000.0f;
+  // mA * ms and uA*s both convert to mAh with a fixed factor
+  const float mAmsToMah = 1.0f / 3600000.0f;
+  const float uasToMah = 1.0f / 3600000.0f;
+
+  float cpu = cal.cpuIdleMa * c.awakeMs + cal.cpuBusyMa * (c.cpuBusyUs / 1000.0f);
+  mAhPerHour[ENERGY_CPU] = cpu * mAmsToMah / hours;
+
+  float backlight = 0;
+  for (int i = 0; i < energyBrightnessSteps; i++) backlight += cal.backlightMa[i] * c.backlightMs[i];
+  mAhPerHour[ENERGY_BACKLIGHT] = backlight * mAmsToMah / hours;
+
+  mAhPerHour[ENERGY_DISPLAY] = cal.spiUasPerKB * (c.spiBytes / 1024.0f) * uasToMah / hours;
+  mAhPerHour[ENERGY_I2C] = cal.i2cUasPerTransaction * c.i2cTransactions * uasToMah / hours;
+  mAhPerHour[ENERGY_SD] = cal.sdUasPerBlock * c.sdBlockWrites * uasToMah / hours;
+
+  float radio = cal.wifiMa * c.wifiOnMs + cal.bleMa * c.bleOnMs;
+  mAhPerHour[ENERGY_RADIO] = radio * mAmsToMah / hours;
+}
+
+float energyBatteryHours(const float mAhPerHour[ENERGY_PART_COUNT], float capacityMah) {
+  float total = 0;
+  for (int i = 0; i < ENERGY_PART_COUNT; i++) total += mAhPerHour[i];
+  return total > 0 ? capacityMah / total : 0;
+}
+
+int energyBrightnessStep(int brightnessPercent) {
+  if (brightnessPercent <= 0) return 0;
+  int step = (brightnessPercent + 10) / 20;
+  if (step < 1) step = 1;
+  if (step > energyBrightnessSteps - 1) step = energyBrightnessSteps - 1;
+  return step;
+}
+
+static EnergyCounters counters;
+static unsigned long lastTickMs = 0;
+static bool ticked = false;
+
+void energyTick(unsigned long nowMs, int brightnessStep, bool wifiOn, bool bleOn) {
+  if (!ticked) {
+    // Time before the first tick (boot, setup()) is counted as awake only
+    counters.awakeMs = nowMs;
+    lastTickMs = nowMs;
+    ticked = true;
+    return;
+  }
+  unsigned long dt = nowMs - lastTickMs;
+  lastTickMs = nowMs;
+  counters.awakeMs += dt;
+  if (brightnessStep >= 0 && brightnessStep < energyBrightnessSteps) counters.backlightMs[brightnessStep] += dt;
+  if (wifiOn) counters.wifiOnMs += dt;
+  if (bleOn) counters.bleOnMs += dt;
+}
+
+void energyAddCpuBusy(uint32_t us) {
+  counters.cpuBusyUs += us;
+}
+
+void energyAddSpiBytes(uint32_t bytes) {
+  counters.spiBytes += bytes;
+}
+
+void energyAddI2c(uint32_t transactions) {
+  counters.i2cTransactions += transactions;
+}
+
+void energyAddSdBlocks(uint32_t blocks) {
+  counters.sdBlockWrites += blocks;
+}
+
+const EnergyCounters& energyCounters() {
+  return counters;
+}
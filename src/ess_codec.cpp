@@ -0,0 +1,54 @@
+#include "ess_codec.h"
+
+#include <math.h>
+
+static int32_t roundClamp(float v, int32_t lo, int32_t hi) {
+  if (isnan(v)) return lo;
+  float r = roundf(v);
+  if (r < lo) return lo;
+  if (r > hi) return hi;
+  return (int32_t)r;
+}
+
+int16_t essEncodeTemperature(float tempC) {
+  // 0x8000 is "value is not known"
+  if (isnan(tempC)) return INT16_MIN;
+  return roundClamp(tempC * 100.0f, -27315, INT16_MAX);
+}
+
+uint16_t essEncodeHumidity(float humidity) {
+  if (isnan(humidity)) return 0xFFFF;
+  return roundClamp(humidity * 100.0f, 0, 10000);
+}
+
+uint32_t essEncodePressure(float pressureHpa) {
+  // hPa -> 0.1 Pa units
+  if (isnan(pressureHpa)) return 0;
+  return roundClamp(pressureHpa * 1000.0f, 0, INT32_MAX);
+}
+
+size_t essRecordsPerChunk(uint16_t mtu) {
+  if (mtu < 3 + essChunkHeaderSize + essRecordSize) return 0;
+  return (mtu - 3 - essChunkHeaderSize) / essRecordSize;
+}
+
+static void put16(uint8_t* p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+static void put32(uint8_t* p, uint32_t v) {
+  put16(p, v & 0xFFFF);
+  put16(p + 2, v >> 16);
+}
+
+void essPutChunkHeader(uint8_t* out, uint16_t seq, bool last) {
+  put16(out, (seq & ~essLastChunkFlag) | (last ? essLastChunkFlag : 0));
+}
+
+void essPutRecord(uint8_t* out, uint32_t time, float tempC, float humidity, float pressureHpa) {
+  put32(out, time);
+  put16(out + 4, (uint16_t)essEncodeTemperature(tempC));
+  put16(out + 6, essEncodeHumidity(humidity));
+  put32(out + 8, essEncodePressure(pressureHpa));
+}
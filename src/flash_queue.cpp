@@ -0,0 +1,161 @@
+#include "flash_queue.h"
+#include "crc32.h"
+
+const uint32_t queueMagic = 0x32515146;  // "FQQ2"
+
+struct __attribute__((packed)) QueueHeader {
+  uint32_t magic;
+  uint16_t slots;
+  uint16_t slotSize;
+  uint32_t head;
+  uint32_t tail;
+  uint32_t dropped;
+  uint32_t generation;  // Bumped on every write; the newer copy wins
+  uint32_t crc;
+};
+
+struct __attribute__((packed)) SlotHeader {
+  uint16_t len;
+  uint32_t seq;  // Tail counter the message was pushed at
+  uint32_t crc;  // Over len, seq and the data
+};
+
+static uint32_t headerCrc(const QueueHeader& h) {
+  return crc32(&h, sizeof(h) - 4);
+}
+
+static uint32_t slotCrc(const SlotHeader& s, const uint8_t* data) {
+  return crc32Update(crc32(&s, 6), data, s.len);
+}
+
+uint32_t FlashQueue::slotOffset(uint32_t counter) const {
+  return 2 * sizeof(QueueHeader) + (counter % _slots) * (uint32_t)(_slotSize + sizeof(SlotHeader));
+}
+
+bool FlashQueue::begin(fs::FS& fs, const char* path, uint16_t slots, uint16_t slotSize) {
+  _fs = &fs;
+  _path = path;
+  _slots = slots;
+  _slotSize = slotSize;
+  _head = _tail = _dropped = _generation = 0;
+
+  File f = fs.open(path, "r");
+  if (f) {
+    // Checkpoint: the newer of the two header copies that is intact
+    QueueHeader copies[2];
+    bool found = false;
+    bool ok = f.read((uint8_t*)copies, sizeof(copies)) == sizeof(copies);
+    for (int i = 0; ok && i < 2; i++) {
+      const QueueHeader& h = copies[i];
+      if (h.magic != queueMagic || h.slots != slots || h.slotSize != slotSize ||
+          h.crc != headerCrc(h) || h.tail - h.head > slots) {
+        continue;
+      }
+      if (!found || (int32_t)(h.generation - _generation) > 0) {
+        _head = h.head;
+        _tail = h.tail;
+        _dropped = h.dropped;
+        _generation = h.generation;
+        found = true;
+      }
+    }
+    if (found) {
+      // Roll forward over messages pushed after the header was last written
+      uint32_t recovered = 0;
+      while (recovered < _slots && slotValid(f, _tail)) {
+        if (size() >= _slots) {
+          _head++;
+          _dropped++;
+        }
+        _tail++;
+        recovered++;
+      }
+      f.close();
+      return recovered == 0 || writeHeader();
+    }
+    f.close();
+  }
+  // Missing or from a different layout: start empty, with both copies
+  return writeHeader() && writeHeader();
+}
+
+bool FlashQueue::slotValid(File& f, uint32_t counter) {
+  SlotHeader s;
+  if (!f.seek(slotOffset(counter)) || f.read((uint8_t*)&s, sizeof(s)) != sizeof(s) ||
+      s.seq != counter || s.len > _slotSize) {
+    return false;
+  }
+  uint32_t crc = crc32(&s, 6);
+  uint8_t chunk[64];
+  for (uint16_t done = 0; done < s.len;) {
+    uint16_t n = s.len - done < (int)sizeof(chunk) ? s.len - done : sizeof(chunk);
+    if (f.read(chunk, n) != n) return false;
+    crc = crc32Update(crc, chunk, n);
+    done += n;
+  }
+  return crc == s.crc;
+}
+
+bool FlashQueue::writeHeader() {
+  _generation++;
+  QueueHeader h = {queueMagic, _slots, _slotSize, _head, _tail, _dropped, _generation, 0};
+  h.crc = headerCrc(h);
+  File f = _fs->open(_path, _fs->exists(_path) ? "r+" : "w");
+  if (!f) return false;
+  // Alternate between the two copies so a torn write leaves the other
+  bool ok = f.seek(((_generation + 1) & 1) * sizeof(QueueHeader)) &&
+            f.write((const uint8_t*)&h, sizeof(h)) == sizeof(h);
+  f.close();
+  return ok;
+}
+
+bool FlashQueue::push(const uint8_t* data, uint16_t len) {
+  if (!_fs || len > _slotSize) return false;
+  SlotHeader s = {len, _tail, 0};
+  s.crc = slotCrc(s, data);
+  File f = _fs->open(_path, "r+");
+  if (!f) return false;
+  bool ok = f.seek(slotOffset(_tail)) && f.write((const uint8_t*)&s, sizeof(s)) == sizeof(s) &&
+            f.write(data, len) == len;
+  f.close();
+  if (!ok) return false;
+
+  // Only count the push (and the message it overwrote) once it is on flash;
+  // a slot written without a header is picked up by begin()'s roll-forward
+  uint32_t head = _head, tail = _tail, dropped = _dropped;
+  if (size() >= _slots) {
+    _head++;
+    _dropped++;
+  }
+  _tail++;
+  if (writeHeader()) return true;
+  _head = head;
+  _tail = tail;
+  _dropped = dropped;
+  return false;
+}
+
+int FlashQueue::peek(uint8_t* buf, uint16_t bufSize) {
+  if (!_fs || empty()) return flashQueueRetry;
+  File f = _fs->open(_path, "r");
+  if (!f) return flashQueueRetry;
+  // A failed read says nothing about the slot; only what was read can
+  // condemn it
+  SlotHeader s;
+  int result = flashQueueRetry;
+  if (f.seek(slotOffset(_head)) && f.read((uint8_t*)&s, sizeof(s)) == sizeof(s)) {
+    if (s.seq != _head || s.len > _slotSize || s.len > bufSize) {
+      result = flashQueueBadSlot;
+    } else if (f.read(buf, s.len) == s.len) {
+      result = slotCrc(s, buf) == s.crc ? s.len : flashQueueBadSlot;
+    }
+  }
+  f.close();
+  return result;
+}
+
+bool FlashQueue::pop() {
+  if (empty()) return false;
+  _head++;
+  return writeHeader();
+}
@@ -0,0 +1,83 @@
+#include "hampel.h"
+
+#include <math.h>
+
+// MAD floor per metric, well above the sensor noise (see smoothing.cpp)
+static const float madFloor[METRIC_COUNT] = {
+  0.1f,  // deg C
+  0.5f,  // %RH
+  0.2f,  // hPa
+};
+
+struct HampelState {
+  float window[hampelWindow];  // Ring of raw readings
+  uint8_t next;
+  uint8_t count;
+  uint32_t rejected;
+};
+
+static HampelState states[METRIC_COUNT];
+
+// Plain compares rather than fminf/fmaxf: NaN never reaches the window, and
+// the libm calls' NaN handling made the network slower than a sort
+static inline void sort2(float& a, float& b) {
+  float lo = a < b ? a : b;
+  b = a < b ? b : a;
+  a = lo;
+}
+
+// Median of 7 with an optimal 16-comparator sorting network
+float hampelMedian7(float* v) {
+  sort2(v[0], v[6]); sort2(v[2], v[3]); sort2(v[4], v[5]);
+  sort2(v[0], v[2]); sort2(v[1], v[4]); sort2(v[3], v[6]);
+  sort2(v[0], v[1]); sort2(v[2], v[5]); sort2(v[3], v[4]);
+  sort2(v[1], v[2]); sort2(v[4], v[6]);
+  sort2(v[2], v[3]); sort2(v[4], v[5]);
+  sort2(v[1], v[2]); sort2(v[3], v[4]); sort2(v[5], v[6]);
+  return v[3];
+}
+
+static_assert(hampelWindow == 7, "hampelMedian7() assumes a window of 7");
+
+float hampelFilter(Metric metric, float raw) {
+  HampelState& s = states[metric];
+  if (!isfinite(raw)) {
+    // Never let NaN into the window; pass on the last good median
+    s.rejected++;
+    if (s.count == 0) return raw;
+    float v[hampelWindow];
+    for (int i = 0; i < hampelWindow; i++) v[i] = s.window[i];
+    return hampelMedian7(v);
+  }
+
+  if (s.count == 0) {
+    // Prime the whole window so the network always sees 7 inputs
+    for (int i = 0; i < hampelWindow; i++) s.window[i] = raw;
+  }
+  s.window[s.next] = raw;
+  s.next = (s.next + 1) % hampelWindow;
+  if (s.count < hampelWindow) s.count++;
+
+  float v[hampelWindow];
+  for (int i = 0; i < hampelWindow; i++) v[i] = s.window[i];
+  float median = hampelMedian7(v);
+  for (int i = 0; i < hampelWindow; i++) v[i] = fabsf(v[i] - median);
+  float sigma = 1.4826f * fmaxf(hampelMedian7(v), madFloor[metric]);
+
+  if (fabsf(raw - median) > hampelSigmas * sigma) {
+    s.rejected++;
+    return median;
+  }
+  return raw;
+}
+
+uint32_t hampelRejected(Metric metric) {
+  return states[metric].rejected;
+}
+
+void hampelReset() {
+  for (int m = 0; m < METRIC_COUNT; m++) {
+    states[m].next = 0;
+    states[m].count = 0;
+  }
+}
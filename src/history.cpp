@@ -0,0 +1,97 @@
+#include "history.h"
+
+static float tempValues[historySizes[METRIC_TEMP]];
+static uint32_t tempTimes[historySizes[METRIC_TEMP]];
+static float humidityValues[historySizes[METRIC_HUMIDITY]];
+static uint32_t humidityTimes[historySizes[METRIC_HUMIDITY]];
+static float pressureValues[historySizes[METRIC_PRESSURE]];
+static uint32_t pressureTimes[historySizes[METRIC_PRESSURE]];
+
+struct Ring {
+  float* values;
+  uint32_t* times;
+  int size;
+  int head;   // Next slot to write
+  int count;
+  uint32_t seq;
+};
+
+static Ring rings[METRIC_COUNT] = {
+  {tempValues, tempTimes, historySizes[METRIC_TEMP], 0, 0, 0},
+  {humidityValues, humidityTimes, historySizes[METRIC_HUMIDITY], 0, 0, 0},
+  {pressureValues, pressureTimes, historySizes[METRIC_PRESSURE], 0, 0, 0},
+};
+
+static inline int slotOf(const Ring& r, int i) {
+  return (r.head - r.count + i + r.size) % r.size;
+}
+
+void historyClear() {
+  for (int m = 0; m < METRIC_COUNT; m++) {
+    rings[m].head = 0;
+    rings[m].count = 0;
+  }
+}
+
+void historyAdd(Metric metric, uint32_t timeSec, float value) {
+  Ring& r = rings[metric];
+  r.values[r.head] = value;
+  r.times[r.head] = timeSec;
+  r.head = (r.head + 1) % r.size;
+  if (r.count < r.size) r.count++;
+  r.seq++;
+}
+
+int historyCount(Metric metric) {
+  return rings[metric].count;
+}
+
+uint32_t historySeq(Metric metric) {
+  return rings[metric].seq;
+}
+
+float historyValue(Metric metric, int i) {
+  const Ring& r = rings[metric];
+  return r.values[slotOf(r, i)];
+}
+
+uint32_t historyTime(Metric metric, int i) {
+  const Ring& r = rings[metric];
+  return r.times[slotOf(r, i)];
+}
+
+int historyFind(Metric metric, uint32_t timeSec) {
+  const Ring& r = rings[metric];
+  // Times are non-decreasing from oldest to newest
+  int lo = 0;
+  int hi = r.count;
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if (r.times[slotOf(r, mid)] < timeSec) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+int historyAt(Metric metric, uint32_t timeSec) {
+  const Ring& r = rings[metric];
+  if (r.count == 0 || r.times[slotOf(r, 0)] > timeSec) return -1;
+  uint32_t newest = r.times[slotOf(r, r.count - 1)];
+  if (timeSec >= newest) return r.count - 1;
+  // Intervals run slightly long, so the guess lands at or a few samples
+  // before the answer
+  int i = r.count - 1 - (newest - timeSec) / (historyIntervals[metric] / 1000);
+  if (i < 0) i = 0;
+  while (i > 0 && r.times[slotOf(r, i)] > timeSec) i--;
+  while (i + 1 < r.count && r.times[slotOf(r, i + 1)] <= timeSec) i++;
+  return i;
+}
+
+float historyValueAt(Metric metric, uint32_t timeSec) {
+  if (rings[metric].count == 0) return 0;
+  int i = historyAt(metric, timeSec);
+  return historyValue(metric, i < 0 ? 0 : i);
+}
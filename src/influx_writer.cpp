@@ -0,0 +1,134 @@
+#include "influx_writer.h"
+#include "config.h"
+
+#if ENABLE_INFLUX
+
+#include <HTTPClient.h>
+#include <math.h>
+#include "history.h"
+#include "line_protocol.h"
+#include "log_sink.h"
+#include "wallclock.h"
+#include "wifi_link.h"
+
+// A longer series fits no line, so nothing could ever be sent
+static_assert(sizeof(INFLUX_SERIES) - 1 <= lineProtocolSeriesMax,
+              "INFLUX_SERIES is longer than lineProtocolSeriesMax");
+
+const size_t batchMax = 4096;
+const unsigned long retryDelay = 30000;
+// Bounds on how long a post blocks loop() (see LOOP_HANG_MS): TCP connect,
+// then the wait for each part of the response
+const int32_t connectTimeoutMs = 2000;
+const uint16_t responseTimeoutMs = 3000;
+
+static char batch[batchMax];
+static size_t batchLen = 0;
+static uint32_t batchEndSeq = 0;    // Next bin to encode; earlier ones are in `batch` or sent
+static uint32_t batchFirstTime = 0;  // Uptime of the oldest bin in `batch`
+static bool linkHeld = false;
+static unsigned long lastFailure = 0;
+static bool failedOnce = false;
+static bool reportedNoFit = false;
+
+// Encode pending bins into the batch; true if it filled up
+static bool fillBatch() {
+  uint32_t oldestSeq = historySeq(METRIC_TEMP) - historyCount(METRIC_TEMP);
+  if (batchEndSeq < oldestSeq) {
+    logPrintf("Influx: %lu bins lost before upload\n", (unsigned long)(oldestSeq - batchEndSeq));
+    batchEndSeq = oldestSeq;
+  }
+  while (batchEndSeq < historySeq(METRIC_TEMP)) {
+    int i = batchEndSeq - oldestSeq;
+    uint32_t time = historyTime(METRIC_TEMP, i);
+    float t = historyValue(METRIC_TEMP, i);
+    float h = historyValueAt(METRIC_HUMIDITY, time);
+    float p = historyValueAt(METRIC_PRESSURE, time);
+    if (!isnan(t) && !isnan(h) && !isnan(p)) {
+      size_t len = lineProtocolAppend(batch, batchLen, batchMax, INFLUX_SERIES,
+                                      clockFromUptime(time), t, h, p);
+      if (len == batchLen) return true;
+      if (batchLen == 0) batchFirstTime = time;
+      batchLen = len;
+    }
+    batchEndSeq++;
+  }
+  return false;
+}
+
+static bool post() {
+  HTTPClient http;
+  if (!http.begin(INFLUX_URL)) return false;
+  http.setConnectTimeout(connectTimeoutMs);
+  http.setTimeout(responseTimeoutMs);
+  http.addHeader("Content-Type", "text/plain; charset=utf-8");
+  if (strlen(INFLUX_TOKEN) > 0) {
+    char auth[160];
+    snprintf(auth, sizeof(auth), "Token %s", INFLUX_TOKEN);
+    http.addHeader("Authorization", auth);
+  }
+  int code = http.POST((uint8_t*)batch, batchLen);
+  http.end();
+  if (code < 200 || code >= 300) {
+    logPrintf("Influx write failed (%d)\n", code);
+    return false;
+  }
+  return true;
+}
+
+void influxBegin() {
+  batchEndSeq = historySeq(METRIC_TEMP) - historyCount(METRIC_TEMP);
+}
+
+void influxPoll() {
+  if (!clockValid()) return;
+  if (failedOnce && millis() - lastFailure < retryDelay) return;
+
+  bool full = fillBatch();
+  if (full && batchLen == 0) {
+    // Not even one line fits: posting an empty body would repeat forever
+    if (!reportedNoFit) {
+      logPrintln("Influx: line does not fit in a batch, nothing sent");
+      reportedNoFit = true;
+    }
+    return;
+  }
+  bool old = batchLen > 0 && millis() / 1000 - batchFirstTime >= INFLUX_FLUSH_AGE_MS / 1000;
+
+  if (!full && !old) {
+    if (linkHeld) {
+      wifiRelease();
+      linkHeld = false;
+    }
+    return;
+  }
+
+  if (!linkHeld) {
+    wifiAcquire();
+    linkHeld = true;
+  }
+  if (wifiState() == WIFI_LINK_FAILED) {
+    wifiRelease();
+    linkHeld = false;
+    failedOnce = true;
+    lastFailure = millis();
+    return;
+  }
+  if (wifiState() != WIFI_LINK_UP) return;
+
+  // One batch per poll; a backlog drains in back-to-back full batches
+  if (post()) {
+    batchLen = 0;
+    failedOnce = false;
+  } else {
+    failedOnce = true;
+    lastFailure = millis();
+  }
+}
+
+#else
+
+void influxBegin() {}
+void influxPoll() {}
+
+#endif
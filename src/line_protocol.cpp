@@ -0,0 +1,71 @@
+#include "line_protocol.h"
+
+#include <math.h>
+#include <string.h>
+
+float dewPoint(float tempC, float humidity) {
+  const float a = 17.62;
+  const float b = 243.12;
+  if (humidity <= 0) humidity = 0.01;
+  float gamma = logf(humidity / 100.0f) + (a * tempC) / (b + tempC);
+  return (b * gamma) / (a - gamma);
+}
+
+// Digits of v into p (no terminator), returns count
+static int putUint(char* p, uint32_t v) {
+  char tmp[10];
+  int n = 0;
+  do {
+    tmp[n++] = '0' + v % 10;
+    v /= 10;
+  } while (v);
+  for (int i = 0; i < n; i++) p[i] = tmp[n - 1 - i];
+  return n;
+}
+
+// Fixed two decimals, rounded half away from zero
+static int putFixed2(char* p, float v) {
+  int n = 0;
+  if (v < 0) {
+    p[n++] = '-';
+    v = -v;
+  }
+  uint32_t scaled = (uint32_t)(v * 100.0f + 0.5f);
+  n += putUint(p + n, scaled / 100);
+  p[n++] = '.';
+  p[n++] = '0' + (scaled / 10) % 10;
+  p[n++] = '0' + scaled % 10;
+  return n;
+}
+
+static int putField(char* p, const char* name, float v, bool first) {
+  int n = 0;
+  if (!first) p[n++] = ',';
+  size_t nameLen = strlen(name);
+  memcpy(p + n, name, nameLen);
+  n += nameLen;
+  p[n++] = '=';
+  return n + putFixed2(p + n, v);
+}
+
+size_t lineProtocolAppend(char* buf, size_t len, size_t cap, const char* series,
+                          uint32_t unixTime, float temp, float humidity, float pressure) {
+  // Worst case per line: series + 4 fields of ~20 chars + timestamp
+  char line[192];
+  size_t seriesLen = strlen(series);
+  if (seriesLen > lineProtocolSeriesMax) return len;
+  int n = 0;
+  memcpy(line, series, seriesLen);
+  n += seriesLen;
+  line[n++] = ' ';
+  n += putField(line + n, "temp", temp, true);
+  n += putField(line + n, "humidity", humidity, false);
+  n += putField(line + n, "pressure", pressure, false);
+  n += putField(line + n, "dewpoint", dewPoint(temp, humidity), false);
+  line[n++] = ' ';
+  n += putUint(line + n, unixTime);
+  line[n++] = '\n';
+  if (len + n > cap) return len;
+  memcpy(buf + len, line, n);
+  return len + n;
+}
@@ -0,0 +1,90 @@
+#include "log_sink.h"
+
+const int logRingSize = 2048;
+const int logLineMax = 128;
+
+static Print* port = nullptr;
+static char ring[logRingSize];
+static int ringHead = 0;  // Next byte to write
+static int ringTail = 0;  // Next byte to drain
+static uint32_t droppedPending = 0;  // Dropped since the last report
+static uint32_t droppedTotal = 0;
+
+static int ringUsed() {
+  return (ringHead - ringTail + logRingSize) % logRingSize;
+}
+
+static int ringFree() {
+  // One slot kept empty to tell full from empty
+  return logRingSize - 1 - ringUsed();
+}
+
+static void ringPut(const char* text, int len) {
+  for (int i = 0; i < len; i++) {
+    ring[ringHead] = text[i];
+    ringHead = (ringHead + 1) % logRingSize;
+  }
+}
+
+// All-or-nothing: a message that does not fit is dropped, never truncated
+static void append(const char* text, int len) {
+  if (len > ringFree()) {
+    droppedPending++;
+    droppedTotal++;
+    return;
+  }
+  ringPut(text, len);
+}
+
+void logBegin(Print& p) {
+  port = &p;
+}
+
+void logPrintf(const char* format, ...) {
+  char line[logLineMax];
+  va_list args;
+  va_start(args, format);
+  int len = vsnprintf(line, sizeof(line), format, args);
+  va_end(args);
+  if (len < 0) return;
+  if (len >= (int)sizeof(line)) len = sizeof(line) - 1;
+  append(line, len);
+}
+
+void logPrintln(const char* text) {
+  logPrintf("%s\n", text);
+}
+
+void logWrite(const char* text, int len) {
+  append(text, len);
+}
+
+void logDrain() {
+  if (!port) return;
+
+  while (ringTail != ringHead) {
+    int room = port->availableForWrite();
+    if (room <= 0) return;
+    // Contiguous run up to the wrap point or the head
+    int run = (ringHead > ringTail) ? ringHead - ringTail : logRingSize - ringTail;
+    if (run > room) run = room;
+    int written = port->write((const uint8_t*)ring + ringTail, run);
+    if (written <= 0) return;
+    ringTail = (ringTail + written) % logRingSize;
+  }
+
+  // Ring has drained: report what was lost; it goes out on the next drain
+  if (droppedPending > 0) {
+    char note[48];
+    int len = snprintf(note, sizeof(note), "[log] %lu messages dropped\n",
+                       (unsigned long)droppedPending);
+    if (len <= ringFree()) {
+      ringPut(note, len);
+      droppedPending = 0;
+    }
+  }
+}
+
+uint32_t logDroppedTotal() {
+  return droppedTotal;
+}
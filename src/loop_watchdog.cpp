@@ -0,0 +1,164 @@
+#include "loop_watchdog.h"
+#include "config.h"
+
+#include <Arduino.h>
+#include <esp_attr.h>
+#include <esp_system.h>
+#include <esp_task_wdt.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "log_sink.h"
+
+static const char* phaseNames[LOOP_PHASE_COUNT] = {
+  "idle", "keyboard", "protocol", "log", "sensors", "history", "sd log", "network", "display"
+};
+
+// Kept across software, watchdog and panic resets (not power loss)
+struct RtcRecord {
+  uint32_t magic;
+  uint8_t phase;    // Phase running right now
+  uint8_t hung;     // Set by the monitor just before it restarts
+  uint32_t hangMs;
+};
+static const uint32_t rtcMagic = 0x4C574454;  // "LWDT"
+static RTC_NOINIT_ATTR RtcRecord rtc;
+
+// Shared with the monitor task; the loop writes, the monitor reads
+static volatile uint32_t iterationStartUs = 0;
+static volatile uint32_t iterationSeq = 0;
+static volatile bool inIteration = false;
+static volatile uint8_t phase = LOOP_PHASE_IDLE;
+// Written by the monitor on the other core: the last iteration it flagged
+// as a stall, how many it flagged and where. All three change together
+// under stallMux, and the loop copies them out under it, so a count is
+// never paired with the phase of a different stall.
+static portMUX_TYPE stallMux = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t flaggedSeq = 0;
+static uint32_t stallCount = 0;
+static uint8_t stallPhase = LOOP_PHASE_IDLE;
+static uint32_t reportedSeq = 0;
+
+// Loop side only; stalls and lastStallPhase are copied in from the above
+static LoopWatchStats stats;
+static char lastReset[40] = "power on";
+
+const char* loopPhaseName(LoopPhase p) {
+  return p < LOOP_PHASE_COUNT ? phaseNames[p] : "?";
+}
+
+// Copies the monitor's stall record into stats; returns the flagged seq
+static uint32_t copyStalls() {
+  portENTER_CRITICAL(&stallMux);
+  uint32_t flagged = flaggedSeq;
+  stats.stalls = stallCount;
+  stats.lastStallPhase = (LoopPhase)stallPhase;
+  portEXIT_CRITICAL(&stallMux);
+  return flagged;
+}
+
+void loopWatchIterationStart() {
+  iterationStartUs = micros();
+  iterationSeq++;
+  inIteration = true;
+}
+
+void loopWatchPhase(LoopPhase p) {
+  phase = p;
+  rtc.phase = p;
+}
+
+void loopWatchIterationEnd() {
+  uint32_t us = micros() - iterationStartUs;
+  inIteration = false;
+  loopWatchPhase(LOOP_PHASE_IDLE);
+
+  stats.iterations++;
+  if (us > stats.slowestUs) stats.slowestUs = us;
+  uint32_t ms = us / 1000;
+  uint32_t limit = 1;
+  int bucket = 0;
+  while (bucket < loopHistBuckets - 1 && ms >= limit) {
+    bucket++;
+    limit *= 4;
+  }
+  stats.histogram[bucket]++;
+
+  uint32_t flagged = copyStalls();
+  if (flagged != reportedSeq) {
+    reportedSeq = flagged;
+    logPrintf("Loop stall: %lu ms, stuck in %s\n", (unsigned long)ms,
+              loopPhaseName(stats.lastStallPhase));
+  }
+}
+
+const LoopWatchStats& loopWatchStats() {
+  copyStalls();
+  return stats;
+}
+
+const char* loopWatchLastReset() {
+  return lastReset;
+}
+
+#if ENABLE_LOOP_WATCHDOG
+
+static void monitorTask(void*) {
+  esp_task_wdt_add(nullptr);
+  for (;;) {
+    vTaskDelay(pdMS_TO_TICKS(LOOP_WATCH_POLL_MS));
+    esp_task_wdt_reset();
+    if (!inIteration) continue;
+    uint32_t seq = iterationSeq;
+    uint32_t ms = (micros() - iterationStartUs) / 1000;
+    if (ms >= LOOP_STALL_MS && flaggedSeq != seq) {
+      portENTER_CRITICAL(&stallMux);
+      stallCount++;
+      stallPhase = phase;
+      flaggedSeq = seq;
+      portEXIT_CRITICAL(&stallMux);
+    }
+    if (ms >= LOOP_HANG_MS) {
+      // Restart here rather than wait for the task watchdog, whose panic
+      // behaviour depends on how the core was configured
+      rtc.phase = phase;
+      rtc.hangMs = ms;
+      rtc.hung = 1;
+      rtc.magic = rtcMagic;
+      esp_restart();
+    }
+  }
+}
+
+void loopWatchBegin() {
+  esp_reset_reason_t reason = esp_reset_reason();
+  bool valid = rtc.magic == rtcMagic && rtc.phase < LOOP_PHASE_COUNT;
+  const char* where = valid ? loopPhaseName((LoopPhase)rtc.phase) : "?";
+  if (reason == ESP_RST_SW && valid && rtc.hung) {
+    snprintf(lastReset, sizeof(lastReset), "hang %s %lus", where, (unsigned long)(rtc.hangMs / 1000));
+  } else if (reason == ESP_RST_TASK_WDT || reason == ESP_RST_INT_WDT || reason == ESP_RST_WDT) {
+    snprintf(lastReset, sizeof(lastReset), "wdt %s", where);
+  } else if (reason == ESP_RST_PANIC) {
+    snprintf(lastReset, sizeof(lastReset), "panic %s", where);
+  } else if (reason == ESP_RST_BROWNOUT) {
+    snprintf(lastReset, sizeof(lastReset), "brownout");
+  } else if (reason == ESP_RST_SW) {
+    snprintf(lastReset, sizeof(lastReset), "restart");
+  }
+  logPrintf("Last reset: %s\n", lastReset);
+  rtc.magic = rtcMagic;
+  rtc.hung = 0;
+  rtc.phase = LOOP_PHASE_IDLE;
+
+  // Normally already started by the core at boot, in which case this
+  // fails and its timeout stays
+  esp_task_wdt_init(LOOP_WDT_TIMEOUT_S, true);
+  xTaskCreatePinnedToCore(monitorTask, "loopwatch", 2048, nullptr, 2, nullptr, 0);
+}
+
+#else
+
+void loopWatchBegin() {
+  snprintf(lastReset, sizeof(lastReset), "not monitored");
+}
+
+#endif
@@ -6,41 +6,78 @@
  * - Main page: Three horizontal boxes with icons for Temp, Humidity, Pressure
  * - Press T for Temperature graph, H for Humidity graph, P for Pressure graph
  * - Press ESC (` or ~) to return to main page
- * - 1 hour history graphs
+ * - 1 hour history graphs, with the same hour yesterday drawn faintly behind
+ * - Press Y for a year of daily min/max/mean, W for an hour x weekday heatmap
+ *   (T/H/P there pick the metric)
+ * - Press C for a temperature vs humidity density plot with comfort zones
  * - Configurable screen timeout (10s, 30s, or Always On)
  */
 
 #include <M5Cardputer.h>
 #include <M5Unified.hpp>
 #include <M5UnitENV.h>
+#include <LittleFS.h>
+#include <Preferences.h>
+#include <SD.h>
 
-SHT3X sht30;
+#include "adaptive_sampler.h"
+#include "ble_ess.h"
+#include "colormap.h"
+#include "config.h"
+#include "daily_archive.h"
+#include "density_grid.h"
+#include "display_filter.h"
+#include "energy_model.h"
+#include "hampel.h"
+#include "history.h"
+#include "influx_writer.h"
+#include "log_sink.h"
+#include "loop_watchdog.h"
+#include "metrics_server.h"
+#include "mqtt_publisher.h"
+#include "pressure_profile.h"
+#include "render_probe.h"
+#include "sd_logger.h"
+#include "self_bench.h"
+#include "serial_proto.h"
+#include "sht30_periodic.h"
+#include "smoothing.h"
+#include "trace.h"
+#include "wallclock.h"
+#include "week_heatmap.h"
+#include "wifi_link.h"
+
+Sht30WireBus sht30Bus(Wire);
+Sht30Periodic sht30;
 QMP6988 qmp6988;
+uint8_t qmpAddress = 0;  // I2C address the QMP6988 answered on, 0 if none
 
 // Current readings
 float temperature = 0.0;
 float humidity = 0.0;
 float pressure = 0.0;
-// Previous displayed values (to detect changes)
-float dispTemp = -999.0;
-float dispHumidity = -999.0;
-float dispPressure = -999.0;
-// History for graphs (last 60 readings = ~1 hour at 1/min)
-const int historySize = 60;
-float tempHistory[historySize];
-float humidityHistory[historySize];
-float pressureHistory[historySize];
-int historyIndex = 0;
-int historyCount = 0;
-unsigned long lastHistoryUpdate = 0;
-const unsigned long historyInterval = 60000;  // 1 minute
+// Displayed values (redrawn only when their text changes)
+DisplayFilter dispTemp = {0.1f, false, 0, 0};
+DisplayFilter dispHumidity = {1.0f, false, 0, 0};
+DisplayFilter dispPressure = {1.0f, false, 0, 0};
+// History timing (samples live in history.cpp)
+unsigned long lastHistoryUpdate[METRIC_COUNT];
+unsigned long lastArchiveUpdate = 0;
+const unsigned long archiveInterval = 60000;  // Daily, heatmap and density
+unsigned long lastShtRead = 0;       // Last good SHT30 reading
+unsigned long lastPressureRead = 0;  // Last good QMP6988 reading
 
+// Draw target for all pages: the panel, or an off-screen canvas when probing
+lgfx::LovyanGFX* gfx = nullptr;
 // Screen dimensions (Cardputer: 240x135)
 int screenW;
 int screenH;
 // Page management
-// 0 = main, 1 = temp graph, 2 = humidity graph, 3 = pressure graph, 4 = settings
+// 0 = main, 1 = temp graph, 2 = humidity graph, 3 = pressure graph, 4 = settings,
+// 5 = year, 6 = week heatmap, 7 = density, 8 = diagnostics
 int currentPage = 0;
+// Metric shown on the year and week pages
+Metric summaryMetric = METRIC_TEMP;
 // Screen timeout
 unsigned long lastActivityTime = 0;
 int normalBrightness = 80;
@@ -57,6 +94,10 @@ unsigned long lastFlashTime = 0;
 const int flashInterval = 500;
 int prevBatteryLevel = -1;
 bool prevCharging = false;
+#ifdef RENDER_PROBE
+int probeBatteryLevel = -1;  // Fixed battery level while probing (-1 = read PMIC)
+bool probeFixedDiag = false;  // Placeholder diagnostics values while probing
+#endif
 // UI constants for horizontal layout
 const int boxWidth = 72;
 const int boxHeight = 85;
@@ -79,15 +120,28 @@ const uint16_t COLOR_PRESSURE = 0xD01F;  // Purple
 
 // Flag for redraw
 bool needsFullRedraw = true;
-// Graph page - stored current value for partial update
-float graphDispValue = -999.0;
+// Graph page - displayed current value for partial update
+DisplayFilter graphDispValue = {0.1f, false, 0, 0};
 
 // Settings
 bool useFahrenheit = false;
 // Screen timeout options: 0 = 10s, 1 = 30s, 2 = Always On
 int screenTimeoutOption = 2;  // Default to Always On
 const unsigned long screenTimeoutValues[] = {10000, 30000, 0};  // 0 means always on
-int settingsSelection = 0;  // 0 = brightness, 1 = temp unit, 2 = screen timeout
+// Smoothing of the raw readings: SmoothMode, and index into smoothTaus
+int smoothingMode = SMOOTH_OFF;
+int smoothTimeOption = 1;
+// QMP6988 acquisition: PressureProfile
+int pressureProfile = PRESSURE_BALANCED;
+// 0 = brightness, 1 = temp unit, 2 = screen timeout, 3 = smoothing,
+// 4 = time constant, 5 = pressure profile
+int settingsSelection = 0;
+const int settingsCount = 6;
+const int settingsVisible = 3;  // Rows on screen; the list scrolls
+const int settingsItemHeight = 35;
+int settingsScroll = 0;
+// Settings survive reboots in NVS
+Preferences prefs;
 
 //----------------------------------------------------------
 // Utility Functions
@@ -98,26 +152,26 @@ int getTextWidth(const char* text, int textSize) {
 }
 
 void drawCenteredText(const char* text, int y, int textSize, uint16_t color) {
-  M5Cardputer.Display.setTextSize(textSize);
-  M5Cardputer.Display.setTextColor(color);
+  gfx->setTextSize(textSize);
+  gfx->setTextColor(color);
   int textW = getTextWidth(text, textSize);
   int x = (screenW - textW) / 2;
-  M5Cardputer.Display.setCursor(x, y);
-  M5Cardputer.Display.print(text);
+  gfx->setCursor(x, y);
+  gfx->print(text);
 }
 
 void drawCenteredTextInBox(const char* text, int boxX, int boxW, int y, int textSize, uint16_t color) {
-  M5Cardputer.Display.setTextSize(textSize);
-  M5Cardputer.Display.setTextColor(color);
+  gfx->setTextSize(textSize);
+  gfx->setTextColor(color);
   int textW = getTextWidth(text, textSize);
   int x = boxX + (boxW - textW) / 2;
-  M5Cardputer.Display.setCursor(x, y);
-  M5Cardputer.Display.print(text);
+  gfx->setCursor(x, y);
+  gfx->print(text);
 }
 
 void drawThickRoundRect(int x, int y, int w, int h, int radius, int thickness, uint16_t color) {
   for (int i = 0; i < thickness; i++) {
-    M5Cardputer.Display.drawRoundRect(x + i, y + i, w - (i * 2), h - (i * 2), radius, color);
+    gfx->drawRoundRect(x + i, y + i, w - (i * 2), h - (i * 2), radius, color);
   }
 }
 
@@ -143,45 +197,45 @@ const char* getTempUnit() {
 // Thermometer icon for Temperature
 void drawThermometerIcon(int cx, int cy, uint16_t color) {
   // Bulb at bottom
-  M5Cardputer.Display.fillCircle(cx, cy + 8, 6, color);
+  gfx->fillCircle(cx, cy + 8, 6, color);
   // Stem
-  M5Cardputer.Display.fillRoundRect(cx - 3, cy - 10, 6, 18, 2, color);
+  gfx->fillRoundRect(cx - 3, cy - 10, 6, 18, 2, color);
   // Inner darker area (cutout effect)
-  M5Cardputer.Display.fillCircle(cx, cy + 8, 3, TFT_BLACK);
-  M5Cardputer.Display.fillRect(cx - 1, cy - 6, 2, 12, TFT_BLACK);
+  gfx->fillCircle(cx, cy + 8, 3, TFT_BLACK);
+  gfx->fillRect(cx - 1, cy - 6, 2, 12, TFT_BLACK);
   // Mercury level
-  M5Cardputer.Display.fillCircle(cx, cy + 8, 2, color);
-  M5Cardputer.Display.fillRect(cx - 1, cy - 2, 2, 10, color);
+  gfx->fillCircle(cx, cy + 8, 2, color);
+  gfx->fillRect(cx - 1, cy - 2, 2, 10, color);
 }
 
 // Water droplet icon for Humidity
 void drawDropletIcon(int cx, int cy, uint16_t color) {
   // Draw a droplet shape using triangles and circle
   // Bottom circle
-  M5Cardputer.Display.fillCircle(cx, cy + 4, 7, color);
+  gfx->fillCircle(cx, cy + 4, 7, color);
   // Top triangle part
-  M5Cardputer.Display.fillTriangle(cx, cy - 12, cx - 7, cy + 2, cx + 7, cy + 2, color);
+  gfx->fillTriangle(cx, cy - 12, cx - 7, cy + 2, cx + 7, cy + 2, color);
   // Inner highlight
-  M5Cardputer.Display.fillCircle(cx - 2, cy + 2, 2, TFT_WHITE);
+  gfx->fillCircle(cx - 2, cy + 2, 2, TFT_WHITE);
 }
 
 // Barometer/gauge icon for Pressure
 void drawBarometerIcon(int cx, int cy, uint16_t color) {
   // Outer circle (gauge face)
-  M5Cardputer.Display.fillCircle(cx, cy, 10, color);
-  M5Cardputer.Display.fillCircle(cx, cy, 7, TFT_BLACK);
+  gfx->fillCircle(cx, cy, 10, color);
+  gfx->fillCircle(cx, cy, 7, TFT_BLACK);
   // Tick marks
-  M5Cardputer.Display.drawLine(cx - 6, cy, cx - 4, cy, color);
+  gfx->drawLine(cx - 6, cy, cx - 4, cy, color);
   // Left
-  M5Cardputer.Display.drawLine(cx + 4, cy, cx + 6, cy, color);
+  gfx->drawLine(cx + 4, cy, cx + 6, cy, color);
   // Right
-  M5Cardputer.Display.drawLine(cx, cy - 6, cx, cy - 4, color);
+  gfx->drawLine(cx, cy - 6, cx, cy - 4, color);
   // Top
   // Needle pointing to high pressure (upper right)
-  M5Cardputer.Display.drawLine(cx, cy, cx + 4, cy - 4, color);
-  M5Cardputer.Display.drawLine(cx, cy, cx + 5, cy - 3, color);
+  gfx->drawLine(cx, cy, cx + 4, cy - 4, color);
+  gfx->drawLine(cx, cy, cx + 5, cy - 3, color);
   // Center dot
-  M5Cardputer.Display.fillCircle(cx, cy, 2, color);
+  gfx->fillCircle(cx, cy, 2, color);
 }
 
 //----------------------------------------------------------
@@ -196,16 +250,23 @@ uint16_t getBatteryColor(int level, bool isCharging) {
 }
 
 void drawLightningBolt(int x, int y, uint16_t color) {
-  M5Cardputer.Display.drawLine(x + 4, y, x + 1, y + 4, color);
-  M5Cardputer.Display.drawLine(x + 1, y + 4, x + 3, y + 4, color);
-  M5Cardputer.Display.drawLine(x + 3, y + 4, x, y + 8, color);
-  M5Cardputer.Display.drawLine(x + 5, y, x + 2, y + 4, color);
-  M5Cardputer.Display.drawLine(x + 4, y + 4, x + 1, y + 8, color);
+  gfx->drawLine(x + 4, y, x + 1, y + 4, color);
+  gfx->drawLine(x + 1, y + 4, x + 3, y + 4, color);
+  gfx->drawLine(x + 3, y + 4, x, y + 8, color);
+  gfx->drawLine(x + 5, y, x + 2, y + 4, color);
+  gfx->drawLine(x + 4, y + 4, x + 1, y + 8, color);
 }
 
 void drawBattery(bool forceRedraw) {
+  TRACE_SCOPE(TRACE_BATTERY);
   int batteryLevel = M5Cardputer.Power.getBatteryLevel();
   bool isCharging = M5Cardputer.Power.isCharging();
+#ifdef RENDER_PROBE
+  if (probeBatteryLevel >= 0) {
+    batteryLevel = probeBatteryLevel;
+    isCharging = false;
+  }
+#endif
   if (batteryLevel <= 10 && !isCharging) {
     unsigned long now = millis();
     if (now - lastFlashTime >= flashInterval) {
@@ -225,29 +286,29 @@ void drawBattery(bool forceRedraw) {
   
   int battX = screenW - 55;
   int battY = 3;
-  M5Cardputer.Display.fillRect(battX - 3, battY - 1, 58, 14, TFT_BLACK);
+  gfx->fillRect(battX - 3, battY - 1, 58, 14, TFT_BLACK);
   
   if (!batteryFlashOn) return;
   
   uint16_t battColor = getBatteryColor(batteryLevel, isCharging);
   int battW = 22;
   int battH = 10;
-  M5Cardputer.Display.drawRect(battX, battY, battW, battH, battColor);
-  M5Cardputer.Display.fillRect(battX + battW, battY + 2, 2, 6, battColor);
+  gfx->drawRect(battX, battY, battW, battH, battColor);
+  gfx->fillRect(battX + battW, battY + 2, 2, 6, battColor);
   
   int fillW = map(batteryLevel, 0, 100, 0, battW - 4);
   if (fillW > 0) {
-    M5Cardputer.Display.fillRect(battX + 2, battY + 2, fillW, battH - 4, battColor);
+    gfx->fillRect(battX + 2, battY + 2, fillW, battH - 4, battColor);
   }
   
   if (isCharging) {
     drawLightningBolt(battX + 6, battY + 1, TFT_BLACK);
   }
   
-  M5Cardputer.Display.setTextSize(1);
-  M5Cardputer.Display.setTextColor(battColor);
-  M5Cardputer.Display.setCursor(battX + 26, battY + 1);
-  M5Cardputer.Display.printf("%d%%", batteryLevel);
+  gfx->setTextSize(1);
+  gfx->setTextColor(battColor);
+  gfx->setCursor(battX + 26, battY + 1);
+  gfx->printf("%d%%", batteryLevel);
 }
 
 //----------------------------------------------------------
@@ -268,7 +329,7 @@ void updateScreenTimeout() {
   if (screenState == SCREEN_ON && elapsed >= timeoutDuration) {
     M5Cardputer.Display.setBrightness(0);
     screenState = SCREEN_OFF;
-    Serial.println("Screen off");
+    logPrintln("Screen off");
   }
 }
 
@@ -278,7 +339,7 @@ void wakeScreen() {
     M5Cardputer.Display.setBrightness(normalBrightness);
     screenState = SCREEN_ON;
     needsFullRedraw = true;
-    Serial.println("Screen wake");
+    logPrintln("Screen wake");
   }
 }
 
@@ -287,7 +348,8 @@ void wakeScreen() {
 //----------------------------------------------------------
 
 void drawMainPageStatic() {
-  M5Cardputer.Display.fillScreen(TFT_BLACK);
+  TRACE_SCOPE(TRACE_DRAW_MAIN);
+  gfx->fillScreen(TFT_BLACK);
   drawBattery(true);
   
   // Temperature box
@@ -303,34 +365,33 @@ void drawMainPageStatic() {
   drawBarometerIcon(pressBoxX + boxWidth/2, boxY + 22, COLOR_PRESSURE);
   
   // Reset displayed values to force redraw
-  dispTemp = -999.0;
-  dispHumidity = -999.0;
-  dispPressure = -999.0;
+  displayFilterReset(dispTemp);
+  displayFilterReset(dispHumidity);
+  displayFilterReset(dispPressure);
 }
 
-void updateSingleBoxValue(int boxX, float value, float &dispValue, 
+void updateSingleBoxValue(int boxX, float value, DisplayFilter &dispValue,
                           uint16_t color, const char* format, const char* unit) {
-  // Only update if value changed (with small tolerance)
-  float diff = value - dispValue;
-  if (diff < 0) diff = -diff;
-  if (diff < 0.05) return;
+  // Only update if the displayed text changes
+  if (!displayFilterUpdate(dispValue, value)) return;
   
-  dispValue = value;
   int valueY = boxY + 45;
   int unitY = boxY + 68;
   // Clear value and unit area
   int clearX = boxX + boxBorderWidth + 2;
   int clearW = boxWidth - (boxBorderWidth * 2) - 4;
-  M5Cardputer.Display.fillRect(clearX, valueY - 2, clearW, 35, TFT_BLACK);
+  gfx->fillRect(clearX, valueY - 2, clearW, 35, TFT_BLACK);
+  energyAddSpiBytes(clearW * 35 * 2);
   // Draw the value
   char buf[15];
-  sprintf(buf, format, value);
+  sprintf(buf, format, dispValue.shown);
   drawCenteredTextInBox(buf, boxX, boxWidth, valueY, 2, color);
   // Draw the unit
   drawCenteredTextInBox(unit, boxX, boxWidth, unitY, 1, color);
 }
 
 void updateMainPageValues() {
+  TRACE_SCOPE(TRACE_UPDATE_MAIN);
   updateSingleBoxValue(tempBoxX, getDisplayTemp(temperature), dispTemp, COLOR_TEMP, "%.1f", getTempUnit());
   updateSingleBoxValue(humidBoxX, humidity, dispHumidity, COLOR_HUMIDITY, "%.0f", "%");
   updateSingleBoxValue(pressBoxX, pressure, dispPressure, COLOR_PRESSURE, "%.0f", "hPa");
@@ -341,21 +402,38 @@ void updateMainPageValues() {
 // Graph Page
 //----------------------------------------------------------
 
-void drawGraphPageStatic(const char* title, float* history, uint16_t color, const char* unit, float currentVal, bool convertToF = false) {
-  M5Cardputer.Display.fillScreen(TFT_BLACK);
+// Time shown on each graph page: an hour of temperature and humidity, six
+// hours of the slower pressure bins
+const uint32_t graphSpanSec[METRIC_COUNT] = {3600, 3600, 21600};
+
+// Samples across a graph page
+int graphSamples(Metric metric) {
+  return graphSpanSec[metric] * 1000 / historyIntervals[metric];
+}
+
+// History sample i in display units
+float graphValue(Metric metric, int i, bool convertToF) {
+  float val = historyValue(metric, i);
+  if (convertToF) val = (val * 9.0 / 5.0) + 32.0;
+  return val;
+}
+
+void drawGraphPageStatic(const char* title, Metric metric, uint16_t color, const char* unit, float currentVal, bool convertToF = false) {
+  TRACE_SCOPE(TRACE_DRAW_GRAPH);
+  gfx->fillScreen(TFT_BLACK);
   drawBattery(true);
   
   // Title and current value at top
-  M5Cardputer.Display.setTextSize(1);
-  M5Cardputer.Display.setTextColor(color);
-  M5Cardputer.Display.setCursor(5, 5);
-  M5Cardputer.Display.print(title);
+  gfx->setTextSize(1);
+  gfx->setTextColor(color);
+  gfx->setCursor(5, 5);
+  gfx->print(title);
   // Current value next to title
   char valBuf[20];
   sprintf(valBuf, "%.1f %s", currentVal, unit);
   int titleWidth = strlen(title) * 6;
-  M5Cardputer.Display.setCursor(5 + titleWidth + 10, 5);
-  M5Cardputer.Display.print(valBuf);
+  gfx->setCursor(5 + titleWidth + 10, 5);
+  gfx->print(valBuf);
   
   // Graph area (leave room for labels)
   int graphX = 30;
@@ -363,31 +441,41 @@ void drawGraphPageStatic(const char* title, float* history, uint16_t color, cons
   int graphW = screenW - 35;
   int graphH = screenH - 45;
   // Graph border
-  M5Cardputer.Display.drawRect(graphX, graphY, graphW, graphH, TFT_DARKGREY);
+  gfx->drawRect(graphX, graphY, graphW, graphH, TFT_DARKGREY);
   
   // X-axis labels
-  M5Cardputer.Display.setTextSize(1);
-  M5Cardputer.Display.setTextColor(TFT_DARKGREY);
-  M5Cardputer.Display.setCursor(graphX, graphY + graphH + 3);
-  M5Cardputer.Display.print("-1hr");
-  M5Cardputer.Display.setCursor(graphX + graphW - 18, graphY + graphH + 3);
-  M5Cardputer.Display.print("now");
+  gfx->setTextSize(1);
+  gfx->setTextColor(TFT_DARKGREY);
+  gfx->setCursor(graphX, graphY + graphH + 3);
+  gfx->printf("-%luhr", (unsigned long)(graphSpanSec[metric] / 3600));
+  gfx->setCursor(graphX + graphW - 18, graphY + graphH + 3);
+  gfx->print("now");
   // ESC hint at bottom left
-  M5Cardputer.Display.setCursor(5, screenH - 10);
-  M5Cardputer.Display.print("ESC:back");
-  if (historyCount > 1) {
-    // Find min/max for scaling (with conversion if needed)
+  gfx->setCursor(5, screenH - 10);
+  gfx->print("ESC:back");
+  int count = historyCount(metric);
+  int window = graphSamples(metric);
+  // Newest window of samples, and the same stretch 24 h earlier when the
+  // ring reaches back that far
+  int first = count > window ? count - window : 0;
+  int shown = count - first;
+  int dayAgo = -1;
+  if (shown > 1 && historyTime(metric, first) >= 86400) {
+    dayAgo = historyAt(metric, historyTime(metric, first) - 86400);
+  }
+  if (count > 1) {
+    // One scale for both series
     float graphMin, graphMax;
-    int firstIdx = (historyIndex - historyCount + historySize) % historySize;
-    float firstVal = history[firstIdx];
-    if (convertToF) firstVal = (firstVal * 9.0 / 5.0) + 32.0;
-    graphMin = graphMax = firstVal;
-    for (int i = 0; i < historyCount; i++) {
-      int idx = (historyIndex - historyCount + i + historySize) % historySize;
-      float val = history[idx];
-      if (convertToF) val = (val * 9.0 / 5.0) + 32.0;
+    graphMin = graphMax = graphValue(metric, first, convertToF);
+    for (int i = 0; i < shown; i++) {
+      float val = graphValue(metric, first + i, convertToF);
       if (val < graphMin) graphMin = val;
       if (val > graphMax) graphMax = val;
+      if (dayAgo >= 0) {
+        float old = graphValue(metric, dayAgo + i, convertToF);
+        if (old < graphMin) graphMin = old;
+        if (old > graphMax) graphMax = old;
+      }
     }
     
     // Add padding
@@ -405,171 +493,803 @@ void drawGraphPageStatic(const char* title, float* history, uint16_t color, cons
     }
     
     // Y axis labels
-    M5Cardputer.Display.setTextColor(TFT_DARKGREY);
-    M5Cardputer.Display.setTextSize(1);
+    gfx->setTextColor(TFT_DARKGREY);
+    gfx->setTextSize(1);
     char labelBuf[10];
     
     sprintf(labelBuf, "%.0f", graphMax);
-    M5Cardputer.Display.setCursor(2, graphY);
-    M5Cardputer.Display.print(labelBuf);
+    gfx->setCursor(2, graphY);
+    gfx->print(labelBuf);
     
     sprintf(labelBuf, "%.0f", graphMin);
-    M5Cardputer.Display.setCursor(2, graphY + graphH - 8);
-    M5Cardputer.Display.print(labelBuf);
-    // Draw the line graph
-    int prevPx = 0, prevPy = 0;
-    for (int i = 0; i < historyCount; i++) {
-      int idx = (historyIndex - historyCount + i + historySize) % historySize;
-      float val = history[idx];
-      if (convertToF) val = (val * 9.0 / 5.0) + 32.0;
-      int px = graphX + 2 + (i * (graphW - 4)) / (historySize - 1);
-      int py = graphY + graphH - 2 - (int)((val - graphMin) / range * (graphH - 4));
-      M5Cardputer.Display.fillCircle(px, py, 1, color);
+    gfx->setCursor(2, graphY + graphH - 8);
+    gfx->print(labelBuf);
+    // Draw both lines in one pass: yesterday faint, today on top
+    uint16_t faint = (color >> 1) & 0x7BEF;
+    int prevPx = 0, prevPy = 0, prevOy = 0;
+    for (int i = 0; i < shown; i++) {
+      int px = graphX + 2 + (i * (graphW - 4)) / (window - 1);
+      int py = graphY + graphH - 2 - (int)((graphValue(metric, first + i, convertToF) - graphMin) / range * (graphH - 4));
+      if (dayAgo >= 0) {
+        int oy = graphY + graphH - 2 - (int)((graphValue(metric, dayAgo + i, convertToF) - graphMin) / range * (graphH - 4));
+        if (i > 0) gfx->drawLine(prevPx, prevOy, px, oy, faint);
+        prevOy = oy;
+      }
+      gfx->fillCircle(px, py, 1, color);
       
       if (i > 0) {
-        M5Cardputer.Display.drawLine(prevPx, prevPy, px, py, color);
+        gfx->drawLine(prevPx, prevPy, px, py, color);
       }
       prevPx = px;
       prevPy = py;
     }
+    if (dayAgo >= 0) {
+      gfx->setTextColor(faint);
+      gfx->setCursor(60, screenH - 10);
+      gfx->print("-24h");
+    }
     
   } else {
     drawCenteredText("Collecting...", graphY + graphH/2 - 8, 1, TFT_DARKGREY);
   }
   
   // Reset displayed value
-  graphDispValue = -999.0;
+  displayFilterReset(graphDispValue);
 }
 
 void updateGraphValue(float value, uint16_t color, const char* unit, const char* title) {
-  // Only update if value changed
-  float diff = value - graphDispValue;
-  if (diff < 0) diff = -diff;
-  if (diff < 0.05) return;
+  TRACE_SCOPE(TRACE_UPDATE_GRAPH);
+  // Only update if the displayed text changes
+  if (!displayFilterUpdate(graphDispValue, value)) return;
   
-  graphDispValue = value;
   // Current value displayed at top next to title
   int titleWidth = strlen(title) * 6;
   int valX = 5 + titleWidth + 10;
   
   // Clear the value area
-  M5Cardputer.Display.fillRect(valX, 3, 70, 12, TFT_BLACK);
+  gfx->fillRect(valX, 3, 70, 12, TFT_BLACK);
+  energyAddSpiBytes(70 * 12 * 2);
   // Draw current value
   char valBuf[20];
-  sprintf(valBuf, "%.1f %s", value, unit);
-  M5Cardputer.Display.setTextSize(1);
-  M5Cardputer.Display.setTextColor(color);
-  M5Cardputer.Display.setCursor(valX, 5);
-  M5Cardputer.Display.print(valBuf);
+  sprintf(valBuf, "%.1f %s", graphDispValue.shown, unit);
+  gfx->setTextSize(1);
+  gfx->setTextColor(color);
+  gfx->setCursor(valX, 5);
+  gfx->print(valBuf);
+}
+
+//----------------------------------------------------------
+// Year Page
+//----------------------------------------------------------
+
+// Daily min..max bars and mean for the last 365 days, straight from the
+// daily archive (one small read per day, no raw history involved)
+void drawYearPageStatic() {
+  TRACE_SCOPE(TRACE_DRAW_YEAR);
+  static const char* titles[] = {"YEAR: TEMP", "YEAR: HUMIDITY", "YEAR: PRESSURE"};
+  static const uint16_t colors[] = {COLOR_TEMP, COLOR_HUMIDITY, COLOR_PRESSURE};
+  const int days = 365;
+  uint16_t color = colors[summaryMetric];
+  bool convertToF = summaryMetric == METRIC_TEMP && useFahrenheit;
+  const char* unit = summaryMetric == METRIC_TEMP ? getTempUnit() : (summaryMetric == METRIC_HUMIDITY ? "%" : "hPa");
+
+  gfx->fillScreen(TFT_BLACK);
+  drawBattery(true);
+  gfx->setTextSize(1);
+  gfx->setTextColor(color);
+  gfx->setCursor(5, 5);
+  gfx->print(titles[summaryMetric]);
+
+  int graphX = 30;
+  int graphY = 18;
+  int graphW = screenW - 35;
+  int graphH = screenH - 45;
+  gfx->drawRect(graphX, graphY, graphW, graphH, TFT_DARKGREY);
+  gfx->setTextColor(TFT_DARKGREY);
+  gfx->setCursor(graphX, graphY + graphH + 3);
+  gfx->print("-1yr");
+  gfx->setCursor(graphX + graphW - 30, graphY + graphH + 3);
+  gfx->print("today");
+  gfx->setCursor(5, screenH - 10);
+  gfx->print("ESC:back");
+
+  uint32_t today = dailyToday();
+  if (today == 0) {
+    drawCenteredText("Clock not set", graphY + graphH/2 - 8, 1, TFT_DARKGREY);
+    return;
+  }
+
+  // Fold the days into one column per pixel
+  const int cols = graphW - 4;
+  static float colMin[240];
+  static float colMax[240];
+  static float colSum[240];
+  static uint8_t colDays[240];
+  memset(colDays, 0, sizeof(colDays));
+  float graphMin = 0, graphMax = 0;
+  bool any = false;
+  for (int d = 0; d < days; d++) {
+    DaySummary s;
+    if (!dailyGet(today - (days - 1) + d, s)) continue;
+    const DayStats& st = s.metric[summaryMetric];
+    float lo = st.min, hi = st.max, mean = st.mean;
+    if (convertToF) {
+      lo = (lo * 9.0 / 5.0) + 32.0;
+      hi = (hi * 9.0 / 5.0) + 32.0;
+      mean = (mean * 9.0 / 5.0) + 32.0;
+    }
+    int c = d * cols / days;
+    if (colDays[c] == 0 || lo < colMin[c]) colMin[c] = lo;
+    if (colDays[c] == 0 || hi > colMax[c]) colMax[c] = hi;
+    colSum[c] = (colDays[c] == 0 ? 0 : colSum[c]) + mean;
+    colDays[c]++;
+    if (!any || lo < graphMin) graphMin = lo;
+    if (!any || hi > graphMax) graphMax = hi;
+    any = true;
+  }
+  if (!any) {
+    drawCenteredText("No daily data yet", graphY + graphH/2 - 8, 1, TFT_DARKGREY);
+    return;
+  }
+
+  float range = graphMax - graphMin;
+  if (range < 2.0) {
+    float mid = (graphMax + graphMin) / 2.0;
+    graphMin = mid - 1.0;
+    graphMax = mid + 1.0;
+    range = 2.0;
+  }
+  char labelBuf[10];
+  sprintf(labelBuf, "%.0f", graphMax);
+  gfx->setCursor(2, graphY);
+  gfx->print(labelBuf);
+  sprintf(labelBuf, "%.0f", graphMin);
+  gfx->setCursor(2, graphY + graphH - 8);
+  gfx->print(labelBuf);
+
+  for (int c = 0; c < cols; c++) {
+    if (colDays[c] == 0) continue;
+    int px = graphX + 2 + c;
+    int yHi = graphY + graphH - 2 - (int)((colMax[c] - graphMin) / range * (graphH - 4));
+    int yLo = graphY + graphH - 2 - (int)((colMin[c] - graphMin) / range * (graphH - 4));
+    int yMean = graphY + graphH - 2 - (int)((colSum[c] / colDays[c] - graphMin) / range * (graphH - 4));
+    gfx->drawFastVLine(px, yHi, yLo - yHi + 1, color);
+    gfx->drawPixel(px, yMean, TFT_WHITE);
+  }
+
+  // Same day last week, from the archive as well
+  DaySummary now, weekAgo;
+  if (dailyGet(today, now) && dailyGet(today - 7, weekAgo)) {
+    float a = now.metric[summaryMetric].mean;
+    float b = weekAgo.metric[summaryMetric].mean;
+    if (convertToF) {
+      a = (a * 9.0 / 5.0) + 32.0;
+      b = (b * 9.0 / 5.0) + 32.0;
+    }
+    char cmpBuf[40];
+    sprintf(cmpBuf, "avg %.1f, -7d %.1f %s", a, b, unit);
+    gfx->setTextColor(color);
+    gfx->setCursor(60, screenH - 10);
+    gfx->print(cmpBuf);
+  }
+}
+
+//----------------------------------------------------------
+// Week Heatmap Page
+//----------------------------------------------------------
+
+// Mean per local hour (columns) and weekday (rows) from the heatmap
+// accumulators, colored through the colormap lookup table
+void drawWeekPageStatic() {
+  TRACE_SCOPE(TRACE_DRAW_WEEK);
+  static const char* titles[] = {"WEEK: TEMP", "WEEK: HUMIDITY", "WEEK: PRESSURE"};
+  static const uint16_t colors[] = {COLOR_TEMP, COLOR_HUMIDITY, COLOR_PRESSURE};
+  static const char* dayNames[] = {"Mo", "Tu", "We", "Th", "Fr", "Sa", "Su"};
+  bool convertToF = summaryMetric == METRIC_TEMP && useFahrenheit;
+
+  gfx->fillScreen(TFT_BLACK);
+  drawBattery(true);
+  gfx->setTextSize(1);
+  gfx->setTextColor(colors[summaryMetric]);
+  gfx->setCursor(5, 5);
+  gfx->print(titles[summaryMetric]);
+
+  const int gridX = 18;
+  const int gridY = 18;
+  const int cellW = 9;
+  const int cellH = 13;
+  gfx->setTextColor(TFT_DARKGREY);
+  for (int d = 0; d < heatmapDays; d++) {
+    gfx->setCursor(2, gridY + d * cellH + 3);
+    gfx->print(dayNames[d]);
+  }
+  for (int h = 0; h < heatmapHours; h += 6) {
+    gfx->setCursor(gridX + h * cellW, gridY + heatmapDays * cellH + 3);
+    gfx->print(h);
+  }
+  gfx->setCursor(5, screenH - 10);
+  gfx->print("ESC:back");
+
+  float lo, hi;
+  if (!heatmapRange(summaryMetric, lo, hi)) {
+    drawCenteredText("No data yet", gridY + heatmapDays * cellH / 2 - 4, 1, TFT_DARKGREY);
+    return;
+  }
+  for (int d = 0; d < heatmapDays; d++) {
+    for (int h = 0; h < heatmapHours; h++) {
+      float mean;
+      uint16_t color = heatmapCell(summaryMetric, d, h, mean) ? colormapColor(mean, lo, hi) : 0x2104;
+      gfx->fillRect(gridX + h * cellW, gridY + d * cellH, cellW - 1, cellH - 1, color);
+    }
+  }
+
+  // Legend: low end, color bar, high end
+  if (convertToF) {
+    lo = (lo * 9.0 / 5.0) + 32.0;
+    hi = (hi * 9.0 / 5.0) + 32.0;
+  }
+  char buf[12];
+  sprintf(buf, "%.1f", lo);
+  gfx->setCursor(70, screenH - 10);
+  gfx->print(buf);
+  int barX = 70 + strlen(buf) * 6 + 4;
+  const int barW = 64;
+  for (int i = 0; i < barW; i++) {
+    gfx->drawFastVLine(barX + i, screenH - 10, 7, colormap[i * 255 / (barW - 1)]);
+  }
+  sprintf(buf, "%.1f", hi);
+  gfx->setCursor(barX + barW + 4, screenH - 10);
+  gfx->print(buf);
+}
+
+//----------------------------------------------------------
+// Density Page
+//----------------------------------------------------------
+
+// Comfort zones drawn over the density plot (deg C, %RH; ASHRAE 55-style
+// ranges for winter and summer clothing)
+struct ComfortZone {
+  float tempLo, tempHi;
+  float humLo, humHi;
+  uint16_t color;
+};
+const ComfortZone comfortZones[] = {
+  {20.0, 23.5, 30.0, 60.0, TFT_CYAN},
+  {23.0, 26.0, 30.0, 60.0, TFT_YELLOW},
+};
+bool showComfortZones = true;
+
+// Temperature (x) against humidity (y) as density-colored cells of the 2D
+// histogram, drawn into an off-screen canvas and pushed in one go
+void drawDensityPageStatic() {
+  TRACE_SCOPE(TRACE_DRAW_DENSITY);
+  gfx->fillScreen(TFT_BLACK);
+  drawBattery(true);
+  gfx->setTextSize(1);
+  gfx->setTextColor(TFT_WHITE);
+  gfx->setCursor(5, 5);
+  gfx->print("TEMP vs HUMIDITY");
+  gfx->setTextColor(TFT_DARKGREY);
+  gfx->setCursor(110, 5);
+  gfx->print("Z:zones");
+
+  const int cellW = 4;
+  const int cellH = 2;
+  const int plotW = densityTempBins * cellW;
+  const int plotH = densityHumBins * cellH;
+  const int plotX = (screenW - plotW) / 2;
+  const int plotY = 18;
+  gfx->drawRect(plotX - 1, plotY - 1, plotW + 2, plotH + 2, TFT_DARKGREY);
+
+  char axisBuf[40];
+  sprintf(axisBuf, "T %.0f-%.0f%s  RH %.0f-%.0f%%", getDisplayTemp(densityTempMin),
+          getDisplayTemp(densityTempMax), getTempUnit(), densityHumMin, densityHumMax);
+  gfx->setCursor(5, screenH - 10);
+  gfx->print("ESC:back");
+  gfx->setCursor(65, screenH - 10);
+  gfx->print(axisBuf);
+
+  // Falls back to drawing in place if there is no memory for the canvas
+  M5Canvas canvas(&M5Cardputer.Display);
+  canvas.setColorDepth(16);
+  bool offscreen = canvas.createSprite(plotW, plotH) != nullptr;
+  lgfx::LovyanGFX* target = offscreen ? (lgfx::LovyanGFX*)&canvas : gfx;
+  int ox = offscreen ? 0 : plotX;
+  int oy = offscreen ? 0 : plotY;
+  target->fillRect(ox, oy, plotW, plotH, TFT_BLACK);
+
+  uint16_t maxCount = densityMax();
+  if (maxCount > 0) {
+    // Log scale, so rarely visited conditions still show up
+    float logMax = logf(1.0f + maxCount);
+    for (int t = 0; t < densityTempBins; t++) {
+      for (int h = 0; h < densityHumBins; h++) {
+        uint16_t n = densityCell(t, h);
+        if (n == 0) continue;
+        int i = (int)(logf(1.0f + n) / logMax * 255.0f);
+        target->fillRect(ox + t * cellW, oy + plotH - (h + 1) * cellH, cellW, cellH, colormap[i]);
+      }
+    }
+  }
+
+  if (showComfortZones) {
+    const float tempScale = plotW / (densityTempMax - densityTempMin);
+    const float humScale = plotH / (densityHumMax - densityHumMin);
+    for (const ComfortZone& z : comfortZones) {
+      int x0 = ox + (int)((z.tempLo - densityTempMin) * tempScale);
+      int x1 = ox + (int)((z.tempHi - densityTempMin) * tempScale);
+      int y0 = oy + plotH - (int)((z.humHi - densityHumMin) * humScale);
+      int y1 = oy + plotH - (int)((z.humLo - densityHumMin) * humScale);
+      target->drawRect(x0, y0, x1 - x0 + 1, y1 - y0 + 1, z.color);
+    }
+  }
+
+  if (offscreen) {
+    canvas.pushSprite(gfx, plotX, plotY);
+    canvas.deleteSprite();
+  }
+  if (maxCount == 0) drawCenteredText("No data yet", plotY + plotH/2 - 4, 1, TFT_DARKGREY);
+}
+
+//----------------------------------------------------------
+// Diagnostics Page
+//----------------------------------------------------------
+
+const int diagValueX = 130;
+const int diagLineH = 10;
+const int diagTopY = 22;
+const int diagValueChars = 17;  // Padded width of a value field
+// E and L switch from the counters to the energy estimate or loop
+// latency, and back
+enum DiagView { DIAG_COUNTERS, DIAG_ENERGY, DIAG_LOOP };
+DiagView diagView = DIAG_COUNTERS;
+
+// Uptime, memory and the counters of the display, filters and sampler
+int formatCounterDiag(char values[][24]) {
+  const DisplayCounts& hour = displayCountsLastHour();
+  const DisplayCounts& total = displayCountsTotal();
+  unsigned long up = millis() / 1000;
+  snprintf(values[0], sizeof(values[0]), "%lu:%02lu:%02lu", up / 3600, (up / 60) % 60, up % 60);
+  snprintf(values[1], sizeof(values[1]), "%lu", (unsigned long)ESP.getFreeHeap());
+  snprintf(values[2], sizeof(values[2]), "%d / %d / %d", historyCount(METRIC_TEMP),
+           historyCount(METRIC_HUMIDITY), historyCount(METRIC_PRESSURE));
+  snprintf(values[3], sizeof(values[3]), "%lu", (unsigned long)logDroppedTotal());
+  snprintf(values[4], sizeof(values[4]), "%lu", (unsigned long)hour.redraws);
+  snprintf(values[5], sizeof(values[5]), "%lu", (unsigned long)hour.avoided);
+  snprintf(values[6], sizeof(values[6]), "%lu / %lu", (unsigned long)total.redraws,
+           (unsigned long)total.avoided);
+  snprintf(values[7], sizeof(values[7]), "%lu / %lu / %lu", (unsigned long)hampelRejected(METRIC_TEMP),
+           (unsigned long)hampelRejected(METRIC_HUMIDITY), (unsigned long)hampelRejected(METRIC_PRESSURE));
+  const Sht30Stats& sht = sht30.stats();
+  snprintf(values[8], sizeof(values[8]), "%lu / %lu / %lu", (unsigned long)sht.samples,
+           (unsigned long)sht.notReady, (unsigned long)(sht.crcErrors + sht.restarts));
+  snprintf(values[9], sizeof(values[9]), "%.1f / %.1f / %.1f s", samplerIntervalMs(METRIC_TEMP) / 1000.0f,
+           samplerIntervalMs(METRIC_HUMIDITY) / 1000.0f, samplerIntervalMs(METRIC_PRESSURE) / 1000.0f);
+  return 10;
+}
+
+// Estimated draw per part since boot, the total and the battery life it gives
+int formatEnergyDiag(char values[][24]) {
+  float mAh[ENERGY_PART_COUNT];
+  energyEstimate(energyCounters(), energyDefaultCalibration, mAh);
+  float total = 0;
+  for (int i = 0; i < ENERGY_PART_COUNT; i++) {
+    snprintf(values[i], sizeof(values[i]), "%.2f mAh/h", mAh[i]);
+    total += mAh[i];
+  }
+  snprintf(values[ENERGY_PART_COUNT], sizeof(values[ENERGY_PART_COUNT]), "%.1f mAh/h", total);
+  snprintf(values[ENERGY_PART_COUNT + 1], sizeof(values[ENERGY_PART_COUNT + 1]), "%.0f h of %d mAh",
+           energyBatteryHours(mAh, BATTERY_CAPACITY_MAH), BATTERY_CAPACITY_MAH);
+  return ENERGY_PART_COUNT + 2;
+}
+
+// Iteration count, slowest, stalls, why the last boot ended and the
+// iteration time histogram
+int formatLoopDiag(char values[][24]) {
+  const LoopWatchStats& s = loopWatchStats();
+  snprintf(values[0], sizeof(values[0]), "%lu", (unsigned long)s.iterations);
+  snprintf(values[1], sizeof(values[1]), "%.1f ms", s.slowestUs / 1000.0f);
+  if (s.stalls) {
+    snprintf(values[2], sizeof(values[2]), "%lu / %s", (unsigned long)s.stalls,
+             loopPhaseName(s.lastStallPhase));
+  } else {
+    snprintf(values[2], sizeof(values[2]), "0");
+  }
+  snprintf(values[3], sizeof(values[3]), "%s", loopWatchLastReset());
+  for (int i = 0; i < loopHistBuckets; i++) {
+    snprintf(values[4 + i], sizeof(values[4 + i]), "%lu", (unsigned long)s.histogram[i]);
+  }
+  return 4 + loopHistBuckets;
+}
+
+void updateDiagPage() {
+  TRACE_SCOPE(TRACE_UPDATE_DIAG);
+  char values[10][24];
+  int lines;
+  switch (diagView) {
+    case DIAG_ENERGY:
+      lines = formatEnergyDiag(values);
+      break;
+    case DIAG_LOOP:
+      lines = formatLoopDiag(values);
+      break;
+    default:
+      lines = formatCounterDiag(values);
+      break;
+  }
+#ifdef RENDER_PROBE
+  // Live counters differ on every run; fixed text keeps the image comparable
+  if (probeFixedDiag) {
+    for (int i = 0; i < lines; i++) snprintf(values[i], sizeof(values[i]), "0");
+  }
+#endif
+
+  // Opaque text over a padded field, so nothing needs clearing first
+  gfx->setTextSize(1);
+  gfx->setTextColor(TFT_WHITE, TFT_BLACK);
+  for (int i = 0; i < lines; i++) {
+    gfx->setCursor(diagValueX, diagTopY + i * diagLineH);
+    gfx->printf("%-17s", values[i]);
+  }
+  energyAddSpiBytes(lines * diagValueChars * 6 * 8 * 2);
+}
+
+// Labels are drawn once; updateDiagPage() repaints the values in place
+void drawDiagPageStatic() {
+  TRACE_SCOPE(TRACE_DRAW_DIAG);
+  static const char* counterLabels[] = {
+    "Uptime",
+    "Free heap",
+    "History T / H / P",
+    "Log dropped",
+    "Redraws last hour",
+    "Avoided last hour",
+    "Redraws / avoided",
+    "Spikes T / H / P",
+    "SHT30 ok/wait/err",
+    "Interval T / H / P",
+  };
+  static const char* loopLabels[] = {
+    "Loop iterations",
+    "Slowest",
+    "Stalls / last in",
+    "Last reset",
+    "  < 1 ms",
+    "  1 - 4 ms",
+    "  4 - 16 ms",
+    "  16 - 64 ms",
+    "  64 - 256 ms",
+    "  >= 256 ms",
+  };
+  const char* labels[10];
+  int lines = 0;
+  const char* title = "DIAGNOSTICS";
+  if (diagView == DIAG_ENERGY) {
+    title = "ENERGY (est. since boot)";
+    for (int i = 0; i < ENERGY_PART_COUNT; i++) labels[lines++] = energyPartName((EnergyPart)i);
+    labels[lines++] = "Total";
+    labels[lines++] = "Battery life";
+  } else if (diagView == DIAG_LOOP) {
+    title = "LOOP LATENCY";
+    for (const char* label : loopLabels) labels[lines++] = label;
+  } else {
+    for (const char* label : counterLabels) labels[lines++] = label;
+  }
+  gfx->fillScreen(TFT_BLACK);
+  drawBattery(true);
+  gfx->setTextSize(1);
+  gfx->setTextColor(TFT_WHITE);
+  gfx->setCursor(5, 5);
+  gfx->print(title);
+  gfx->setTextColor(TFT_DARKGREY);
+  for (int i = 0; i < lines; i++) {
+    gfx->setCursor(5, diagTopY + i * diagLineH);
+    gfx->print(labels[i]);
+  }
+  gfx->setCursor(5, screenH - 10);
+  gfx->print("ESC:back  E:energy  L:loop");
+  updateDiagPage();
+}
+
+//----------------------------------------------------------
+// Benchmark Page (hidden: B on the main page)
+//----------------------------------------------------------
+
+// The benchmark takes a few seconds and draws over the whole screen, so it
+// only runs when asked for with B; page redraws repaint the last results
+BenchResults benchResults;
+bool benchValid = false;
+bool benchRequested = false;
+
+// Runs the self-benchmark and sends the results as one "bench ..." line
+// over serial
+void runBenchmark() {
+  BenchResults& r = benchResults;
+  gfx->fillScreen(TFT_BLACK);
+  drawCenteredText("Benchmarking...", 60, 1, TFT_WHITE);
+  benchI2c(sht30Bus, Wire, qmpAddress, r);
+  benchStorage(LittleFS, 64 * 1024, r.flashWriteKBps, r.flashReadKBps);
+  r.sdWriteKBps = r.sdReadKBps = -1;
+  if (sdLogReady()) benchStorage(SD, 256 * 1024, r.sdWriteKBps, r.sdReadKBps);
+  benchNvs(r);
+  benchDisplay(*gfx, r);
+  benchValid = true;
+
+  char record[320];
+  logWrite(record, benchFormat(record, sizeof(record), r));
+}
+
+// Lists the last results, after running the benchmark if B asked for it
+void drawBenchPageStatic() {
+  if (benchRequested) {
+    benchRequested = false;
+    runBenchmark();
+  }
+  const BenchResults& r = benchResults;
+
+  static const char* labels[] = {
+    "Fill Mpix/s",
+    "Rects / lines /s",
+    "Sprite push us",
+    "SHT30 / QMP us",
+    "Flash W / R KB/s",
+    "SD W / R KB/s",
+    "NVS commit us",
+  };
+  char values[7][24];
+  snprintf(values[0], sizeof(values[0]), "%.2f", r.fillMpixPerSec);
+  snprintf(values[1], sizeof(values[1]), "%.0f / %.0f", r.rectsPerSec, r.linesPerSec);
+  snprintf(values[2], sizeof(values[2]), "%.0f", r.spritePushUs);
+  snprintf(values[3], sizeof(values[3]), "%.0f / %.0f", r.sht30Us, r.qmp6988Us);
+  snprintf(values[4], sizeof(values[4]), "%.0f / %.0f", r.flashWriteKBps, r.flashReadKBps);
+  snprintf(values[5], sizeof(values[5]), "%.0f / %.0f", r.sdWriteKBps, r.sdReadKBps);
+  snprintf(values[6], sizeof(values[6]), "%.0f", r.nvsCommitUs);
+
+  gfx->fillScreen(TFT_BLACK);
+  drawBattery(true);
+  gfx->setTextSize(1);
+  gfx->setTextColor(TFT_WHITE);
+  gfx->setCursor(5, 5);
+  gfx->print("BENCHMARK");
+  for (int i = 0; i < 7; i++) {
+    gfx->setTextColor(TFT_DARKGREY);
+    gfx->setCursor(5, diagTopY + i * diagLineH);
+    gfx->print(labels[i]);
+    gfx->setTextColor(TFT_WHITE);
+    gfx->setCursor(diagValueX, diagTopY + i * diagLineH);
+    gfx->print(benchValid ? values[i] : "-");
+  }
+  gfx->setTextColor(TFT_DARKGREY);
+  gfx->setCursor(5, screenH - 10);
+  gfx->print("ESC:back  B:run  (-1 = n/a)");
+}
+
+//----------------------------------------------------------
+// Settings Persistence
+//----------------------------------------------------------
+
+void loadSettings() {
+  prefs.begin("cardenv", true);
+  normalBrightness = prefs.getUChar("bright", normalBrightness);
+  useFahrenheit = prefs.getBool("fahr", useFahrenheit);
+  screenTimeoutOption = prefs.getUChar("timeout", screenTimeoutOption);
+  smoothingMode = prefs.getUChar("smooth", smoothingMode);
+  smoothTimeOption = prefs.getUChar("smoothTau", smoothTimeOption);
+  pressureProfile = prefs.getUChar("pressProf", pressureProfile);
+  prefs.end();
+  // Out-of-range entries fall back to the defaults
+  if (normalBrightness < 20 || normalBrightness > 100) normalBrightness = 80;
+  if (screenTimeoutOption > 2) screenTimeoutOption = 2;
+  if (smoothingMode >= SMOOTH_MODE_COUNT) smoothingMode = SMOOTH_OFF;
+  if (smoothTimeOption >= smoothTauCount) smoothTimeOption = 1;
+  if (pressureProfile >= PRESSURE_PROFILE_COUNT) pressureProfile = PRESSURE_BALANCED;
+  smoothConfigure((SmoothMode)smoothingMode, smoothTimeOption);
+}
+
+void saveSettings() {
+  prefs.begin("cardenv", false);
+  prefs.putUChar("bright", normalBrightness);
+  prefs.putBool("fahr", useFahrenheit);
+  prefs.putUChar("timeout", screenTimeoutOption);
+  prefs.putUChar("smooth", smoothingMode);
+  prefs.putUChar("smoothTau", smoothTimeOption);
+  prefs.putUChar("pressProf", pressureProfile);
+  prefs.end();
+}
+
+// The profile decides how often the QMP6988 has a result, so it is also
+// the pressure sampler's fast bound; the sampler backs off from there
+void setPressureProfile(int profile) {
+  pressureProfile = profile;
+  pressureSetProfile((PressureProfile)profile, millis());
+#if ENABLE_ADAPTIVE_SAMPLING
+  samplerSetBounds(METRIC_PRESSURE, pressureProfilePeriodMs((PressureProfile)profile),
+                   PRESSURE_MAX_INTERVAL_MS);
+#endif
 }
 
 //----------------------------------------------------------
 // Settings Page
 //----------------------------------------------------------
 
+// Highlight and label of one settings row; returns its text color
+uint16_t drawSettingsRow(int item, int itemY, const char* label) {
+  uint16_t color = (settingsSelection == item) ? TFT_YELLOW : TFT_WHITE;
+  if (settingsSelection == item) {
+    gfx->fillRoundRect(10, itemY - 3, screenW - 20, settingsItemHeight - 2, 5, 0x2104);
+  }
+  gfx->setTextSize(1);
+  gfx->setTextColor(color);
+  gfx->setCursor(20, itemY + 5);
+  gfx->print(label);
+  return color;
+}
+
+// Row of option buttons with the selected one filled
+void drawOptionButtons(int optX, int optY, const char* const* labels, int count, int selected,
+                       int btnW, uint16_t color) {
+  for (int i = 0; i < count; i++) {
+    int btnX = optX + (i * (btnW + 3));
+    if (selected == i) {
+      gfx->fillRoundRect(btnX, optY, btnW, 14, 3, color);
+      gfx->setTextColor(TFT_BLACK);
+    } else {
+      gfx->drawRoundRect(btnX, optY, btnW, 14, 3, color);
+      gfx->setTextColor(color);
+    }
+    gfx->setCursor(btnX + (btnW - (int)strlen(labels[i]) * 6) / 2, optY + 3);
+    gfx->print(labels[i]);
+  }
+}
+
+void drawSettingsItem(int item, int itemY) {
+  switch (item) {
+    case 0: {
+      uint16_t color = drawSettingsRow(0, itemY, "Brightness:");
+      // Draw brightness bar
+      int barX = 90;
+      int barY = itemY + 3;
+      int barW = 100;
+      int barH = 12;
+      gfx->drawRect(barX, barY, barW, barH, color);
+      int fillW = map(normalBrightness, 20, 100, 0, barW - 4);
+      gfx->fillRect(barX + 2, barY + 2, fillW, barH - 4, color);
+
+      // Brightness percentage
+      char brightBuf[10];
+      sprintf(brightBuf, "%d%%", normalBrightness);
+      gfx->setCursor(barX + barW + 8, itemY + 5);
+      gfx->print(brightBuf);
+      break;
+    }
+    case 1: {
+      uint16_t color = drawSettingsRow(1, itemY, "Temp Unit:");
+      // Draw toggle
+      int toggleX = 90;
+      int toggleY = itemY + 2;
+
+      // Celsius option
+      if (!useFahrenheit) {
+        gfx->fillRoundRect(toggleX, toggleY, 40, 14, 3, color);
+        gfx->setTextColor(TFT_BLACK);
+      } else {
+        gfx->drawRoundRect(toggleX, toggleY, 40, 14, 3, color);
+        gfx->setTextColor(color);
+      }
+      gfx->setCursor(toggleX + 10, toggleY + 3);
+      gfx->print("C");
+
+      // Fahrenheit option
+      if (useFahrenheit) {
+        gfx->fillRoundRect(toggleX + 45, toggleY, 40, 14, 3, color);
+        gfx->setTextColor(TFT_BLACK);
+      } else {
+        gfx->drawRoundRect(toggleX + 45, toggleY, 40, 14, 3, color);
+        gfx->setTextColor(color);
+      }
+      gfx->setCursor(toggleX + 55, toggleY + 3);
+      gfx->print("F");
+      break;
+    }
+    case 2: {
+      uint16_t color = drawSettingsRow(2, itemY, "Timeout:");
+      const char* labels[] = {"10s", "30s", "Off"};
+      drawOptionButtons(90, itemY + 2, labels, 3, screenTimeoutOption, 32, color);
+      break;
+    }
+    case 3: {
+      uint16_t color = drawSettingsRow(3, itemY, "Smoothing:");
+      const char* labels[] = {"Off", "EMA", "Kalman"};
+      drawOptionButtons(90, itemY + 2, labels, 3, smoothingMode, 42, color);
+      break;
+    }
+    case 4: {
+      uint16_t color = drawSettingsRow(4, itemY, "Time const:");
+      const char* labels[] = {"10s", "30s", "2m"};
+      drawOptionButtons(90, itemY + 2, labels, 3, smoothTimeOption, 32, color);
+      break;
+    }
+    case 5: {
+      uint16_t color = drawSettingsRow(5, itemY, "Pressure:");
+      const char* labels[] = {"Fast", "Bal", "LowPwr"};
+      drawOptionButtons(90, itemY + 2, labels, 3, pressureProfile, 42, color);
+      break;
+    }
+  }
+}
+
 void drawSettingsPageStatic() {
-  M5Cardputer.Display.fillScreen(TFT_BLACK);
+  TRACE_SCOPE(TRACE_DRAW_SETTINGS);
+  gfx->fillScreen(TFT_BLACK);
   drawBattery(true);
   
   // Title
   drawCenteredText("SETTINGS", 5, 2, TFT_WHITE);
-  // Draw menu items
-  int itemY = 35;
-  int itemHeight = 35;
-  // Brightness option
-  uint16_t brightColor = (settingsSelection == 0) ? TFT_YELLOW : TFT_WHITE;
-  if (settingsSelection == 0) {
-    M5Cardputer.Display.fillRoundRect(10, itemY - 3, screenW - 20, itemHeight - 2, 5, 0x2104);
-  }
-  M5Cardputer.Display.setTextSize(1);
-  M5Cardputer.Display.setTextColor(brightColor);
-  M5Cardputer.Display.setCursor(20, itemY + 5);
-  M5Cardputer.Display.print("Brightness:");
-  
-  // Draw brightness bar
-  int barX = 90;
-  int barY = itemY + 3;
-  int barW = 100;
-  int barH = 12;
-  M5Cardputer.Display.drawRect(barX, barY, barW, barH, brightColor);
-  int fillW = map(normalBrightness, 20, 100, 0, barW - 4);
-  M5Cardputer.Display.fillRect(barX + 2, barY + 2, fillW, barH - 4, brightColor);
-  
-  // Brightness percentage
-  char brightBuf[10];
-  sprintf(brightBuf, "%d%%", normalBrightness);
-  M5Cardputer.Display.setCursor(barX + barW + 8, itemY + 5);
-  M5Cardputer.Display.print(brightBuf);
-  
-  // Temperature unit option
-  itemY += itemHeight;
-  uint16_t unitColor = (settingsSelection == 1) ? TFT_YELLOW : TFT_WHITE;
-  if (settingsSelection == 1) {
-    M5Cardputer.Display.fillRoundRect(10, itemY - 3, screenW - 20, itemHeight - 2, 5, 0x2104);
-  }
-  M5Cardputer.Display.setTextColor(unitColor);
-  M5Cardputer.Display.setCursor(20, itemY + 5);
-  M5Cardputer.Display.print("Temp Unit:");
-  
-  // Draw toggle
-  int toggleX = 90;
-  int toggleY = itemY + 2;
-  
-  // Celsius option
-  if (!useFahrenheit) {
-    M5Cardputer.Display.fillRoundRect(toggleX, toggleY, 40, 14, 3, unitColor);
-    M5Cardputer.Display.setTextColor(TFT_BLACK);
-  } else {
-    M5Cardputer.Display.drawRoundRect(toggleX, toggleY, 40, 14, 3, unitColor);
-    M5Cardputer.Display.setTextColor(unitColor);
+  // Scroll so the selection stays in view
+  if (settingsSelection < settingsScroll) settingsScroll = settingsSelection;
+  if (settingsSelection >= settingsScroll + settingsVisible) {
+    settingsScroll = settingsSelection - settingsVisible + 1;
   }
-  M5Cardputer.Display.setCursor(toggleX + 10, toggleY + 3);
-  M5Cardputer.Display.print("C");
-  
-  // Fahrenheit option
-  if (useFahrenheit) {
-    M5Cardputer.Display.fillRoundRect(toggleX + 45, toggleY, 40, 14, 3, unitColor);
-    M5Cardputer.Display.setTextColor(TFT_BLACK);
-  } else {
-    M5Cardputer.Display.drawRoundRect(toggleX + 45, toggleY, 40, 14, 3, unitColor);
-    M5Cardputer.Display.setTextColor(unitColor);
-  }
-  M5Cardputer.Display.setCursor(toggleX + 55, toggleY + 3);
-  M5Cardputer.Display.print("F");
-
-  // Screen timeout option
-  itemY += itemHeight;
-  uint16_t timeoutColor = (settingsSelection == 2) ? TFT_YELLOW : TFT_WHITE;
-  if (settingsSelection == 2) {
-    M5Cardputer.Display.fillRoundRect(10, itemY - 3, screenW - 20, itemHeight - 2, 5, 0x2104);
-  }
-  M5Cardputer.Display.setTextColor(timeoutColor);
-  M5Cardputer.Display.setCursor(20, itemY + 5);
-  M5Cardputer.Display.print("Timeout:");
-
-  // Draw timeout options
-  int optX = 90;
-  int optY = itemY + 2;
-  const char* timeoutLabels[] = {"10s", "30s", "Off"};
-
-  for (int i = 0; i < 3; i++) {
-    int btnX = optX + (i * 35);
-    if (screenTimeoutOption == i) {
-      M5Cardputer.Display.fillRoundRect(btnX, optY, 32, 14, 3, timeoutColor);
-      M5Cardputer.Display.setTextColor(TFT_BLACK);
-    } else {
-      M5Cardputer.Display.drawRoundRect(btnX, optY, 32, 14, 3, timeoutColor);
-      M5Cardputer.Display.setTextColor(timeoutColor);
-    }
-    M5Cardputer.Display.setCursor(btnX + 6, optY + 3);
-    M5Cardputer.Display.print(timeoutLabels[i]);
+  for (int row = 0; row < settingsVisible && settingsScroll + row < settingsCount; row++) {
+    drawSettingsItem(settingsScroll + row, 35 + row * settingsItemHeight);
+  }
+  // More items above / below
+  if (settingsScroll > 0) {
+    gfx->fillTriangle(screenW - 8, 24, screenW - 11, 29, screenW - 5, 29, TFT_DARKGREY);
+  }
+  if (settingsScroll + settingsVisible < settingsCount) {
+    gfx->fillTriangle(screenW - 8, screenH - 4, screenW - 11, screenH - 9, screenW - 5, screenH - 9, TFT_DARKGREY);
   }
 
   // Instructions at bottom
-  M5Cardputer.Display.setTextColor(TFT_DARKGREY);
-  M5Cardputer.Display.setTextSize(1);
-  M5Cardputer.Display.setCursor(5, screenH - 10);
-  M5Cardputer.Display.print("ESC:back | < >:change");
+  gfx->setTextColor(TFT_DARKGREY);
+  gfx->setTextSize(1);
+  gfx->setCursor(5, screenH - 10);
+  gfx->print("ESC:back | < >:change");
+}
+
+//----------------------------------------------------------
+// Page Dispatch
+//----------------------------------------------------------
+
+void drawFullPage(int page) {
+  energyAddSpiBytes(screenW * screenH * 2);
+  switch (page) {
+    case 0: 
+      drawMainPageStatic();
+      updateMainPageValues();
+      break;
+    case 1: 
+      drawGraphPageStatic("TEMPERATURE", METRIC_TEMP, COLOR_TEMP, getTempUnit(), getDisplayTemp(temperature), useFahrenheit);
+      updateGraphValue(getDisplayTemp(temperature), COLOR_TEMP, getTempUnit(), "TEMPERATURE");
+      break;
+    case 2: 
+      drawGraphPageStatic("HUMIDITY", METRIC_HUMIDITY, COLOR_HUMIDITY, "%", humidity);
+      updateGraphValue(humidity, COLOR_HUMIDITY, "%", "HUMIDITY");
+      break;
+    case 3: 
+      drawGraphPageStatic("PRESSURE", METRIC_PRESSURE, COLOR_PRESSURE, "hPa", pressure);
+      updateGraphValue(pressure, COLOR_PRESSURE, "hPa", "PRESSURE");
+      break;
+    case 4:
+      drawSettingsPageStatic();
+      break;
+    case 5:
+      drawYearPageStatic();
+      break;
+    case 6:
+      drawWeekPageStatic();
+      break;
+    case 7:
+      drawDensityPageStatic();
+      break;
+    case 8:
+      drawDiagPageStatic();
+      break;
+    case 9:
+      drawBenchPageStatic();
+      break;
+  }
 }
 
 //----------------------------------------------------------
@@ -577,6 +1297,7 @@ void drawSettingsPageStatic() {
 //----------------------------------------------------------
 
 void handleKeyboard() {
+  TRACE_SCOPE(TRACE_KEYBOARD);
   M5Cardputer.update();
   if (M5Cardputer.Keyboard.isChange()) {
     if (M5Cardputer.Keyboard.isPressed()) {
@@ -592,7 +1313,7 @@ void handleKeyboard() {
       
       for (auto key : status.word) {
         char c = key;
-        Serial.printf("Key pressed: %c (0x%02X)\n", c, c);
+        logPrintf("Key pressed: %c (0x%02X)\n", c, c);
         
         // Convert to uppercase for comparison (for letter keys)
         char upperC = c;
@@ -603,9 +1324,10 @@ void handleKeyboard() {
         // ESC key handling (` or ~ on Cardputer)
         if (c == '`' || c == '~' || c == 27) {  // 27 is ESC
           if (currentPage != 0) {
+            if (currentPage == 4) saveSettings();
             currentPage = 0;
             needsFullRedraw = true;
-            Serial.println("-> BACK to main");
+            logPrintln("-> BACK to main");
           }
         }
         // Main menu keys
@@ -614,25 +1336,89 @@ void handleKeyboard() {
           if (upperC == 'T') {
             currentPage = 1;
             needsFullRedraw = true;
-            Serial.println("-> TEMP graph");
+            logPrintln("-> TEMP graph");
           }
           // H for Humidity
           else if (upperC == 'H') {
             currentPage = 2;
             needsFullRedraw = true;
-            Serial.println("-> HUMIDITY graph");
+            logPrintln("-> HUMIDITY graph");
           }
           // P for Pressure
           else if (upperC == 'P') {
             currentPage = 3;
             needsFullRedraw = true;
-            Serial.println("-> PRESSURE graph");
+            logPrintln("-> PRESSURE graph");
           }
           // S for Settings
           else if (upperC == 'S') {
             currentPage = 4;
             needsFullRedraw = true;
-            Serial.println("-> SETTINGS");
+            logPrintln("-> SETTINGS");
+          }
+          // Y for Year
+          else if (upperC == 'Y') {
+            currentPage = 5;
+            needsFullRedraw = true;
+            logPrintln("-> YEAR");
+          }
+          // W for Week heatmap
+          else if (upperC == 'W') {
+            currentPage = 6;
+            needsFullRedraw = true;
+            logPrintln("-> WEEK");
+          }
+          // C for Comfort (density plot)
+          else if (upperC == 'C') {
+            currentPage = 7;
+            needsFullRedraw = true;
+            logPrintln("-> DENSITY");
+          }
+          // D for Diagnostics
+          else if (upperC == 'D') {
+            currentPage = 8;
+            needsFullRedraw = true;
+            logPrintln("-> DIAGNOSTICS");
+          }
+          // B for Benchmark (not in the key hints); runs it the first time
+          else if (upperC == 'B') {
+            currentPage = 9;
+            benchRequested = !benchValid;
+            needsFullRedraw = true;
+            logPrintln("-> BENCHMARK");
+          }
+        }
+        // Diagnostics page: E / L toggle the energy and loop views
+        else if (currentPage == 8) {
+          if (upperC == 'E' || upperC == 'L') {
+            DiagView view = upperC == 'E' ? DIAG_ENERGY : DIAG_LOOP;
+            diagView = diagView == view ? DIAG_COUNTERS : view;
+            needsFullRedraw = true;
+          }
+        }
+        // Benchmark page: B runs it again
+        else if (currentPage == 9) {
+          if (upperC == 'B') {
+            benchRequested = true;
+            needsFullRedraw = true;
+          }
+        }
+        // Density page: Z toggles the comfort zones
+        else if (currentPage == 7) {
+          if (upperC == 'Z') {
+            showComfortZones = !showComfortZones;
+            needsFullRedraw = true;
+          }
+        }
+        // Year and week pages: T/H/P pick the metric
+        else if (currentPage == 5 || currentPage == 6) {
+          Metric metric = summaryMetric;
+          if (upperC == 'T') metric = METRIC_TEMP;
+          else if (upperC == 'H') metric = METRIC_HUMIDITY;
+          else if (upperC == 'P') metric = METRIC_PRESSURE;
+          if (metric != summaryMetric) {
+            summaryMetric = metric;
+            needsFullRedraw = true;
           }
         }
         // Settings page navigation with ;
@@ -645,7 +1431,7 @@ void handleKeyboard() {
           }
           else if (c == '.') {  // . = Down
             settingsSelection++;
-            if (settingsSelection > 2) settingsSelection = 2;
+            if (settingsSelection > settingsCount - 1) settingsSelection = settingsCount - 1;
             needsFullRedraw = true;
           }
           else if (c == ',') {  // , = Left (decrease/select C)
@@ -658,13 +1444,27 @@ void handleKeyboard() {
             } else if (settingsSelection == 1) {
               // Temperature unit - select Celsius
               useFahrenheit = false;
-              dispTemp = -999.0;  // Force redraw of temp
+              displayFilterReset(dispTemp);  // Force redraw of temp
               needsFullRedraw = true;
             } else if (settingsSelection == 2) {
               // Screen timeout - cycle left
               screenTimeoutOption--;
               if (screenTimeoutOption < 0) screenTimeoutOption = 0;
               needsFullRedraw = true;
+            } else if (settingsSelection == 3) {
+              // Smoothing mode
+              if (smoothingMode > 0) smoothingMode--;
+              smoothConfigure((SmoothMode)smoothingMode, smoothTimeOption);
+              needsFullRedraw = true;
+            } else if (settingsSelection == 4) {
+              // Smoothing time constant
+              if (smoothTimeOption > 0) smoothTimeOption--;
+              smoothConfigure((SmoothMode)smoothingMode, smoothTimeOption);
+              needsFullRedraw = true;
+            } else if (settingsSelection == 5) {
+              // Pressure acquisition profile
+              if (pressureProfile > 0) setPressureProfile(pressureProfile - 1);
+              needsFullRedraw = true;
             }
           }
           else if (c == '/') {  // / = Right (increase/select F)
@@ -677,13 +1477,27 @@ void handleKeyboard() {
             } else if (settingsSelection == 1) {
               // Temperature unit - select Fahrenheit
               useFahrenheit = true;
-              dispTemp = -999.0;  // Force redraw of temp
+              displayFilterReset(dispTemp);  // Force redraw of temp
               needsFullRedraw = true;
             } else if (settingsSelection == 2) {
               // Screen timeout - cycle right
               screenTimeoutOption++;
               if (screenTimeoutOption > 2) screenTimeoutOption = 2;
               needsFullRedraw = true;
+            } else if (settingsSelection == 3) {
+              // Smoothing mode
+              if (smoothingMode < SMOOTH_MODE_COUNT - 1) smoothingMode++;
+              smoothConfigure((SmoothMode)smoothingMode, smoothTimeOption);
+              needsFullRedraw = true;
+            } else if (settingsSelection == 4) {
+              // Smoothing time constant
+              if (smoothTimeOption < smoothTauCount - 1) smoothTimeOption++;
+              smoothConfigure((SmoothMode)smoothingMode, smoothTimeOption);
+              needsFullRedraw = true;
+            } else if (settingsSelection == 5) {
+              // Pressure acquisition profile
+              if (pressureProfile < PRESSURE_PROFILE_COUNT - 1) setPressureProfile(pressureProfile + 1);
+              needsFullRedraw = true;
             }
           }
         }
@@ -696,29 +1510,231 @@ void handleKeyboard() {
 // Data Collection
 //----------------------------------------------------------
 
+// Spike-filtered, smoothed readings feed the display, history and exports.
+// The adaptive sampler sees them before smoothing, which would hide changes.
+void takeShtReading(unsigned long now) {
+  lastShtRead = now;
+  float t = hampelFilter(METRIC_TEMP, sht30.cTemp);
+  float h = hampelFilter(METRIC_HUMIDITY, sht30.humidity);
+  samplerAdd(METRIC_TEMP, t);
+  samplerAdd(METRIC_HUMIDITY, h);
+  temperature = smoothUpdate(METRIC_TEMP, t, now);
+  humidity = smoothUpdate(METRIC_HUMIDITY, h, now);
+}
+
+void takePressureReading(unsigned long now) {
+  lastPressureRead = now;
+  float p = hampelFilter(METRIC_PRESSURE, qmp6988.pressure / 100.0);
+  samplerAdd(METRIC_PRESSURE, p);
+  pressure = smoothUpdate(METRIC_PRESSURE, p, now);
+}
+
+// Sensors are only polled once the sampler wants a new reading; the
+// drivers then talk to the bus only if the sensor has one ready
+void readSensors() {
+  TRACE_SCOPE(TRACE_SENSORS);
+  unsigned long now = millis();
+  uint32_t shtInterval = samplerIntervalMs(METRIC_TEMP);
+  if (samplerIntervalMs(METRIC_HUMIDITY) < shtInterval) shtInterval = samplerIntervalMs(METRIC_HUMIDITY);
+  if (now - lastShtRead >= shtInterval && sht30.poll(now)) {
+    takeShtReading(now);
+  }
+  if (now - lastPressureRead >= samplerIntervalMs(METRIC_PRESSURE) && pressurePoll(now)) {
+    takePressureReading(now);
+  }
+}
+
+// Each metric goes into its own ring at its own bin width
 void updateHistory() {
+  TRACE_SCOPE(TRACE_HISTORY);
   unsigned long now = millis();
-  if (now - lastHistoryUpdate >= historyInterval || historyCount == 0) {
-    lastHistoryUpdate = now;
-    tempHistory[historyIndex] = temperature;
-    humidityHistory[historyIndex] = humidity;
-    pressureHistory[historyIndex] = pressure;
-    historyIndex = (historyIndex + 1) % historySize;
-    if (historyCount < historySize) historyCount++;
-    Serial.printf("History: %d points\n", historyCount);
+  const float current[METRIC_COUNT] = {temperature, humidity, pressure};
+  for (int m = 0; m < METRIC_COUNT; m++) {
+    Metric metric = (Metric)m;
+    if (now - lastHistoryUpdate[m] >= historyIntervals[m] || historyCount(metric) == 0) {
+      lastHistoryUpdate[m] = now;
+      historyAdd(metric, now / 1000, current[m]);
+    }
+  }
+  if (now - lastArchiveUpdate >= archiveInterval) {
+    lastArchiveUpdate = now;
+    dailyAdd(clockNow(), temperature, humidity, pressure);
+    heatmapAdd(clockNow(), temperature, humidity, pressure);
+    densityAdd(temperature, humidity);
+    logPrintf("History: %d points\n", historyCount(METRIC_TEMP));
   }
 }
 
+//----------------------------------------------------------
+// Energy Accounting
+//----------------------------------------------------------
+
+// Once per loop: the states that cost energy while they last, and the
+// operations the drivers counted since the previous call. Display SPI
+// bytes are added where pages are drawn (fills, which dominate).
+void accountEnergy(uint32_t busyUs) {
+  static uint32_t lastShtTransfers = 0;
+  static uint32_t lastPressureTransfers = 0;
+  static uint32_t lastSdBlocks = 0;
+  energyAddCpuBusy(busyUs);
+
+  int step = screenState == SCREEN_ON ? energyBrightnessStep(normalBrightness) : 0;
+  WifiLinkState wifi = wifiState();
+  bool wifiOn = wifi == WIFI_LINK_CONNECTING || wifi == WIFI_LINK_UP;
+  energyTick(millis(), step, wifiOn, ENABLE_BLE);
+
+  uint32_t sht = sht30.stats().transfers;
+  uint32_t qmp = pressureTransfers();
+  energyAddI2c((sht - lastShtTransfers) + (qmp - lastPressureTransfers));
+  lastShtTransfers = sht;
+  lastPressureTransfers = qmp;
+  uint32_t blocks = sdLogBlocksWritten();
+  energyAddSdBlocks(blocks - lastSdBlocks);
+  lastSdBlocks = blocks;
+}
+
+//----------------------------------------------------------
+// Serial Protocol Hooks
+//----------------------------------------------------------
+
+void protoFillReading(ProtoReading& reading) {
+  reading.uptime = millis() / 1000;
+  reading.temp = temperature;
+  reading.humidity = humidity;
+  reading.pressure = pressure;
+  reading.battery = M5Cardputer.Power.getBatteryLevel();
+  reading.charging = M5Cardputer.Power.isCharging() ? 1 : 0;
+}
+
+// Same effect as changing the setting on the settings page
+bool protoApplySetting(uint8_t key, int32_t value) {
+  switch (key) {
+    case SETTING_BRIGHTNESS:
+      if (value < 20 || value > 100) return false;
+      normalBrightness = value;
+      if (screenState == SCREEN_ON) M5Cardputer.Display.setBrightness(normalBrightness);
+      break;
+    case SETTING_FAHRENHEIT:
+      if (value != 0 && value != 1) return false;
+      useFahrenheit = value;
+      displayFilterReset(dispTemp);  // Force redraw of temp
+      break;
+    case SETTING_SCREEN_TIMEOUT:
+      if (value < 0 || value > 2) return false;
+      screenTimeoutOption = value;
+      lastActivityTime = millis();
+      break;
+    case SETTING_SMOOTHING:
+      if (value < 0 || value >= SMOOTH_MODE_COUNT) return false;
+      smoothingMode = value;
+      smoothConfigure((SmoothMode)smoothingMode, smoothTimeOption);
+      break;
+    case SETTING_SMOOTH_TIME:
+      if (value < 0 || value >= smoothTauCount) return false;
+      smoothTimeOption = value;
+      smoothConfigure((SmoothMode)smoothingMode, smoothTimeOption);
+      break;
+    case SETTING_PRESSURE_PROFILE:
+      if (value < 0 || value >= PRESSURE_PROFILE_COUNT) return false;
+      setPressureProfile(value);
+      break;
+    default:
+      return false;
+  }
+  saveSettings();
+  needsFullRedraw = true;
+  return true;
+}
+
+//----------------------------------------------------------
+// Render Probe (build with -DRENDER_PROBE)
+//----------------------------------------------------------
+
+#ifdef RENDER_PROBE
+// Draws every page into an off-screen counting canvas from a fixed fixture
+// and reports primitives, pixels, time and image CRC per page over serial,
+// followed by a PPM of each page. tools/render_probe.py diffs the images
+// against golden files and the counts against a saved baseline.
+// Every page but the benchmark (9), whose results differ from unit to unit;
+// the index is the page number
+static const char* probePageNames[] = {
+  "main", "temp", "humidity", "pressure", "settings", "year", "week", "density", "diag"
+};
+
+// Runs before the daily, heatmap and density archives are loaded, so those
+// pages draw their empty state on every unit
+void runRenderProbe() {
+  CountingCanvas canvas(&M5Cardputer.Display);
+  canvas.setColorDepth(16);
+  if (!canvas.createSprite(screenW, screenH)) {
+    Serial.println("probe: no memory for canvas");
+    return;
+  }
+
+  // Fixed fixture so the images only change when the drawing code does
+  temperature = 22.4;
+  humidity = 45.0;
+  pressure = 1013.2;
+  historyClear();
+  // Full rings; the oldest graph span sits a little lower, for the -24h overlay
+  for (int m = 0; m < METRIC_COUNT; m++) {
+    Metric metric = (Metric)m;
+    int window = graphSamples(metric);
+    for (int i = 0; i < historySizes[m]; i++) {
+      float dayAgo = i < window ? -0.6 : 0.0;
+      float value = metric == METRIC_TEMP ? 21.0 + (i % 20) * 0.15 + dayAgo
+                  : metric == METRIC_HUMIDITY ? 40.0 + (i % 12) * 0.8 + dayAgo * 4
+                  : 1010.0 + (i % window) * 0.05 + dayAgo;
+      historyAdd(metric, i * (historyIntervals[m] / 1000), value);
+    }
+  }
+  probeBatteryLevel = 75;
+  probeFixedDiag = true;
+  settingsSelection = 0;
+  settingsScroll = 0;
+  // Default settings and views; the saved settings are reloaded afterwards
+  normalBrightness = 80;
+  useFahrenheit = false;
+  screenTimeoutOption = 2;
+  smoothingMode = SMOOTH_OFF;
+  smoothTimeOption = 1;
+  pressureProfile = PRESSURE_BALANCED;
+  summaryMetric = METRIC_TEMP;
+  showComfortZones = true;
+  diagView = DIAG_COUNTERS;
+
+  lgfx::LovyanGFX* panel = gfx;
+  gfx = &canvas;
+  Serial.println("probe begin");
+  for (int page = 0; page < (int)(sizeof(probePageNames) / sizeof(probePageNames[0])); page++) {
+    canvas.fillScreen(TFT_BLACK);
+    canvas.resetCounters();
+    RenderStats stats;
+    unsigned long start = micros();
+    drawFullPage(page);
+    stats.elapsedUs = micros() - start;
+    stats.primitives = canvas.primitives();
+    stats.pixels = canvas.pixels();
+    stats.crc = renderProbeCrc(canvas);
+    renderProbeReport(Serial, probePageNames[page], stats);
+    renderProbeDumpPpm(Serial, probePageNames[page], canvas);
+  }
+  Serial.println("probe end");
+  gfx = panel;
+  canvas.deleteSprite();
+  probeBatteryLevel = -1;
+  probeFixedDiag = false;
+  loadSettings();
+}
+#endif
+
 //----------------------------------------------------------
 // Setup
 //----------------------------------------------------------
 
-void setup() {
-  auto cfg = M5.config();
-  M5Cardputer.begin(cfg);
-  M5Cardputer.Display.setRotation(1);
-  M5Cardputer.Display.setBrightness(normalBrightness);
-  
+// Draw target and box positions for the display in landscape
+void initLayout() {
+  gfx = &M5Cardputer.Display;
   screenW = M5Cardputer.Display.width();
   screenH = M5Cardputer.Display.height();
   
@@ -729,13 +1745,38 @@ void setup() {
   humidBoxX = startX + boxWidth + boxMargin;
   pressBoxX = startX + (boxWidth + boxMargin) * 2;
   boxY = topMargin + (screenH - topMargin - boxHeight) / 2;
+}
+
+#ifdef RENDER_HOST
+// Host build of the render probe (pio run -e render-host): the pages drawn
+// by M5GFX built for the host, with the probe output on stdout, so
+// tools/render_probe.py --host can check and regenerate the goldens
+// without a unit
+int main() {
+  M5Cardputer.begin(M5.config());
+  loadSettings();
+  initLayout();
+  runRenderProbe();
+  return 0;
+}
+#endif
+
+void setup() {
+  auto cfg = M5.config();
+  M5Cardputer.begin(cfg);
+  loadSettings();
+  M5Cardputer.Display.setRotation(1);
+  M5Cardputer.Display.setBrightness(normalBrightness);
+  initLayout();
   Serial.begin(115200);
+  logBegin(Serial);
+  protoBegin(Serial);
   delay(100);
-  Serial.println("\n=== CardENV Starting ===");
-  Serial.printf("Screen: %d x %d\n", screenW, screenH);
+  logPrintln("\n=== CardENV Starting ===");
+  logPrintf("Screen: %d x %d\n", screenW, screenH);
   
   // Startup screen
-  M5Cardputer.Display.fillScreen(TFT_BLACK);
+  gfx->fillScreen(TFT_BLACK);
   drawCenteredText("CardENV", 40, 2, TFT_CYAN);
   drawCenteredText("Initializing...", 65, 1, TFT_WHITE);
   
@@ -744,48 +1785,88 @@ void setup() {
   delay(300);
   
   // Initialize sensors
-  if (sht30.begin(&Wire, SHT3X_I2C_ADDR, 2, 1)) {
-    Serial.println("SHT30 OK!");
+  if (sht30.begin(sht30Bus, (Sht30Rate)SHT30_RATE, millis())) {
+    logPrintln("SHT30 OK!");
     drawCenteredText("SHT30: OK", 85, 1, TFT_GREEN);
   } else {
-    Serial.println("SHT30 FAILED!");
+    logPrintln("SHT30 FAILED!");
     drawCenteredText("SHT30: FAILED", 85, 1, TFT_RED);
   }
   
   delay(100);
   
   if (qmp6988.begin(&Wire, QMP6988_SLAVE_ADDRESS_L, 2, 1)) {
-    Serial.println("QMP6988 OK!");
+    qmpAddress = QMP6988_SLAVE_ADDRESS_L;
+    logPrintln("QMP6988 OK!");
     drawCenteredText("QMP6988: OK", 100, 1, TFT_GREEN);
   } else if (qmp6988.begin(&Wire, 0x56, 2, 1)) {
-    Serial.println("QMP6988 OK (0x56)!");
+    qmpAddress = 0x56;
+    logPrintln("QMP6988 OK (0x56)!");
     drawCenteredText("QMP6988: OK", 100, 1, TFT_GREEN);
   } else {
-    Serial.println("QMP6988 FAILED!");
+    logPrintln("QMP6988 FAILED!");
     drawCenteredText("QMP6988: FAILED", 100, 1, TFT_RED);
   }
+  if (qmpAddress) {
+    pressureBegin(qmp6988, Wire, qmpAddress, (PressureProfile)pressureProfile, millis());
+  }
+  
+  // Flash filesystem for persistent queues and archives
+  if (LittleFS.begin(true)) {
+    logPrintln("Flash FS OK");
+  } else {
+    logPrintln("Flash FS FAILED!");
+  }
+#ifdef RENDER_PROBE
+  // Before the archives are loaded and the first real reading, which
+  // would overwrite the probe fixture
+  runRenderProbe();
+#endif
+  dailyBegin();
+  heatmapBegin();
+  densityBegin();
+  mqttBegin();
+  metricsBegin();
+  influxBegin();
+  bleBegin();
+  sdLogBegin();
   
   // Show key hints
   drawCenteredText("T:Temp H:Humid P:Press S:Set", 118, 1, TFT_DARKGREY);
+  drawCenteredText("Y:Year W:Week C:Comfort D:Diag", 127, 1, TFT_DARKGREY);
   
-  Serial.println("=== Setup Complete ===\n");
+  logPrintln("=== Setup Complete ===\n");
   delay(2000);
   
-  // Initialize readings
-  sht30.update();
-  qmp6988.update();
-  temperature = sht30.cTemp;
-  humidity = sht30.humidity;
-  pressure = qmp6988.pressure / 100.0;
+  // Initialize readings (the SHT30 has been measuring since setup began)
+  unsigned long waitStart = millis();
+  while (!sht30.poll(millis()) && millis() - waitStart < 2 * sht30RatePeriodMs((Sht30Rate)SHT30_RATE)) {
+    delay(10);
+  }
+  // Long enough for a forced conversion; normal mode results are ready
+  waitStart = millis();
+  while (!pressurePoll(millis()) && millis() - waitStart < 100) {
+    delay(5);
+  }
+#if ENABLE_ADAPTIVE_SAMPLING
+  samplerSetBounds(METRIC_TEMP, SAMPLE_MIN_INTERVAL_MS, SAMPLE_MAX_INTERVAL_MS);
+  samplerSetBounds(METRIC_HUMIDITY, SAMPLE_MIN_INTERVAL_MS, SAMPLE_MAX_INTERVAL_MS);
+  samplerSetBounds(METRIC_PRESSURE, pressureProfilePeriodMs((PressureProfile)pressureProfile),
+                   PRESSURE_MAX_INTERVAL_MS);
+#else
+  // Read whenever the sensors have a new result
+  for (int m = 0; m < METRIC_COUNT; m++) samplerSetBounds((Metric)m, 0, 0);
+#endif
+  takeShtReading(millis());
+  takePressureReading(millis());
   // Store first history point
-  tempHistory[0] = temperature;
-  humidityHistory[0] = humidity;
-  pressureHistory[0] = pressure;
-  historyCount = 1;
-  historyIndex = 1;
+  historyClear();
+  updateHistory();
   
   lastActivityTime = millis();
   lastDisplayUpdate = millis();
+  // Monitor loop() from its first iteration on
+  loopWatchBegin();
   
   needsFullRedraw = true;
 }
@@ -795,19 +1876,36 @@ void setup() {
 //----------------------------------------------------------
 
 void loop() {
+  TRACE_BEGIN(TRACE_LOOP);
+  loopWatchIterationStart();
+  unsigned long loopStartUs = micros();
+  loopWatchPhase(LOOP_PHASE_KEYBOARD);
   handleKeyboard();
   updateScreenTimeout();
+  loopWatchPhase(LOOP_PHASE_PROTOCOL);
+  protoPoll();
+  loopWatchPhase(LOOP_PHASE_LOG);
+  if (!protoTxPending()) logDrain();  // Never split a protocol frame
   // Read sensors
-  sht30.update();
-  temperature = sht30.cTemp;
-  humidity = sht30.humidity;
-  
-  qmp6988.update();
-  pressure = qmp6988.pressure / 100.0;
+  loopWatchPhase(LOOP_PHASE_SENSORS);
+  readSensors();
   // Update history
+  loopWatchPhase(LOOP_PHASE_HISTORY);
   updateHistory();
   
+  loopWatchPhase(LOOP_PHASE_SD_LOG);
+  sdLogPoll();
+  
+  // Network publishing (no-ops unless enabled in config.h)
+  loopWatchPhase(LOOP_PHASE_NETWORK);
+  wifiPoll();
+  mqttPoll(temperature, humidity, pressure);
+  influxPoll();
+  blePoll(temperature, humidity, pressure);
+  metricsPoll({temperature, humidity, pressure, prevBatteryLevel, prevCharging});
+  
   // Only update display every second
+  loopWatchPhase(LOOP_PHASE_DISPLAY);
   unsigned long now = millis();
   bool shouldUpdateDisplay = (now - lastDisplayUpdate >= displayInterval);
   
@@ -815,27 +1913,7 @@ void loop() {
     if (needsFullRedraw) {
       needsFullRedraw = false;
       lastDisplayUpdate = now;
-      switch (currentPage) {
-        case 0: 
-          drawMainPageStatic();
-          updateMainPageValues();
-          break;
-        case 1: 
-          drawGraphPageStatic("TEMPERATURE", tempHistory, COLOR_TEMP, getTempUnit(), getDisplayTemp(temperature), useFahrenheit);
-          updateGraphValue(getDisplayTemp(temperature), COLOR_TEMP, getTempUnit(), "TEMPERATURE");
-          break;
-        case 2: 
-          drawGraphPageStatic("HUMIDITY", humidityHistory, COLOR_HUMIDITY, "%", humidity);
-          updateGraphValue(humidity, COLOR_HUMIDITY, "%", "HUMIDITY");
-          break;
-        case 3: 
-          drawGraphPageStatic("PRESSURE", pressureHistory, COLOR_PRESSURE, "hPa", pressure);
-          updateGraphValue(pressure, COLOR_PRESSURE, "hPa", "PRESSURE");
-          break;
-        case 4:
-          drawSettingsPageStatic();
-          break;
-      }
+      drawFullPage(currentPage);
     } else if (shouldUpdateDisplay) {
       lastDisplayUpdate = now;
       switch (currentPage) {
@@ -855,11 +1933,23 @@ void loop() {
           drawBattery(false);
           break;
         case 4:
+        case 5:
+        case 6:
+        case 7:
+          drawBattery(false);
+          break;
+        case 8:
+          updateDiagPage();
+          drawBattery(false);
+          break;
+        case 9:
           drawBattery(false);
           break;
       }
     }
   }
-  
+  accountEnergy(micros() - loopStartUs);
+  loopWatchIterationEnd();
+  TRACE_END(TRACE_LOOP);
   delay(50);
 }
\ No newline at end of file
@@ -0,0 +1,272 @@
+#include "metrics_server.h"
+#include "config.h"
+
+#if ENABLE_METRICS
+
+#include <WiFi.h>
+#include "history.h"
+#include "log_sink.h"
+#include "serial_proto.h"
+#include "wifi_link.h"
+
+const int responseMax = 3072;
+const int requestMax = 128;
+const int writeChunk = 512;           // Well inside the lwIP send buffer
+const unsigned long clientTimeout = 2000;
+
+// What the rendered response depends on; a render happens only when this
+// differs from the copy taken at the previous render
+struct MetricsSnapshot {
+  MetricsInputs inputs;
+  uint32_t historySeq;
+  uint32_t freeHeapKb;
+  uint32_t logDropped;
+  uint32_t rxFrames;
+  uint32_t rxErrors;
+};
+
+enum ClientState { CLIENT_NONE, CLIENT_REQUEST, CLIENT_RESPONSE };
+
+static WiFiServer server(METRICS_PORT);
+static WiFiClient client;
+static ClientState clientState = CLIENT_NONE;
+static unsigned long clientStart = 0;
+static char request[requestMax];
+static int requestLen = 0;
+static int headerEnd = 0;  // Bytes of "\r\n\r\n" matched so far
+
+static char response[responseMax];
+static const char* responseStart = response;  // Header sits right before the body
+static int responseLen = 0;
+static const char* sendPtr = nullptr;
+static int sendLeft = 0;
+
+static MetricsSnapshot latest;
+static MetricsSnapshot rendered;
+static bool everRendered = false;
+static uint32_t renderCount = 0;
+
+static const char notFound[] =
+    "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+
+//----------------------------------------------------------
+// Rendering
+//----------------------------------------------------------
+
+static bool sameSnapshot(const MetricsSnapshot& a, const MetricsSnapshot& b) {
+  return a.inputs.temp == b.inputs.temp && a.inputs.humidity == b.inputs.humidity &&
+         a.inputs.pressure == b.inputs.pressure && a.inputs.battery == b.inputs.battery &&
+         a.inputs.charging == b.inputs.charging && a.historySeq == b.historySeq &&
+         a.freeHeapKb == b.freeHeapKb && a.logDropped == b.logDropped &&
+         a.rxFrames == b.rxFrames && a.rxErrors == b.rxErrors;
+}
+
+static int bodyPrintf(char* body, int len, int cap, const char* format, ...) {
+  if (len >= cap) return len;
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(body + len, cap - len, format, args);
+  va_end(args);
+  return n < 0 ? len : len + n;
+}
+
+static int gauge(char* body, int len, int cap, const char* name, const char* help, float value) {
+  return bodyPrintf(body, len, cap, "# HELP %s %s\n# TYPE %s gauge\n%s %.2f\n",
+                    name, help, name, name, value);
+}
+
+static int counter(char* body, int len, int cap, const char* name, const char* help, uint32_t value) {
+  return bodyPrintf(body, len, cap, "# HELP %s %s\n# TYPE %s counter\n%s %lu\n",
+                    name, help, name, name, (unsigned long)value);
+}
+
+static int aggregates(char* body, int len, int cap) {
+  static const char* names[METRIC_COUNT] = {"temperature", "humidity", "pressure"};
+  if (historyCount(METRIC_TEMP) == 0) return len;
+  len = bodyPrintf(body, len, cap,
+                   "# HELP cardenv_history_min Minimum over the history window.\n"
+                   "# TYPE cardenv_history_min gauge\n"
+                   "# HELP cardenv_history_max Maximum over the history window.\n"
+                   "# TYPE cardenv_history_max gauge\n"
+                   "# HELP cardenv_history_mean Mean over the history window.\n"
+                   "# TYPE cardenv_history_mean gauge\n");
+  for (int m = 0; m < METRIC_COUNT; m++) {
+    // The last hour of each metric, at its own bin width
+    int count = historyCount((Metric)m);
+    int first = count > historyWindow((Metric)m) ? count - historyWindow((Metric)m) : 0;
+    if (count == 0) continue;
+    float lo = historyValue((Metric)m, first);
+    float hi = lo;
+    float sum = 0;
+    for (int i = first; i < count; i++) {
+      float v = historyValue((Metric)m, i);
+      if (v < lo) lo = v;
+      if (v > hi) hi = v;
+      sum += v;
+    }
+    len = bodyPrintf(body, len, cap,
+                     "cardenv_history_min{metric=\"%s\"} %.2f\n"
+                     "cardenv_history_max{metric=\"%s\"} %.2f\n"
+                     "cardenv_history_mean{metric=\"%s\"} %.2f\n",
+                     names[m], lo, names[m], hi, names[m], sum / (count - first));
+  }
+  return len;
+}
+
+// Body first at a fixed offset, then the header is placed directly in
+// front of it so the whole response is one contiguous run
+static void render() {
+  const int headerRoom = 128;
+  char* body = response + headerRoom;
+  int cap = responseMax - headerRoom;
+  int len = 0;
+  const MetricsSnapshot& s = latest;
+
+  renderCount++;
+  len = gauge(body, len, cap, "cardenv_temperature_celsius", "Current temperature.", s.inputs.temp);
+  len = gauge(body, len, cap, "cardenv_humidity_percent", "Current relative humidity.", s.inputs.humidity);
+  len = gauge(body, len, cap, "cardenv_pressure_hpa", "Current barometric pressure.", s.inputs.pressure);
+  len = aggregates(body, len, cap);
+  len = gauge(body, len, cap, "cardenv_battery_percent", "Battery level.", s.inputs.battery);
+  len = gauge(body, len, cap, "cardenv_battery_charging", "1 while charging.", s.inputs.charging ? 1 : 0);
+  len = counter(body, len, cap, "cardenv_history_samples_total", "History samples recorded.", s.historySeq);
+  len = gauge(body, len, cap, "cardenv_free_heap_kb", "Free heap in KB.", s.freeHeapKb);
+  len = counter(body, len, cap, "cardenv_log_dropped_total", "Log messages dropped.", s.logDropped);
+  len = counter(body, len, cap, "cardenv_serial_rx_frames_total", "Serial protocol frames received.", s.rxFrames);
+  len = counter(body, len, cap, "cardenv_serial_rx_errors_total", "Serial protocol frames rejected.", s.rxErrors);
+  len = counter(body, len, cap, "cardenv_metrics_renders_total", "Times this response was rebuilt.", renderCount);
+  if (len > cap) len = cap;
+
+  char header[headerRoom];
+  int headerLen = snprintf(header, sizeof(header),
+                           "HTTP/1.1 200 OK\r\n"
+                           "Content-Type: text/plain; version=0.0.4\r\n"
+                           "Content-Length: %d\r\n"
+                           "Connection: close\r\n\r\n", len);
+  char* start = body - headerLen;
+  memcpy(start, header, headerLen);
+  responseStart = start;
+  responseLen = headerLen + len;
+
+  rendered = latest;
+  everRendered = true;
+}
+
+//----------------------------------------------------------
+// Client handling
+//----------------------------------------------------------
+
+static void closeClient() {
+  client.stop();
+  clientState = CLIENT_NONE;
+}
+
+static void startResponse() {
+  if (strncmp(request, "GET /metrics", 12) != 0) {
+    sendPtr = notFound;
+    sendLeft = sizeof(notFound) - 1;
+  } else {
+    if (!everRendered || !sameSnapshot(latest, rendered)) {
+      render();
+    }
+    sendPtr = responseStart;
+    sendLeft = responseLen;
+  }
+  clientState = CLIENT_RESPONSE;
+}
+
+// Read whatever request bytes have arrived; respond once the headers end
+static void readRequest() {
+  while (client.available() > 0) {
+    char c = client.read();
+    if (requestLen < requestMax - 1) {
+      request[requestLen++] = c;
+      request[requestLen] = '\0';
+    }
+    // Match "\r\n\r\n"
+    bool expectCr = (headerEnd % 2) == 0;
+    if (c == (expectCr ? '\r' : '\n')) {
+      if (++headerEnd == 4) {
+        startResponse();
+        return;
+      }
+    } else {
+      headerEnd = (c == '\r') ? 1 : 0;
+    }
+  }
+}
+
+static void writeResponse() {
+  int n = sendLeft < writeChunk ? sendLeft : writeChunk;
+  int written = client.write((const uint8_t*)sendPtr, n);
+  if (written <= 0) {
+    closeClient();
+    return;
+  }
+  sendPtr += written;
+  sendLeft -= written;
+  if (sendLeft == 0) closeClient();
+}
+
+//----------------------------------------------------------
+// Public
+//----------------------------------------------------------
+
+void metricsBegin() {
+  wifiAcquire();
+}
+
+void metricsPoll(const MetricsInputs& inputs) {
+  static bool serverStarted = false;
+  if (wifiState() != WIFI_LINK_UP) {
+    if (clientState != CLIENT_NONE) closeClient();
+    if (wifiState() == WIFI_LINK_FAILED) {
+      // Lab units keep trying: drop our hold and take it again
+      wifiRelease();
+      wifiAcquire();
+    }
+    return;
+  }
+  if (!serverStarted) {
+    server.begin();
+    serverStarted = true;
+    logPrintf("Metrics on http://%s:%d/metrics\n", WiFi.localIP().toString().c_str(), METRICS_PORT);
+  }
+
+  ProtoStats stats;
+  protoFillStats(stats);
+  latest.inputs = inputs;
+  latest.historySeq = historySeq(METRIC_TEMP) + historySeq(METRIC_HUMIDITY) + historySeq(METRIC_PRESSURE);
+  latest.freeHeapKb = stats.freeHeap / 1024;
+  latest.logDropped = stats.logDropped;
+  latest.rxFrames = stats.rxFrames;
+  latest.rxErrors = stats.rxErrors;
+
+  switch (clientState) {
+    case CLIENT_NONE:
+      client = server.available();
+      if (client) {
+        clientState = CLIENT_REQUEST;
+        clientStart = millis();
+        requestLen = 0;
+        headerEnd = 0;
+      }
+      break;
+    case CLIENT_REQUEST:
+      readRequest();
+      if (clientState == CLIENT_REQUEST && millis() - clientStart >= clientTimeout) {
+        closeClient();
+      }
+      break;
+    case CLIENT_RESPONSE:
+      writeResponse();
+      break;
+  }
+}
+
+#else
+
+void metricsBegin() {}
+void metricsPoll(const MetricsInputs&) {}
+
+#endif
@@ -0,0 +1,63 @@
+#include "mqtt_batch.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "history.h"
+
+// Append formatted text; false (and nothing appended) if it does not fit
+static bool append(uint8_t* buf, int cap, int& len, const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf((char*)buf + len, cap - len, format, args);
+  va_end(args);
+  if (n < 0 || len + n >= cap - 2) {  // Keep room for "]}"
+    buf[len] = '\0';
+    return false;
+  }
+  len += n;
+  return true;
+}
+
+int mqttBuildBatch(uint8_t* buf, int cap, uint32_t& nextSeq, uint32_t uptimeS, uint32_t unixTime,
+                   float temp, float humidity, float pressure) {
+  int len = 0;
+  append(buf, cap, len, "{\"up\":%lu,\"ts\":%lu,\"temp\":%.2f,\"hum\":%.2f,\"press\":%.2f,\"bins\":[",
+         (unsigned long)uptimeS, (unsigned long)unixTime, temp, humidity, pressure);
+
+  uint32_t oldestSeq = historySeq(METRIC_TEMP) - historyCount(METRIC_TEMP);
+  if (nextSeq < oldestSeq) nextSeq = oldestSeq;
+  bool first = true;
+  while (nextSeq < historySeq(METRIC_TEMP)) {
+    int i = nextSeq - oldestSeq;
+    uint32_t t = historyTime(METRIC_TEMP, i);
+    if (!append(buf, cap, len, "%s[%lu,%.2f,%.2f,%.2f]", first ? "" : ",", (unsigned long)t,
+                historyValue(METRIC_TEMP, i), historyValueAt(METRIC_HUMIDITY, t),
+                historyValueAt(METRIC_PRESSURE, t))) {
+      break;
+    }
+    first = false;
+    nextSeq++;
+  }
+  memcpy(buf + len, "]}", 2);
+  return len + 2;
+}
+
+bool mqttBatchDue(MqttSchedule& s, unsigned long now) {
+  if (now - s.lastBatch < s.interval) return false;
+  s.lastBatch = now;
+  if (!s.windowOpen) {
+    s.windowOpen = true;
+    s.windowStart = now;
+  }
+  return true;
+}
+
+MqttWindowStep mqttWindowStep(const MqttSchedule& s, unsigned long now, bool queueEmpty,
+                              WifiLinkState link) {
+  if (!s.windowOpen) return MQTT_WINDOW_IDLE;
+  if (queueEmpty || now - s.windowStart >= s.timeout || link == WIFI_LINK_FAILED) {
+    return MQTT_WINDOW_CLOSE;
+  }
+  return link == WIFI_LINK_UP ? MQTT_WINDOW_SEND : MQTT_WINDOW_WAIT;
+}
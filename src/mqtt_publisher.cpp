@@ -0,0 +1,114 @@
+#include "mqtt_publisher.h"
+#include "config.h"
+
+#if ENABLE_MQTT
+
+#include <LittleFS.h>
+#include <PubSubClient.h>
+#include <WiFi.h>
+#include "flash_queue.h"
+#include "history.h"
+#include "log_sink.h"
+#include "mqtt_batch.h"
+#include "wallclock.h"
+#include "wifi_link.h"
+
+const uint16_t queueSlots = 96;        // 8 hours of batches at 5 min
+const uint16_t batchMax = 1000;        // Bytes per batch message
+const unsigned long windowTimeout = 30000;
+const unsigned long connectRetry = 3000;
+const int publishesPerPoll = 4;
+// Wait for CONNACK and for each read, in seconds; PubSubClient's default of
+// 15 s alone would reach LOOP_HANG_MS
+const uint16_t socketTimeoutS = 2;
+
+static WiFiClient net;
+static PubSubClient mqtt;
+static FlashQueue queue;
+static uint8_t batch[batchMax];
+static uint32_t lastQueuedSeq = 0;
+static MqttSchedule schedule = {MQTT_PUBLISH_INTERVAL_MS, windowTimeout, 0, false, 0};
+static unsigned long lastConnectTry = 0;
+
+static void closeWindow() {
+  if (!schedule.windowOpen) return;
+  if (mqtt.connected()) mqtt.disconnect();
+  wifiRelease();
+  schedule.windowOpen = false;
+  logPrintf("MQTT window closed, %lu queued\n", (unsigned long)queue.size());
+}
+
+static void publishQueued() {
+  for (int i = 0; i < publishesPerPoll && !queue.empty(); i++) {
+    int len = queue.peek(batch, batchMax);
+    if (len == flashQueueBadSlot) {
+      queue.pop();  // Torn or overwritten, cannot be sent
+      continue;
+    }
+    if (len < 0) return;  // Read error: keep the batch, retry next poll
+    if (!mqtt.publish(MQTT_TOPIC, batch, len)) return;  // Retry next poll
+    queue.pop();
+  }
+}
+
+void mqttBegin() {
+  if (!queue.begin(LittleFS, "/mqtt_queue.bin", queueSlots, batchMax)) {
+    logPrintln("MQTT queue unavailable");
+  }
+  mqtt.setClient(net);
+  mqtt.setServer(MQTT_HOST, MQTT_PORT);
+  mqtt.setBufferSize(batchMax + 64);
+  mqtt.setSocketTimeout(socketTimeoutS);
+  schedule.lastBatch = millis();
+  logPrintf("MQTT: %lu batches queued from before reboot\n", (unsigned long)queue.size());
+}
+
+void mqttPoll(float temp, float humidity, float pressure) {
+  unsigned long now = millis();
+
+  bool wasOpen = schedule.windowOpen;
+  if (mqttBatchDue(schedule, now)) {
+    // Usually one message; more only if many bins piled up
+    do {
+      int len = mqttBuildBatch(batch, batchMax, lastQueuedSeq, now / 1000, clockNow(), temp,
+                               humidity, pressure);
+      queue.push(batch, len);
+    } while (lastQueuedSeq < historySeq(METRIC_TEMP));
+    if (!wasOpen) {
+      lastConnectTry = now - connectRetry;
+      wifiAcquire();
+    }
+  }
+
+  switch (mqttWindowStep(schedule, now, queue.empty(), wifiState())) {
+    case MQTT_WINDOW_CLOSE:
+      closeWindow();
+      return;
+    case MQTT_WINDOW_SEND:
+      break;
+    default:
+      return;
+  }
+
+  if (!mqtt.connected()) {
+    if (now - lastConnectTry < connectRetry) return;
+    lastConnectTry = now;
+    char clientId[24];
+    snprintf(clientId, sizeof(clientId), "cardenv-%08lx", (unsigned long)ESP.getEfuseMac());
+    bool ok = strlen(MQTT_USER) > 0 ? mqtt.connect(clientId, MQTT_USER, MQTT_PASSWORD)
+                                    : mqtt.connect(clientId);
+    if (!ok) {
+      logPrintf("MQTT connect failed (%d)\n", mqtt.state());
+      return;
+    }
+  }
+  mqtt.loop();
+  publishQueued();
+}
+
+#else
+
+void mqttBegin() {}
+void mqttPoll(float, float, float) {}
+
+#endif
@@ -0,0 +1,112 @@
+#include "pressure_profile.h"
+
+#include <M5UnitENV.h>
+#include <Wire.h>
+
+// IO_SETUP register: bits 7:5 select the standby time between normal
+// mode conversions (not exposed by the library)
+static const uint8_t regIoSetup = 0xF5;
+enum Standby : uint8_t {
+  STANDBY_1MS = 0, STANDBY_5MS, STANDBY_50MS, STANDBY_250MS,
+  STANDBY_500MS, STANDBY_1S, STANDBY_2S, STANDBY_4S
+};
+
+struct ProfileSpec {
+  const char* name;
+  uint8_t powerMode;
+  uint8_t oversamplingP;
+  uint8_t oversamplingT;
+  uint8_t filter;
+  uint8_t standby;        // Normal mode only
+  uint32_t periodMs;      // New result this often
+  uint32_t conversionMs;  // Forced mode: start to result (datasheet max)
+};
+
+static const ProfileSpec profiles[PRESSURE_PROFILE_COUNT] = {
+  {"Fast", QMP6988_NORMAL_MODE, QMP6988_OVERSAMPLING_4X, QMP6988_OVERSAMPLING_1X,
+   QMP6988_FILTERCOEFF_2, STANDBY_50MS, 50, 0},
+  {"Balanced", QMP6988_NORMAL_MODE, QMP6988_OVERSAMPLING_16X, QMP6988_OVERSAMPLING_2X,
+   QMP6988_FILTERCOEFF_4, STANDBY_500MS, 500, 0},
+  {"Low power", QMP6988_FORCED_MODE, QMP6988_OVERSAMPLING_8X, QMP6988_OVERSAMPLING_1X,
+   QMP6988_FILTERCOEFF_OFF, STANDBY_1MS, 10000, 14},
+};
+
+static QMP6988* sensor = nullptr;
+static TwoWire* bus = nullptr;
+static uint8_t sensorAddress = 0;
+static PressureProfile current = PRESSURE_BALANCED;
+static unsigned long nextDueMs = 0;
+static bool converting = false;  // Forced conversion started, not yet read
+static uint32_t transfers = 0;
+
+const char* pressureProfileName(PressureProfile profile) {
+  return profiles[profile].name;
+}
+
+uint32_t pressureProfilePeriodMs(PressureProfile profile) {
+  return profiles[profile].periodMs;
+}
+
+static void writeStandby(uint8_t standby) {
+  bus->beginTransmission(sensorAddress);
+  bus->write(regIoSetup);
+  bus->write((uint8_t)(standby << 5));
+  bus->endTransmission();
+}
+
+void pressureSetProfile(PressureProfile profile, unsigned long nowMs) {
+  current = profile < PRESSURE_PROFILE_COUNT ? profile : PRESSURE_BALANCED;
+  if (!sensor) return;
+  const ProfileSpec& p = profiles[current];
+  // Configure asleep, then start the mode (forced starts per conversion)
+  sensor->setpPowermode(QMP6988_SLEEP_MODE);
+  sensor->setOversamplingP(p.oversamplingP);
+  sensor->setOversamplingT(p.oversamplingT);
+  sensor->setFilter(p.filter);
+  writeStandby(p.standby);
+  if (p.powerMode == QMP6988_NORMAL_MODE) {
+    sensor->setpPowermode(QMP6988_NORMAL_MODE);
+    nextDueMs = nowMs + p.periodMs;
+  } else {
+    nextDueMs = nowMs;  // First conversion right away
+  }
+  converting = false;
+}
+
+void pressureBegin(QMP6988& s, TwoWire& wire, uint8_t address,
+                   PressureProfile profile, unsigned long nowMs) {
+  sensor = &s;
+  bus = &wire;
+  sensorAddress = address;
+  pressureSetProfile(profile, nowMs);
+}
+
+bool pressurePoll(unsigned long nowMs) {
+  if (!sensor || (long)(nowMs - nextDueMs) < 0) return false;
+  const ProfileSpec& p = profiles[current];
+
+  if (p.powerMode == QMP6988_FORCED_MODE && !converting) {
+    // Writing forced mode starts one conversion; read it when done
+    sensor->setpPowermode(QMP6988_FORCED_MODE);
+    transfers++;
+    converting = true;
+    nextDueMs = nowMs + p.conversionMs;
+    return false;
+  }
+
+  sensor->update();
+  transfers++;
+  if (converting) {
+    converting = false;
+    nextDueMs = nowMs - p.conversionMs + p.periodMs;
+  } else {
+    nextDueMs += p.periodMs;
+    // Skip missed periods instead of bursting to catch up
+    if ((long)(nowMs - nextDueMs) >= 0) nextDueMs = nowMs + p.periodMs;
+  }
+  return true;
+}
+
+uint32_t pressureTransfers() {
+  return transfers;
+}
@@ -0,0 +1,48 @@
+#include "render_probe.h"
+#include "crc32.h"
+
+// Expand one RGB565 row to RGB888
+static void rowToRgb888(CountingCanvas& canvas, int y, uint8_t* rgb) {
+  int w = canvas.width();
+  for (int x = 0; x < w; x++) {
+    uint16_t c = canvas.readPixel(x, y);
+    uint8_t r = (c >> 11) & 0x1F;
+    uint8_t g = (c >> 5) & 0x3F;
+    uint8_t b = c & 0x1F;
+    rgb[x * 3 + 0] = (r << 3) | (r >> 2);
+    rgb[x * 3 + 1] = (g << 2) | (g >> 4);
+    rgb[x * 3 + 2] = (b << 3) | (b >> 2);
+  }
+}
+
+uint32_t renderProbeCrc(CountingCanvas& canvas) {
+  static uint8_t row[320 * 3];
+  uint32_t crc = 0;
+  int h = canvas.height();
+  for (int y = 0; y < h; y++) {
+    rowToRgb888(canvas, y, row);
+    crc = crc32Update(crc, row, canvas.width() * 3);
+  }
+  return crc;
+}
+
+void renderProbeReport(Print& out, const char* page, const RenderStats& stats) {
+  out.printf("probe page=%s prims=%lu pixels=%lu us=%lu crc=%08lx\n", page,
+             (unsigned long)stats.primitives, (unsigned long)stats.pixels,
+             (unsigned long)stats.elapsedUs, (unsigned long)stats.crc);
+}
+
+void renderProbeDumpPpm(Print& out, const char* page, CountingCanvas& canvas) {
+  static uint8_t row[320 * 3];
+  int w = canvas.width();
+  int h = canvas.height();
+  char header[32];
+  int headerLen = snprintf(header, sizeof(header), "P6\n%d %d\n255\n", w, h);
+  out.printf("ppm %s %d\n", page, headerLen + w * h * 3);
+  out.write((const uint8_t*)header, headerLen);
+  for (int y = 0; y < h; y++) {
+    rowToRgb888(canvas, y, row);
+    out.write(row, w * 3);
+  }
+  out.flush();
+}
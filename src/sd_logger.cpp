@@ -0,0 +1,223 @@
+#include "sd_logger.h"
+#include "config.h"
+
+#include <SD.h>
+#include <SPI.h>
+#include <time.h>
+#include "col_log.h"
+#include "history.h"
+#include "log_sink.h"
+#include "wallclock.h"
+
+// Cardputer microSD slot
+const int sdSck = 40;
+const int sdMiso = 39;
+const int sdMosi = 14;
+const int sdCs = 12;
+
+// A day whose file cannot be opened is retried this often, not every poll
+const unsigned long openRetryDelay = 60000;
+
+static SPIClass sdSpi(HSPI);
+static bool ready = false;
+static ColLogWriter writer;
+static uint32_t openDay = 0;      // UTC day number of the open file
+static int openPart = 0;          // Continuation of that day, 0 for the first file
+static uint32_t firstDay = 0;     // Oldest file on the card, 0 if none
+static uint32_t nextSeq[METRIC_COUNT];  // Next history bin to log, per metric
+static unsigned long lastFlush = 0;
+static uint32_t failedDay = 0;    // Day whose file last failed to open, 0 if none
+static unsigned long failedAt = 0;
+
+void sdLogPath(char* buf, int size, uint32_t unixTime, int part) {
+  time_t t = unixTime;
+  struct tm tm;
+  gmtime_r(&t, &tm);
+  if (part == 0) {
+    snprintf(buf, size, "/envlog/%04d%02d%02d.ecl", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+  } else {
+    snprintf(buf, size, "/envlog/%04d%02d%02d-%d.ecl", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, part);
+  }
+}
+
+// UTC day number of a log file name ("YYYYMMDD.ecl" or "YYYYMMDD-N.ecl"),
+// 0 if not one
+static uint32_t dayOfName(const char* name) {
+  const char* base = strrchr(name, '/');
+  base = base ? base + 1 : name;
+  int year, m, d;
+  if (sscanf(base, "%4d%2d%2d", &year, &m, &d) != 3 || !strstr(base, ".ecl")) return 0;
+  // Days from civil date, as in clockLocalDay()
+  int y = year - (m < 3);
+  int era = y / 400;
+  int yoe = y - era * 400;
+  int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+static void findFirstDay() {
+  File dir = SD.open("/envlog");
+  if (!dir) return;
+  for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+    uint32_t day = dayOfName(f.name());
+    if (day && (firstDay == 0 || day < firstDay)) firstDay = day;
+    f.close();
+  }
+  dir.close();
+}
+
+void sdLogBegin() {
+#if ENABLE_SD_LOG
+  sdSpi.begin(sdSck, sdMiso, sdMosi, sdCs);
+  if (!SD.begin(sdCs, sdSpi, 25000000)) {
+    logPrintln("SD: no card");
+    return;
+  }
+  if (!SD.exists("/envlog")) SD.mkdir("/envlog");
+  findFirstDay();
+  ready = true;
+  for (int m = 0; m < METRIC_COUNT; m++) nextSeq[m] = historySeq((Metric)m) - historyCount((Metric)m);
+  logPrintln("SD log OK");
+#endif
+}
+
+bool sdLogReady() {
+  return ready;
+}
+
+uint32_t sdLogBlocksWritten() {
+  return writer.blocksWritten();
+}
+
+// Samples the writer could not get onto the card are logged again, once
+// the file has been reopened after the retry delay
+static void closeWriter() {
+  if (writer.close()) return;
+  for (int m = 0; m < METRIC_COUNT; m++) nextSeq[m] -= writer.pending(m);
+  failedDay = openDay;
+  failedAt = millis();
+}
+
+static bool openFor(uint32_t unixTime) {
+  uint32_t day = unixTime / 86400;
+  if (writer.isOpen() && day == openDay) return true;
+  bool retry = day == failedDay;
+  if (retry && millis() - failedAt < openRetryDelay) return false;
+  if (writer.isOpen()) closeWriter();
+  char path[32];
+  if (day != openDay) {
+    // Appends go to the day's latest continuation file
+    openPart = 0;
+    for (;;) {
+      sdLogPath(path, sizeof(path), unixTime, openPart + 1);
+      if (!SD.exists(path)) break;
+      openPart++;
+    }
+  }
+  sdLogPath(path, sizeof(path), unixTime, openPart);
+  ColLogRecovery recovery = {0, 0};
+  unsigned long start = millis();
+  if (!writer.open(SD, path, &recovery)) {
+    // Reported once per day; the bins wait in history for the next try
+    if (!retry) logPrintf("SD: cannot open %s, retrying every %lu s\n", path, openRetryDelay / 1000);
+    failedDay = day;
+    failedAt = millis();
+    return false;
+  }
+  failedDay = 0;
+  if (recovery.dropped || recovery.added) {
+    logPrintf("SD: recovered %s in %lu ms (%d torn, %d reindexed)\n", path, millis() - start,
+              recovery.dropped, recovery.added);
+  }
+  openDay = day;
+  if (firstDay == 0 || day < firstDay) firstDay = day;
+  return true;
+}
+
+// Stops the day loop once the caller's callback has stopped a query
+struct QueryStop {
+  bool (*fn)(uint32_t time, float value, void* ctx);
+  void* ctx;
+  bool stopped;
+};
+
+static bool queryForward(uint32_t time, float value, void* ctx) {
+  QueryStop& q = *(QueryStop*)ctx;
+  q.stopped = !q.fn(time, value, q.ctx);
+  return !q.stopped;
+}
+
+int sdLogQuery(uint8_t metric, uint32_t t0, uint32_t t1,
+               bool (*fn)(uint32_t time, float value, void* ctx), void* ctx) {
+  if (!ready || firstDay == 0) return 0;
+  uint32_t now = clockNow();
+  if (now && t1 > now) t1 = now;
+  if (t0 < firstDay * 86400) t0 = firstDay * 86400;
+  if (t1 < t0) return 0;
+
+  static ColLogReader reader;
+  QueryStop stop = {fn, ctx, false};
+  int n = 0;
+  for (uint32_t day = t0 / 86400; day <= t1 / 86400 && !stop.stopped; day++) {
+    // A day's continuation files follow each other in time
+    for (int part = 0; !stop.stopped; part++) {
+      char path[32];
+      sdLogPath(path, sizeof(path), day * 86400, part);
+      if (!SD.exists(path)) break;
+      if (!reader.open(SD, path)) continue;
+      n += reader.query(metric, t0, t1, queryForward, &stop);
+      reader.close();
+    }
+  }
+  // Samples still buffered in RAM are the newest; read them where they are
+  // rather than spend a zone map entry on a partial block
+  if (!stop.stopped) n += writer.queryPending(metric, t0, t1, queryForward, &stop);
+  return n;
+}
+
+void sdLogPoll() {
+  if (!ready || !clockValid()) return;
+
+  // Each metric is logged at its own bin width, as its own series. Bins
+  // are merged in time order so a day's file is never reopened.
+  while (true) {
+    int next = -1;
+    int nextIndex = 0;
+    uint32_t nextTime = 0;
+    for (int m = 0; m < METRIC_COUNT; m++) {
+      uint32_t oldestSeq = historySeq((Metric)m) - historyCount((Metric)m);
+      if (nextSeq[m] < oldestSeq) nextSeq[m] = oldestSeq;
+      if (nextSeq[m] >= historySeq((Metric)m)) continue;
+      int i = nextSeq[m] - oldestSeq;
+      uint32_t t = historyTime((Metric)m, i);
+      if (next < 0 || t < nextTime) {
+        next = m;
+        nextIndex = i;
+        nextTime = t;
+      }
+    }
+    if (next < 0) break;
+    uint32_t t = clockFromUptime(nextTime);
+    if (!openFor(t)) return;
+    if (writer.append(next, t, historyValue((Metric)next, nextIndex))) {
+      nextSeq[next]++;
+    } else if (writer.full()) {
+      // Out of index room: the day goes on in a continuation file
+      closeWriter();
+      openPart++;
+    } else {
+      // Write error: reopened after the retry delay, the bin waits in history
+      if (failedDay != openDay) logPrintln("SD: write failed, reopening");
+      closeWriter();
+      failedDay = openDay;
+      failedAt = millis();
+      return;
+    }
+  }
+
+  if (writer.isOpen() && millis() - lastFlush >= SD_LOG_FLUSH_INTERVAL_MS) {
+    lastFlush = millis();
+    writer.flush();
+  }
+}
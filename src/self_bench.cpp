@@ -0,0 +1,129 @@
+#include "self_bench.h"
+
+#include <Preferences.h>
+#include <Wire.h>
+#include "sht30_periodic.h"
+
+static const char* scratchPath = "/bench.tmp";
+static const int i2cRepeats = 50;
+static const int nvsRepeats = 10;
+
+void benchDisplay(lgfx::LovyanGFX& panel, BenchResults& out) {
+  int w = panel.width();
+  int h = panel.height();
+
+  // Fill rate; waitDisplay() so DMA transfers are counted in full
+  const int fills = 10;
+  unsigned long start = micros();
+  for (int i = 0; i < fills; i++) panel.fillScreen(i & 1 ? TFT_BLUE : TFT_BLACK);
+  panel.waitDisplay();
+  unsigned long us = micros() - start;
+  out.fillMpixPerSec = (float)fills * w * h / us;
+
+  // Primitive rate: small shapes, where per-call overhead dominates
+  const int rects = 1000;
+  start = micros();
+  for (int i = 0; i < rects; i++) {
+    panel.fillRect((i * 13) % (w - 8), (i * 7) % (h - 8), 8, 8, i * 2111);
+  }
+  panel.waitDisplay();
+  out.rectsPerSec = rects * 1e6f / (micros() - start);
+
+  const int lines = 1000;
+  start = micros();
+  for (int i = 0; i < lines; i++) {
+    int x = (i * 17) % (w - 16);
+    int y = (i * 11) % (h - 16);
+    panel.drawLine(x, y, x + 15, y + 15, i * 977);
+  }
+  panel.waitDisplay();
+  out.linesPerSec = lines * 1e6f / (micros() - start);
+
+  // Full-screen sprite push, as used by the density page
+  out.spritePushUs = -1;
+  M5Canvas sprite(&panel);
+  sprite.setColorDepth(16);
+  if (sprite.createSprite(w, h)) {
+    sprite.fillScreen(TFT_DARKGREY);
+    const int pushes = 10;
+    start = micros();
+    for (int i = 0; i < pushes; i++) sprite.pushSprite(0, 0);
+    panel.waitDisplay();
+    out.spritePushUs = (float)(micros() - start) / pushes;
+    sprite.deleteSprite();
+  }
+}
+
+void benchI2c(Sht30Bus& sht30, TwoWire& wire, uint8_t qmpAddress, BenchResults& out) {
+  // Status register: allowed in periodic mode, leaves measurements alone
+  uint8_t buf[3];
+  int ok = 0;
+  unsigned long start = micros();
+  for (int i = 0; i < i2cRepeats; i++) {
+    if (sht30.command(0xF32D) && sht30.read(buf, 3)) ok++;
+  }
+  out.sht30Us = ok == i2cRepeats ? (float)(micros() - start) / i2cRepeats : -1;
+
+  out.qmp6988Us = -1;
+  if (!qmpAddress) return;
+  ok = 0;
+  start = micros();
+  for (int i = 0; i < i2cRepeats; i++) {
+    wire.beginTransmission(qmpAddress);
+    wire.write((uint8_t)0xD1);  // CHIP_ID
+    if (wire.endTransmission(false) == 0 && wire.requestFrom(qmpAddress, (uint8_t)1) == 1) {
+      wire.read();
+      ok++;
+    }
+  }
+  if (ok == i2cRepeats) out.qmp6988Us = (float)(micros() - start) / i2cRepeats;
+}
+
+void benchStorage(fs::FS& fs, uint32_t bytes, float& writeKBps, float& readKBps) {
+  static uint8_t block[4096];
+  writeKBps = readKBps = -1;
+  for (size_t i = 0; i < sizeof(block); i++) block[i] = i * 31;
+
+  File f = fs.open(scratchPath, "w");
+  if (!f) return;
+  unsigned long start = micros();
+  uint32_t written = 0;
+  while (written < bytes && f.write(block, sizeof(block)) == sizeof(block)) written += sizeof(block);
+  f.close();  // Includes the final flush
+  unsigned long us = micros() - start;
+  if (written == bytes) writeKBps = bytes / 1.024f / (us / 1000.0f);
+
+  f = fs.open(scratchPath, "r");
+  if (f) {
+    start = micros();
+    uint32_t read = 0;
+    size_t n;
+    while ((n = f.read(block, sizeof(block))) > 0) read += n;
+    f.close();
+    us = micros() - start;
+    if (read == bytes) readKBps = bytes / 1.024f / (us / 1000.0f);
+  }
+  fs.remove(scratchPath);
+}
+
+void benchNvs(BenchResults& out) {
+  // Every put is committed to flash before it returns
+  Preferences prefs;
+  out.nvsCommitUs = -1;
+  if (!prefs.begin("cardbench", false)) return;
+  unsigned long start = micros();
+  for (int i = 0; i < nvsRepeats; i++) prefs.putUInt("n", micros());
+  out.nvsCommitUs = (float)(micros() - start) / nvsRepeats;
+  prefs.remove("n");
+  prefs.end();
+}
+
+int benchFormat(char* buf, int size, const BenchResults& r) {
+  int len = snprintf(buf, size, "bench fill_mpix_s=%.2f rects_s=%.0f lines_s=%.0f sprite_push_us=%.0f "
+                     "sht30_us=%.0f qmp6988_us=%.0f flash_write_kbs=%.0f flash_read_kbs=%.0f "
+                     "sd_write_kbs=%.0f sd_read_kbs=%.0f nvs_commit_us=%.0f\n",
+                     r.fillMpixPerSec, r.rectsPerSec, r.linesPerSec, r.spritePushUs,
+                     r.sht30Us, r.qmp6988Us, r.flashWriteKBps, r.flashReadKBps,
+                     r.sdWriteKBps, r.sdReadKBps, r.nvsCommitUs);
+  return len < size ? len : size - 1;
+}
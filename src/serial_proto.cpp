@@ -0,0 +1,441 @@
+#include "serial_proto.h"
+#include "crc32.h"
+#include "log_sink.h"
+#include "sd_logger.h"
+#include "trace.h"
+#include "wallclock.h"
+
+// Records per RSP_DUMP_DATA frame; keeps frames well under the CDC TX buffer
+const int dumpRecordsPerFrame = 12;
+// Trace events per RSP_TRACE_DATA frame
+const int traceEventsPerFrame = 24;
+// Samples per RSP_SD_DATA frame
+const int sdRecordsPerFrame = 24;
+// Dump frames started per protoPoll() call (each still only if TX has room)
+const int dumpFramesPerPoll = 4;
+// Input bytes parsed per protoPoll() call
+const int rxBudget = 64;
+
+enum RxState { RX_SYNC, RX_TYPE, RX_LEN0, RX_LEN1, RX_PAYLOAD, RX_CRC };
+
+static Stream* port = nullptr;
+
+// Receive state
+static RxState rxState = RX_SYNC;
+static uint8_t rxType;
+static uint16_t rxLen;
+static uint16_t rxPos;
+static uint8_t rxPayload[PROTO_MAX_PAYLOAD];
+static uint32_t rxCrc;
+
+// Transmit state: one frame in flight, written as TX space allows
+static uint8_t txBuf[PROTO_MAX_PAYLOAD + 8];
+static uint16_t txLen = 0;
+static uint16_t txOff = 0;
+
+// Dump job, tracked by history sequence number so ring wrap is detected
+static bool dumpActive = false;
+static uint32_t dumpNextSeq;
+static uint32_t dumpEndSeq;
+static uint16_t dumpSent;
+static uint16_t dumpSkipped;
+
+// Trace dump job, over ring positions captured when it started
+static bool traceDumpActive = false;
+static uint32_t traceNext;
+static uint32_t traceEnd;
+static uint16_t traceSent;
+
+// SD dump job; each frame is a fresh query starting after the last sample sent
+static bool sdDumpActive = false;
+static bool sdMore;
+static uint8_t sdMetric;
+static uint32_t sdNext;
+static uint32_t sdEnd;
+static uint32_t sdSent;
+
+static uint32_t rxFrames = 0;
+static uint32_t rxErrors = 0;
+static uint32_t txFrames = 0;
+
+//----------------------------------------------------------
+// Framing
+//----------------------------------------------------------
+
+static void flushTx() {
+  while (txOff < txLen) {
+    int room = port->availableForWrite();
+    if (room <= 0) return;
+    int n = txLen - txOff;
+    if (n > room) n = room;
+    txOff += port->write(txBuf + txOff, n);
+  }
+}
+
+static bool txIdle() {
+  return txOff >= txLen;
+}
+
+// Queue one frame; caller must check txIdle() first
+static void sendFrame(uint8_t type, const void* payload, uint16_t len) {
+  txBuf[0] = PROTO_SYNC;
+  txBuf[1] = type;
+  txBuf[2] = len & 0xFF;
+  txBuf[3] = len >> 8;
+  memcpy(txBuf + 4, payload, len);
+  uint32_t crc = crc32(txBuf + 1, 3 + len);
+  memcpy(txBuf + 4 + len, &crc, 4);
+  txLen = len + 8;
+  txOff = 0;
+  txFrames++;
+  flushTx();
+}
+
+static void sendError(uint8_t code) {
+  sendFrame(RSP_ERROR, &code, 1);
+}
+
+//----------------------------------------------------------
+// Commands
+//----------------------------------------------------------
+
+static void startDump(const uint8_t* p, uint16_t len) {
+  if (len != 9) {
+    sendError(PROTO_ERR_BAD_LENGTH);
+    return;
+  }
+  uint8_t tier = p[0];
+  uint32_t t0, t1;
+  memcpy(&t0, p + 1, 4);
+  memcpy(&t1, p + 5, 4);
+  if (tier != 0) {
+    sendError(PROTO_ERR_BAD_TIER);
+    return;
+  }
+
+  int first = historyFind(METRIC_TEMP, t0);
+  int end = (t1 == 0xFFFFFFFF) ? historyCount(METRIC_TEMP) : historyFind(METRIC_TEMP, t1 + 1);
+  if (end < first) end = first;
+  uint32_t oldestSeq = historySeq(METRIC_TEMP) - historyCount(METRIC_TEMP);
+  dumpNextSeq = oldestSeq + first;
+  dumpEndSeq = oldestSeq + end;
+  dumpSent = 0;
+  dumpSkipped = 0;
+  dumpActive = true;
+
+  uint8_t begin[4];
+  uint16_t count = end - first;
+  begin[0] = tier;
+  memcpy(begin + 1, &count, 2);
+  begin[3] = sizeof(ProtoHistoryRecord);
+  sendFrame(RSP_DUMP_BEGIN, begin, sizeof(begin));
+}
+
+static void startTraceDump() {
+  if (!ENABLE_TRACE) {
+    sendError(PROTO_ERR_NO_TRACE);
+    return;
+  }
+  // Paused so the events being sent are not overwritten under us
+  tracePause(true);
+  uint32_t count = traceSnapshot(traceNext);
+  traceEnd = traceNext + count;
+  traceSent = 0;
+  traceDumpActive = true;
+
+  uint8_t begin[5];
+  uint16_t mhz = ESP.getCpuFreqMHz();
+  uint16_t n = count;
+  memcpy(begin, &mhz, 2);
+  memcpy(begin + 2, &n, 2);
+  begin[4] = sizeof(TraceEvent);
+  sendFrame(RSP_TRACE_BEGIN, begin, sizeof(begin));
+}
+
+static void continueTraceDump() {
+  if (traceNext >= traceEnd) {
+    sendFrame(RSP_TRACE_END, &traceSent, 2);
+    traceDumpActive = false;
+    tracePause(false);
+    return;
+  }
+  TraceEvent events[traceEventsPerFrame];
+  int n = 0;
+  while (n < traceEventsPerFrame && traceNext < traceEnd) {
+    events[n++] = traceEventAt(traceNext++);
+  }
+  traceSent += n;
+  sendFrame(RSP_TRACE_DATA, events, n * sizeof(TraceEvent));
+}
+
+static void startSdDump(const uint8_t* p, uint16_t len) {
+  if (len != 9) {
+    sendError(PROTO_ERR_BAD_LENGTH);
+    return;
+  }
+  if (p[0] >= METRIC_COUNT) {
+    sendError(PROTO_ERR_BAD_METRIC);
+    return;
+  }
+  if (!sdLogReady() || !clockValid()) {
+    sendError(PROTO_ERR_NO_SD);
+    return;
+  }
+  sdMetric = p[0];
+  memcpy(&sdNext, p + 1, 4);
+  memcpy(&sdEnd, p + 5, 4);
+  sdSent = 0;
+  sdMore = true;
+  sdDumpActive = true;
+
+  uint8_t begin[2] = {sdMetric, sizeof(ProtoSdRecord)};
+  sendFrame(RSP_SD_BEGIN, begin, sizeof(begin));
+}
+
+struct SdFrame {
+  ProtoSdRecord records[sdRecordsPerFrame];
+  int count;
+  bool full;  // A sample was refused: there is more after this frame
+};
+
+static bool collectSdRecord(uint32_t time, float value, void* ctx) {
+  SdFrame& f = *(SdFrame*)ctx;
+  if (f.count == sdRecordsPerFrame) {
+    f.full = true;
+    return false;
+  }
+  f.records[f.count].time = time;
+  f.records[f.count].value = value;
+  f.count++;
+  return true;
+}
+
+static void continueSdDump() {
+  SdFrame f;
+  f.count = 0;
+  f.full = false;
+  if (sdMore) sdLogQuery(sdMetric, sdNext, sdEnd, collectSdRecord, &f);
+  if (f.count == 0) {
+    sendFrame(RSP_SD_END, &sdSent, 4);
+    sdDumpActive = false;
+    return;
+  }
+  // Times within one metric's series are strictly increasing
+  sdMore = f.full;
+  sdNext = f.records[f.count - 1].time + 1;
+  sdSent += f.count;
+  sendFrame(RSP_SD_DATA, f.records, f.count * sizeof(ProtoSdRecord));
+}
+
+static bool dumping() {
+  return dumpActive || traceDumpActive || sdDumpActive;
+}
+
+static void continueDump() {
+  uint32_t oldestSeq = historySeq(METRIC_TEMP) - historyCount(METRIC_TEMP);
+  if (dumpNextSeq < oldestSeq) {
+    // Overwritten by new samples while we were streaming
+    dumpSkipped += oldestSeq - dumpNextSeq;
+    dumpNextSeq = oldestSeq;
+  }
+
+  if (dumpNextSeq >= dumpEndSeq) {
+    uint8_t end[4];
+    memcpy(end, &dumpSent, 2);
+    memcpy(end + 2, &dumpSkipped, 2);
+    sendFrame(RSP_DUMP_END, end, sizeof(end));
+    dumpActive = false;
+    return;
+  }
+
+  ProtoHistoryRecord records[dumpRecordsPerFrame];
+  int n = 0;
+  while (n < dumpRecordsPerFrame && dumpNextSeq < dumpEndSeq) {
+    int i = dumpNextSeq - oldestSeq;
+    uint32_t t = historyTime(METRIC_TEMP, i);
+    records[n].time = t;
+    records[n].temp = historyValue(METRIC_TEMP, i);
+    records[n].humidity = historyValueAt(METRIC_HUMIDITY, t);
+    records[n].pressure = historyValueAt(METRIC_PRESSURE, t);
+    n++;
+    dumpNextSeq++;
+  }
+  dumpSent += n;
+  sendFrame(RSP_DUMP_DATA, records, n * sizeof(ProtoHistoryRecord));
+}
+
+static void handleFrame() {
+  rxFrames++;
+  switch (rxType) {
+    case CMD_GET_READING: {
+      ProtoReading reading;
+      protoFillReading(reading);
+      sendFrame(RSP_READING, &reading, sizeof(reading));
+      break;
+    }
+    case CMD_DUMP_HISTORY:
+      if (dumping()) {
+        sendError(PROTO_ERR_BUSY);
+      } else {
+        startDump(rxPayload, rxLen);
+      }
+      break;
+    case CMD_GET_STATS: {
+      ProtoStats stats;
+      protoFillStats(stats);
+      sendFrame(RSP_STATS, &stats, sizeof(stats));
+      break;
+    }
+    case CMD_SET_SETTING: {
+      if (rxLen != 5) {
+        sendError(PROTO_ERR_BAD_LENGTH);
+        break;
+      }
+      int32_t value;
+      memcpy(&value, rxPayload + 1, 4);
+      if (protoApplySetting(rxPayload[0], value)) {
+        sendFrame(RSP_SETTING, rxPayload, 5);
+      } else {
+        sendError(PROTO_ERR_BAD_SETTING);
+      }
+      break;
+    }
+    case CMD_SET_TIME: {
+      // For setups without Wi-Fi: the host supplies the wall clock
+      if (rxLen != 4) {
+        sendError(PROTO_ERR_BAD_LENGTH);
+        break;
+      }
+      uint32_t unixTime;
+      memcpy(&unixTime, rxPayload, 4);
+      clockSet(unixTime);
+      if (!clockValid()) {
+        sendError(PROTO_ERR_BAD_TIME);
+        break;
+      }
+      logPrintf("Clock set to %lu\n", (unsigned long)unixTime);
+      sendFrame(RSP_TIME, &unixTime, 4);
+      break;
+    }
+    case CMD_DUMP_TRACE:
+      if (dumping()) {
+        sendError(PROTO_ERR_BUSY);
+      } else {
+        startTraceDump();
+      }
+      break;
+    case CMD_DUMP_SD:
+      if (dumping()) {
+        sendError(PROTO_ERR_BUSY);
+      } else {
+        startSdDump(rxPayload, rxLen);
+      }
+      break;
+    default:
+      sendError(PROTO_ERR_UNKNOWN_CMD);
+      break;
+  }
+}
+
+// Feed one byte; returns true when a complete, valid frame is in rxPayload
+static bool rxByte(uint8_t b) {
+  switch (rxState) {
+    case RX_SYNC:
+      if (b == PROTO_SYNC) rxState = RX_TYPE;
+      break;
+    case RX_TYPE:
+      rxType = b;
+      rxState = RX_LEN0;
+      break;
+    case RX_LEN0:
+      rxLen = b;
+      rxState = RX_LEN1;
+      break;
+    case RX_LEN1:
+      rxLen |= b << 8;
+      rxPos = 0;
+      if (rxLen > PROTO_MAX_PAYLOAD) {
+        rxErrors++;
+        rxState = RX_SYNC;
+      } else {
+        rxState = (rxLen == 0) ? RX_CRC : RX_PAYLOAD;
+      }
+      break;
+    case RX_PAYLOAD:
+      rxPayload[rxPos++] = b;
+      if (rxPos == rxLen) {
+        rxPos = 0;
+        rxState = RX_CRC;
+      }
+      break;
+    case RX_CRC:
+      if (rxPos == 0) rxCrc = 0;
+      rxCrc |= (uint32_t)b << (rxPos * 8);
+      if (++rxPos == 4) {
+        rxState = RX_SYNC;
+        uint8_t header[3] = {rxType, (uint8_t)(rxLen & 0xFF), (uint8_t)(rxLen >> 8)};
+        uint32_t crc = crc32Update(crc32(header, 3), rxPayload, rxLen);
+        if (crc == rxCrc) return true;
+        rxErrors++;
+      }
+      break;
+  }
+  return false;
+}
+
+//----------------------------------------------------------
+// Public
+//----------------------------------------------------------
+
+void protoFillStats(ProtoStats& stats) {
+  stats.uptime = millis() / 1000;
+  stats.freeHeap = ESP.getFreeHeap();
+  stats.historyCount = historyCount(METRIC_TEMP);
+  stats.historySeq = historySeq(METRIC_TEMP);
+  stats.rxFrames = rxFrames;
+  stats.rxErrors = rxErrors;
+  stats.txFrames = txFrames;
+  stats.logDropped = logDroppedTotal();
+}
+
+void protoBegin(Stream& stream) {
+  port = &stream;
+  rxState = RX_SYNC;
+  txLen = txOff = 0;
+  dumpActive = false;
+  traceDumpActive = false;
+  sdDumpActive = false;
+}
+
+void protoPoll() {
+  if (!port) return;
+  flushTx();
+  if (!txIdle()) return;
+
+  // Requests are only parsed once the previous response is out, so at
+  // most one frame is ever buffered on our side
+  int budget = rxBudget;
+  while (budget-- > 0 && port->available() > 0) {
+    if (rxByte(port->read())) {
+      handleFrame();
+      if (!txIdle()) return;
+    }
+  }
+
+  for (int i = 0; i < dumpFramesPerPoll && dumpActive && txIdle(); i++) {
+    continueDump();
+  }
+  for (int i = 0; i < dumpFramesPerPoll && traceDumpActive && txIdle(); i++) {
+    continueTraceDump();
+  }
+  // One SD frame per poll: each is a card read
+  if (sdDumpActive && txIdle()) continueSdDump();
+}
+
+bool protoBusy() {
+  return dumping() || !txIdle();
+}
+
+bool protoTxPending() {
+  return !txIdle();
+}
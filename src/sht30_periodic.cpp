@@ -0,0 +1,171 @@
+#include "sht30_periodic.h"
+
+#include <Wire.h>
+
+static const uint16_t cmdFetchData = 0xE000;
+static const uint16_t cmdBreak = 0x3093;
+
+// Restart periodic mode after fetches have failed for this many periods
+static const int silentPeriodsBeforeRestart = 4;
+
+static const uint16_t rateCommands[SHT30_RATE_COUNT] = {
+  0x2032, 0x2130, 0x2236, 0x2334, 0x2737, 0x2B32,
+};
+static const uint32_t ratePeriods[SHT30_RATE_COUNT] = {
+  2000, 1000, 500, 250, 100, 250,
+};
+
+uint16_t sht30RateCommand(Sht30Rate rate) {
+  return rateCommands[rate];
+}
+
+uint32_t sht30RatePeriodMs(Sht30Rate rate) {
+  return ratePeriods[rate];
+}
+
+uint8_t sht30Crc(const uint8_t* data, size_t len) {
+  uint8_t crc = 0xFF;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (int b = 0; b < 8; b++) crc = (crc & 0x80) ? (crc << 1) ^ 0x31 : crc << 1;
+  }
+  return crc;
+}
+
+//----------------------------------------------------------
+// Wire bus
+//----------------------------------------------------------
+
+bool Sht30WireBus::command(uint16_t cmd) {
+  _wire.beginTransmission(_address);
+  _wire.write((uint8_t)(cmd >> 8));
+  _wire.write((uint8_t)cmd);
+  return _wire.endTransmission() == 0;
+}
+
+bool Sht30WireBus::read(uint8_t* buf, size_t len) {
+  if (_wire.requestFrom(_address, (uint8_t)len) != len) return false;
+  for (size_t i = 0; i < len; i++) buf[i] = _wire.read();
+  return true;
+}
+
+//----------------------------------------------------------
+// Driver
+//----------------------------------------------------------
+
+bool Sht30Periodic::command(uint16_t cmd) {
+  _stats.transfers++;
+  return _bus->command(cmd);
+}
+
+bool Sht30Periodic::start(unsigned long nowMs) {
+  // Break first, in case the sensor is still running from before a reset;
+  // it ignores the break otherwise
+  command(cmdBreak);
+  _lastSampleMs = nowMs;
+  _failing = false;
+  return command(rateCommands[_rate]);
+}
+
+bool Sht30Periodic::begin(Sht30Bus& bus, Sht30Rate rate, unsigned long nowMs) {
+  _bus = &bus;
+  _rate = rate < SHT30_RATE_COUNT ? rate : SHT30_MPS_1;
+  _periodMs = ratePeriods[_rate];
+  return start(nowMs);
+}
+
+bool Sht30Periodic::poll(unsigned long nowMs) {
+  if (!_bus || nowMs - _lastSampleMs < _periodMs) return false;
+
+  // Counted from the first failed fetch, not the last sample: the caller
+  // may leave long gaps between polls on purpose
+  if (_failing && nowMs - _failSinceMs >= silentPeriodsBeforeRestart * _periodMs) {
+    _stats.restarts++;
+    start(nowMs);
+    return false;
+  }
+
+  uint8_t buf[6];
+  bool ok = command(cmdFetchData);
+  if (ok) {
+    _stats.transfers++;
+    ok = _bus->read(buf, sizeof(buf));
+  }
+  if (!ok) {
+    _stats.notReady++;
+  } else if (sht30Crc(buf, 2) != buf[2] || sht30Crc(buf + 3, 2) != buf[5]) {
+    _stats.crcErrors++;
+    ok = false;
+  }
+  if (!ok) {
+    if (!_failing) _failSinceMs = nowMs;
+    _failing = true;
+    return false;
+  }
+
+  uint16_t rawT = (buf[0] << 8) | buf[1];
+  uint16_t rawH = (buf[3] << 8) | buf[4];
+  cTemp = -45.0f + 175.0f * rawT / 65535.0f;
+  humidity = 100.0f * rawH / 65535.0f;
+  _lastSampleMs = nowMs;
+  _failing = false;
+  _stats.samples++;
+  return true;
+}
+
+void Sht30Periodic::stop() {
+  if (_bus) command(cmdBreak);
+  _bus = nullptr;
+}
+
+//----------------------------------------------------------
+// Simulated sensor
+//----------------------------------------------------------
+
+bool Sht30SimBus::command(uint16_t cmd) {
+  if (!present) return false;
+  if (cmd == cmdBreak) {
+    _periodic = false;
+    return true;
+  }
+  if (cmd == cmdFetchData) {
+    // Only valid in periodic mode; the result is read next
+    _fetchPending = _periodic;
+    return _periodic;
+  }
+  for (int r = 0; r < SHT30_RATE_COUNT; r++) {
+    if (cmd == rateCommands[r]) {
+      _periodic = true;
+      _periodMs = ratePeriods[r];
+      _startMs = nowMs;
+      _lastFetchedMs = nowMs;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool Sht30SimBus::read(uint8_t* buf, size_t len) {
+  if (!present || !_fetchPending || len != 6) return false;
+  _fetchPending = false;
+  // Time of the latest completed measurement
+  unsigned long done = _startMs + (nowMs - _startMs) / _periodMs * _periodMs;
+  if (done == _startMs || done <= _lastFetchedMs) return false;  // Nothing new
+  _lastFetchedMs = done;
+
+  float t = (temperature + 45.0f) / 175.0f * 65535.0f;
+  float h = humidity / 100.0f * 65535.0f;
+  uint16_t rawT = t < 0 ? 0 : t > 65535 ? 65535 : (uint16_t)(t + 0.5f);
+  uint16_t rawH = h < 0 ? 0 : h > 65535 ? 65535 : (uint16_t)(h + 0.5f);
+  buf[0] = rawT >> 8;
+  buf[1] = rawT;
+  buf[2] = sht30Crc(buf, 2);
+  buf[3] = rawH >> 8;
+  buf[4] = rawH;
+  buf[5] = sht30Crc(buf + 3, 2);
+  if (corrupt) {
+    buf[1] ^= 0x01;
+    corrupt = false;
+  }
+  return true;
+}
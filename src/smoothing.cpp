@@ -0,0 +1,74 @@
+#include "smoothing.h"
+
+#include <math.h>
+
+const float smoothTaus[smoothTauCount] = {10.0f, 30.0f, 120.0f};
+
+// Measurement noise variance per metric, from the sensor datasheets
+// (SHT30 repeatability, QMP6988 noise at the library's oversampling)
+static const float measurementNoise[METRIC_COUNT] = {
+  0.04f * 0.04f,  // deg C
+  0.10f * 0.10f,  // %RH
+  0.05f * 0.05f,  // hPa
+};
+
+struct SmoothState {
+  bool primed;
+  unsigned long lastMs;
+  float ema[smoothTauCount];
+  float x;  // Kalman estimate
+  float p;  // and its variance
+};
+
+static SmoothState states[METRIC_COUNT];
+static SmoothMode mode = SMOOTH_OFF;
+static int tauIndex = 1;
+
+void smoothConfigure(SmoothMode newMode, int newTauIndex) {
+  mode = newMode < SMOOTH_MODE_COUNT ? newMode : SMOOTH_OFF;
+  if (newTauIndex >= 0 && newTauIndex < smoothTauCount) tauIndex = newTauIndex;
+}
+
+float smoothUpdate(Metric metric, float raw, unsigned long nowMs) {
+  SmoothState& s = states[metric];
+  float r = measurementNoise[metric];
+  if (!s.primed) {
+    for (int i = 0; i < smoothTauCount; i++) s.ema[i] = raw;
+    s.x = raw;
+    s.p = r;
+    s.lastMs = nowMs;
+    s.primed = true;
+    return raw;
+  }
+
+  float dt = (nowMs - s.lastMs) / 1000.0f;
+  s.lastMs = nowMs;
+  for (int i = 0; i < smoothTauCount; i++) {
+    float alpha = 1.0f - expf(-dt / smoothTaus[i]);
+    s.ema[i] += alpha * (raw - s.ema[i]);
+  }
+
+  // Process noise per step chosen so the steady-state gain is ~dt / tau
+  float k = dt / smoothTaus[tauIndex];
+  s.p += r * k * k;
+  float gain = s.p / (s.p + r);
+  s.x += gain * (raw - s.x);
+  s.p *= 1.0f - gain;
+
+  switch (mode) {
+    case SMOOTH_EMA:
+      return s.ema[tauIndex];
+    case SMOOTH_KALMAN:
+      return s.x;
+    default:
+      return raw;
+  }
+}
+
+float smoothEma(Metric metric, int i) {
+  return states[metric].ema[i];
+}
+
+void smoothReset() {
+  for (int m = 0; m < METRIC_COUNT; m++) states[m].primed = false;
+}
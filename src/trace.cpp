@@ -0,0 +1,37 @@
+#include "trace.h"
+
+#if ENABLE_TRACE
+
+TraceEvent traceRing[TRACE_RING_SIZE];
+uint32_t traceHead = 0;  // Events ever recorded; the ring slot is head & (size - 1)
+bool tracePaused = false;
+
+void tracePause(bool paused) {
+  tracePaused = paused;
+}
+
+uint32_t traceSnapshot(uint32_t& first) {
+  uint32_t count = traceHead < TRACE_RING_SIZE ? traceHead : TRACE_RING_SIZE;
+  first = traceHead - count;
+  return count;
+}
+
+const TraceEvent& traceEventAt(uint32_t pos) {
+  return traceRing[pos & (TRACE_RING_SIZE - 1)];
+}
+
+#else
+
+void tracePause(bool) {}
+
+uint32_t traceSnapshot(uint32_t& first) {
+  first = 0;
+  return 0;
+}
+
+const TraceEvent& traceEventAt(uint32_t) {
+  static const TraceEvent none = {0, 0, 0, 0};
+  return none;
+}
+
+#endif
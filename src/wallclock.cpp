@@ -0,0 +1,54 @@
+#include "wallclock.h"
+#include "config.h"
+
+#include <Arduino.h>
+#include <sys/time.h>
+#include <time.h>
+
+// Anything before this means the system time was never set
+const uint32_t clockEpochMin = 1700000000;  // 2023-11-14
+
+static bool zoneSet = false;
+
+bool clockValid() {
+  return (uint32_t)time(nullptr) >= clockEpochMin;
+}
+
+uint32_t clockNow() {
+  uint32_t now = time(nullptr);
+  return now >= clockEpochMin ? now : 0;
+}
+
+void clockSet(uint32_t unixTime) {
+  struct timeval tv = {(time_t)unixTime, 0};
+  settimeofday(&tv, nullptr);
+}
+
+uint32_t clockFromUptime(uint32_t uptimeSec) {
+  uint32_t now = clockNow();
+  if (now == 0) return 0;
+  return now - (millis() / 1000 - uptimeSec);
+}
+
+void clockLocal(uint32_t unixTime, struct tm& tm) {
+  if (!zoneSet) {
+    setenv("TZ", TIME_ZONE, 1);
+    tzset();
+    zoneSet = true;
+  }
+  time_t t = unixTime;
+  localtime_r(&t, &tm);
+}
+
+uint32_t clockLocalDay(uint32_t unixTime) {
+  struct tm tm;
+  clockLocal(unixTime, tm);
+  // Days from civil date (proleptic Gregorian, March-based years)
+  int y = tm.tm_year + 1900 - (tm.tm_mon < 2);
+  int era = y / 400;
+  int yoe = y - era * 400;
+  int m = tm.tm_mon + 1;
+  int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + tm.tm_mday - 1;
+  int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
@@ -0,0 +1,84 @@
+#include "week_heatmap.h"
+
+#include <LittleFS.h>
+#include "crc32.h"
+#include "wallclock.h"
+
+static const char* heatmapPath = "/heatmap.bin";
+const uint32_t heatmapMagic = 0x31504D48;  // "HMP1"
+
+struct Cell {
+  float sum;
+  uint16_t count;
+};
+
+static Cell cells[METRIC_COUNT][heatmapDays][heatmapHours];
+static int lastCell = -1;  // day * 24 + hour of the previous sample
+
+static bool save() {
+  File f = LittleFS.open(heatmapPath, "w");
+  if (!f) return false;
+  uint32_t crc = crc32(cells, sizeof(cells));
+  bool ok = f.write((const uint8_t*)&heatmapMagic, 4) == 4 &&
+            f.write((const uint8_t*)cells, sizeof(cells)) == sizeof(cells) &&
+            f.write((const uint8_t*)&crc, 4) == 4;
+  f.close();
+  return ok;
+}
+
+bool heatmapBegin() {
+  memset(cells, 0, sizeof(cells));
+  File f = LittleFS.open(heatmapPath, "r");
+  if (!f) return false;
+  uint32_t magic = 0, crc = 0;
+  bool ok = f.read((uint8_t*)&magic, 4) == 4 && magic == heatmapMagic &&
+            f.read((uint8_t*)cells, sizeof(cells)) == sizeof(cells) &&
+            f.read((uint8_t*)&crc, 4) == 4 && crc == crc32(cells, sizeof(cells));
+  f.close();
+  if (!ok) memset(cells, 0, sizeof(cells));
+  return ok;
+}
+
+void heatmapAdd(uint32_t unixTime, float temp, float humidity, float pressure) {
+  if (unixTime == 0) return;
+  struct tm tm;
+  clockLocal(unixTime, tm);
+  int day = (tm.tm_wday + 6) % 7;  // Monday first
+  int hour = tm.tm_hour;
+
+  const float values[METRIC_COUNT] = {temp, humidity, pressure};
+  for (int m = 0; m < METRIC_COUNT; m++) {
+    Cell& c = cells[m][day][hour];
+    if (c.count >= heatmapCellMax) {
+      c.sum *= 0.5f;
+      c.count /= 2;
+    }
+    c.sum += values[m];
+    c.count++;
+  }
+
+  int cell = day * heatmapHours + hour;
+  if (lastCell >= 0 && cell != lastCell) save();
+  lastCell = cell;
+}
+
+bool heatmapCell(Metric metric, int day, int hour, float& mean) {
+  const Cell& c = cells[metric][day][hour];
+  if (c.count == 0) return false;
+  mean = c.sum / c.count;
+  return true;
+}
+
+bool heatmapRange(Metric metric, float& lo, float& hi) {
+  bool any = false;
+  for (int d = 0; d < heatmapDays; d++) {
+    for (int h = 0; h < heatmapHours; h++) {
+      float mean;
+      if (!heatmapCell(metric, d, h, mean)) continue;
+      if (!any || mean < lo) lo = mean;
+      if (!any || mean > hi) hi = mean;
+      any = true;
+    }
+  }
+  return any;
+}
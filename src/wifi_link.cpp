@@ -0,0 +1,66 @@
+#include "wifi_link.h"
+
+#include <WiFi.h>
+#include "config.h"
+#include "log_sink.h"
+
+static int holders = 0;
+static WifiLinkState state = WIFI_LINK_OFF;
+static unsigned long connectStart = 0;
+static bool ntpStarted = false;
+
+static void powerDown() {
+  WiFi.disconnect(true);
+  WiFi.mode(WIFI_OFF);
+}
+
+void wifiAcquire() {
+  if (holders++ > 0) return;
+  if (strlen(WIFI_SSID) == 0) {
+    state = WIFI_LINK_FAILED;
+    return;
+  }
+  WiFi.mode(WIFI_STA);
+  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+  connectStart = millis();
+  state = WIFI_LINK_CONNECTING;
+}
+
+void wifiRelease() {
+  if (holders == 0) return;
+  if (--holders > 0) return;
+  if (state != WIFI_LINK_OFF) powerDown();
+  state = WIFI_LINK_OFF;
+}
+
+void wifiPoll() {
+  switch (state) {
+    case WIFI_LINK_CONNECTING:
+      if (WiFi.status() == WL_CONNECTED) {
+        state = WIFI_LINK_UP;
+        logPrintf("WiFi up after %lu ms\n", millis() - connectStart);
+        if (!ntpStarted) {
+          configTzTime(TIME_ZONE, NTP_SERVER);
+          ntpStarted = true;
+        }
+      } else if (millis() - connectStart >= WIFI_CONNECT_TIMEOUT_MS) {
+        logPrintln("WiFi connect timed out");
+        powerDown();
+        state = WIFI_LINK_FAILED;
+      }
+      break;
+    case WIFI_LINK_UP:
+      if (WiFi.status() != WL_CONNECTED) {
+        // Dropped: let the driver reconnect within the usual timeout
+        connectStart = millis();
+        state = WIFI_LINK_CONNECTING;
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+WifiLinkState wifiState() {
+  return state;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+/*
+ * Host stand-in for the parts of the Arduino core that the hardware
+ * independent modules use, for the native test and render-host environments.
+ * Time only moves when a test moves it (hostMillis, or delay()).
+ */
+
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t byte;
+
+inline unsigned long hostMillis = 0;
+
+inline unsigned long millis() { return hostMillis; }
+inline unsigned long micros() { return hostMillis * 1000; }
+inline void delay(unsigned long ms) { hostMillis += ms; }
+inline void yield() {}
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t b) = 0;
+  virtual size_t write(const uint8_t* buf, size_t len) {
+    size_t n = 0;
+    while (len--) n += write(*buf++);
+    return n;
+  }
+  size_t write(const char* text) { return write((const uint8_t*)text, strlen(text)); }
+  virtual int availableForWrite() { return 0; }
+  size_t print(const char* text) { return write(text); }
+  size_t println(const char* text = "") { return print(text) + print("\r\n"); }
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+    char buf[256];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    return write((const uint8_t*)buf, n < (int)sizeof(buf) ? n : sizeof(buf) - 1);
+  }
+  virtual void flush() {}
+};
+
+class Stream : public Print {
+ public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+};
+
+// The USB serial port, written to stdout (the render probe's output)
+class HostSerial : public Stream {
+ public:
+  void begin(unsigned long baud) {}
+  size_t write(uint8_t b) override { return write(&b, 1); }
+  size_t write(const uint8_t* buf, size_t len) override { return fwrite(buf, 1, len, stdout); }
+  using Print::write;
+  int availableForWrite() override { return 4096; }
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  void flush() override { fflush(stdout); }
+};
+
+inline HostSerial Serial;
+
+class EspClass {
+ public:
+  uint32_t getFreeHeap() { return 200000; }
+  uint32_t getCpuFreqMHz() { return 240; }
+};
+
+inline EspClass ESP;
@@ -0,0 +1,134 @@
+#pragma once
+
+/*
+ * Host stand-in for the Arduino fs::FS / File API, backed by memory. Each
+ * file is a shared byte vector, so a test can truncate or corrupt a file
+ * between calls (HostFS::bytes) to play out a power loss, or cut writes
+ * short with hostWriteBudget. hostBytesRead counts every byte read.
+ */
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+
+// Bytes that may still be written before writes fail (a power cut in the
+// middle of a write); negative for no limit
+inline long hostWriteBudget = -1;
+inline unsigned long hostBytesRead = 0;
+
+namespace fs {
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+class File : public Stream {
+ public:
+  File() {}
+  File(std::shared_ptr<std::vector<uint8_t>> data, bool writable, bool append)
+      : _data(data), _writable(writable), _append(append) {}
+
+  size_t write(uint8_t b) override { return write(&b, 1); }
+  size_t write(const uint8_t* buf, size_t len) override {
+    if (!_data || !_writable) return 0;
+    if (hostWriteBudget >= 0) {
+      if ((long)len > hostWriteBudget) len = hostWriteBudget;
+      hostWriteBudget -= len;
+    }
+    if (_append) _pos = _data->size();
+    if (_data->size() < _pos + len) _data->resize(_pos + len);
+    memcpy(_data->data() + _pos, buf, len);
+    _pos += len;
+    return len;
+  }
+  using Print::write;
+
+  int available() override { return _data && _pos < _data->size() ? _data->size() - _pos : 0; }
+  int read() override {
+    uint8_t b;
+    return read(&b, 1) == 1 ? b : -1;
+  }
+  int peek() override { return available() ? (*_data)[_pos] : -1; }
+  size_t read(uint8_t* buf, size_t len) {
+    size_t n = available();
+    if (n > len) n = len;
+    if (n) memcpy(buf, _data->data() + _pos, n);
+    _pos += n;
+    hostBytesRead += n;
+    return n;
+  }
+
+  // Like the VFS, seeking past the end is allowed; a write there zero-fills
+  bool seek(uint32_t pos, SeekMode mode = SeekSet) {
+    if (!_data) return false;
+    if (mode == SeekCur) pos += _pos;
+    if (mode == SeekEnd) pos += _data->size();
+    _pos = pos;
+    return true;
+  }
+  size_t position() const { return _pos; }
+  size_t size() const { return _data ? _data->size() : 0; }
+  void flush() override {}
+  void close() { _data.reset(); }
+  operator bool() const { return (bool)_data; }
+  // Directories are not modelled: listing one finds nothing
+  const char* name() const { return ""; }
+  File openNextFile() { return File(); }
+
+ private:
+  std::shared_ptr<std::vector<uint8_t>> _data;
+  bool _writable = false;
+  bool _append = false;
+  size_t _pos = 0;
+};
+
+class FS {
+ public:
+  // Modes "r", "r+", "w", "w+", "a", "a+" as in fopen()
+  File open(const char* path, const char* mode = "r") {
+    auto it = _files.find(path);
+    bool plus = mode[1] == '+';
+    if (mode[0] == 'r') {
+      if (it == _files.end()) return File();
+      return File(it->second, plus, false);
+    }
+    if (it == _files.end() || mode[0] == 'w') {
+      _files[path] = std::make_shared<std::vector<uint8_t>>();
+    }
+    return File(_files[path], true, mode[0] == 'a');
+  }
+  bool exists(const char* path) { return _files.count(path) > 0; }
+  bool remove(const char* path) { return _files.erase(path) > 0; }
+  bool rename(const char* from, const char* to) {
+    auto it = _files.find(from);
+    if (it == _files.end()) return false;
+    _files[to] = it->second;
+    _files.erase(from);
+    return true;
+  }
+  bool mkdir(const char*) { return true; }
+  bool rmdir(const char*) { return true; }
+
+ protected:
+  std::map<std::string, std::shared_ptr<std::vector<uint8_t>>> _files;
+};
+
+}  // namespace fs
+
+using fs::File;
+using fs::FS;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
+
+// FS with direct access to the stored bytes, for tests
+class HostFS : public fs::FS {
+ public:
+  std::vector<uint8_t>& bytes(const char* path) {
+    auto& data = _files[path];
+    if (!data) data = std::make_shared<std::vector<uint8_t>>();
+    return *data;
+  }
+  void clear() { _files.clear(); }
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+/*
+ * Host stand-in for the ESP32 HTTPClient. Every POST is recorded in
+ * hostHttpRequests and answered with hostHttpStatus.
+ */
+
+#include <string>
+#include <vector>
+#include "Arduino.h"
+
+struct HostHttpRequest {
+  std::string url;
+  std::vector<std::string> headers;  // "Name: value"
+  std::string body;
+  uint16_t timeoutMs;
+  int32_t connectTimeoutMs;
+};
+
+inline std::vector<HostHttpRequest> hostHttpRequests;
+inline int hostHttpStatus = 204;
+
+class HTTPClient {
+ public:
+  bool begin(const char* url) {
+    _request = HostHttpRequest();
+    _request.url = url;
+    _request.timeoutMs = 5000;
+    _request.connectTimeoutMs = 5000;
+    return url[0] != '\0';
+  }
+  void setTimeout(uint16_t ms) { _request.timeoutMs = ms; }
+  void setConnectTimeout(int32_t ms) { _request.connectTimeoutMs = ms; }
+  void addHeader(const char* name, const char* value) {
+    _request.headers.push_back(std::string(name) + ": " + value);
+  }
+  int POST(uint8_t* payload, size_t size) {
+    _request.body.assign((const char*)payload, size);
+    hostHttpRequests.push_back(_request);
+    return hostHttpStatus;
+  }
+  void end() {}
+
+ private:
+  HostHttpRequest _request;
+};
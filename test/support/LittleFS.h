@@ -0,0 +1,15 @@
+#pragma once
+
+/*
+ * Host stand-in for the LittleFS flash filesystem: an empty in-memory FS
+ * that always mounts.
+ */
+
+#include "FS.h"
+
+class LittleFSFS : public fs::FS {
+ public:
+  bool begin(bool formatOnFail = false) { return true; }
+};
+
+inline LittleFSFS LittleFS;
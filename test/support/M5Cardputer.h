@@ -0,0 +1,42 @@
+#pragma once
+
+/*
+ * Host stand-in for the Cardputer library, for the render-host environment.
+ * The display is an M5GFX canvas the size of the panel in landscape (the
+ * firmware's setRotation(1) and brightness are no-ops on it); no key is
+ * ever pressed.
+ */
+
+#include <vector>
+#include "M5Unified.hpp"
+
+class Keyboard_Class {
+ public:
+  struct KeysState {
+    std::vector<char> word;
+  };
+  bool isChange() { return false; }
+  bool isPressed() { return false; }
+  KeysState keysState() { return KeysState(); }
+};
+
+class HostDisplay : public M5Canvas {
+ public:
+  void setRotation(uint8_t) {}
+  void setBrightness(uint8_t) {}
+};
+
+class M5_CARDPUTER {
+ public:
+  void begin(m5::config_t, bool enableKeyboard = true) {
+    Display.setColorDepth(16);
+    Display.createSprite(240, 135);
+  }
+  void update() {}
+
+  HostDisplay Display;
+  m5::Power_Class& Power = M5.Power;
+  Keyboard_Class Keyboard;
+};
+
+inline M5_CARDPUTER M5Cardputer;
@@ -0,0 +1,29 @@
+#pragma once
+
+/*
+ * Host stand-in for M5Unified, for the render-host environment: the board
+ * configuration and a battery that always reads full. The display is the
+ * real M5GFX, built for the host.
+ */
+
+#include <M5GFX.h>
+
+namespace m5 {
+
+struct config_t {};
+
+class Power_Class {
+ public:
+  int32_t getBatteryLevel() { return 100; }
+  bool isCharging() { return false; }
+};
+
+class M5Unified {
+ public:
+  config_t config() { return config_t(); }
+  Power_Class Power;
+};
+
+}  // namespace m5
+
+inline m5::M5Unified M5;
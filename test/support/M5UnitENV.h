@@ -0,0 +1,45 @@
+#pragma once
+
+/*
+ * Host stand-in for the M5Unit-ENV QMP6988 driver with no sensor attached:
+ * begin() fails and there is never a new reading.
+ */
+
+#include "Wire.h"
+
+#define QMP6988_SLAVE_ADDRESS_L 0x70
+#define QMP6988_SLAVE_ADDRESS_H 0x56
+#define QMP6988_SLEEP_MODE 0x00
+#define QMP6988_FORCED_MODE 0x01
+#define QMP6988_NORMAL_MODE 0x03
+#define QMP6988_OVERSAMPLING_SKIPPED 0x00
+#define QMP6988_OVERSAMPLING_1X 0x01
+#define QMP6988_OVERSAMPLING_2X 0x02
+#define QMP6988_OVERSAMPLING_4X 0x03
+#define QMP6988_OVERSAMPLING_8X 0x04
+#define QMP6988_OVERSAMPLING_16X 0x05
+#define QMP6988_OVERSAMPLING_32X 0x06
+#define QMP6988_OVERSAMPLING_64X 0x07
+#define QMP6988_FILTERCOEFF_OFF 0x00
+#define QMP6988_FILTERCOEFF_2 0x01
+#define QMP6988_FILTERCOEFF_4 0x02
+#define QMP6988_FILTERCOEFF_8 0x03
+#define QMP6988_FILTERCOEFF_16 0x04
+#define QMP6988_FILTERCOEFF_32 0x05
+
+class QMP6988 {
+ public:
+  bool begin(TwoWire* = &Wire, uint8_t = QMP6988_SLAVE_ADDRESS_H, uint8_t = 21, uint8_t = 22,
+             uint32_t = 400000U) {
+    return false;
+  }
+  bool update() { return false; }
+  void setpPowermode(int) {}
+  void setFilter(unsigned char) {}
+  void setOversamplingP(unsigned char) {}
+  void setOversamplingT(unsigned char) {}
+
+  float temp = 0;
+  float pressure = 0;
+  float altitude = 0;
+};
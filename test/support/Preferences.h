@@ -0,0 +1,35 @@
+#pragma once
+
+/*
+ * Host stand-in for the ESP32 NVS Preferences, kept in memory. Every
+ * instance sees the same store, as on the device; namespaces are ignored.
+ */
+
+#include <map>
+#include <string>
+#include "Arduino.h"
+
+inline std::map<std::string, uint32_t> hostPreferences;
+
+class Preferences {
+ public:
+  bool begin(const char* name, bool readOnly = false) { return true; }
+  void end() {}
+  uint8_t getUChar(const char* key, uint8_t def = 0) { return get(key, def); }
+  size_t putUChar(const char* key, uint8_t v) { return put(key, v, 1); }
+  bool getBool(const char* key, bool def = false) { return get(key, def); }
+  size_t putBool(const char* key, bool v) { return put(key, v, 1); }
+  uint32_t getUInt(const char* key, uint32_t def = 0) { return get(key, def); }
+  size_t putUInt(const char* key, uint32_t v) { return put(key, v, 4); }
+  bool remove(const char* key) { return hostPreferences.erase(key) > 0; }
+
+ private:
+  uint32_t get(const char* key, uint32_t def) {
+    auto it = hostPreferences.find(key);
+    return it == hostPreferences.end() ? def : it->second;
+  }
+  size_t put(const char* key, uint32_t v, size_t bytes) {
+    hostPreferences[key] = v;
+    return bytes;
+  }
+};
@@ -0,0 +1,15 @@
+#pragma once
+
+/*
+ * Host stand-in for the SD library with no card in the slot: begin() fails.
+ */
+
+#include "FS.h"
+#include "SPI.h"
+
+class SDFS : public fs::FS {
+ public:
+  bool begin(uint8_t ssPin, SPIClass& spi, uint32_t frequency) { return false; }
+};
+
+inline SDFS SD;
@@ -0,0 +1,16 @@
+#pragma once
+
+/*
+ * Host stand-in for the ESP32 SPI bus, which only the SD card uses.
+ */
+
+#include "Arduino.h"
+
+#define FSPI 0
+#define HSPI 1
+
+class SPIClass {
+ public:
+  explicit SPIClass(uint8_t bus = FSPI) {}
+  void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1) {}
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+/*
+ * Host stand-in for the ESP32 WiFi station (which never connects), server
+ * and client. A test queues a connection on the server with the request
+ * bytes the peer sends and how much the socket accepts per write, then reads
+ * back what was sent.
+ */
+
+#include <deque>
+#include <memory>
+#include <string>
+#include "Arduino.h"
+
+struct HostConnection {
+  std::string received;   // Request bytes still to be read
+  std::string sent;       // Everything written back
+  int writeRoom = 1 << 20;  // Bytes accepted per write() call
+  bool stopped = false;
+};
+
+class WiFiClient : public Stream {
+ public:
+  WiFiClient() {}
+  explicit WiFiClient(std::shared_ptr<HostConnection> c) : _c(c) {}
+
+  size_t write(uint8_t b) override { return write(&b, 1); }
+  size_t write(const uint8_t* buf, size_t len) override {
+    if (!connected()) return 0;
+    if ((int)len > _c->writeRoom) len = _c->writeRoom;
+    _c->sent.append((const char*)buf, len);
+    return len;
+  }
+  using Print::write;
+  int available() override { return connected() ? _c->received.size() : 0; }
+  int read() override {
+    if (!available()) return -1;
+    uint8_t b = _c->received[0];
+    _c->received.erase(0, 1);
+    return b;
+  }
+  int peek() override { return available() ? (uint8_t)_c->received[0] : -1; }
+  bool connected() const { return _c && !_c->stopped; }
+  void stop() {
+    if (_c) _c->stopped = true;
+  }
+  operator bool() const { return connected(); }
+
+ private:
+  std::shared_ptr<HostConnection> _c;
+};
+
+class WiFiServer {
+ public:
+  explicit WiFiServer(uint16_t) {}
+  void begin() { started = true; }
+  WiFiClient available() {
+    if (pending.empty()) return WiFiClient();
+    WiFiClient c(pending.front());
+    pending.pop_front();
+    return c;
+  }
+  // Returns the connection so the test can inspect the response
+  std::shared_ptr<HostConnection> connect(const std::string& request) {
+    auto c = std::make_shared<HostConnection>();
+    c->received = request;
+    pending.push_back(c);
+    return c;
+  }
+
+  bool started = false;
+  std::deque<std::shared_ptr<HostConnection>> pending;
+};
+
+class IPAddress {
+ public:
+  std::string toString() const { return "192.0.2.1"; }
+};
+
+enum wifi_mode_t { WIFI_OFF, WIFI_STA };
+enum wl_status_t { WL_IDLE_STATUS = 0, WL_CONNECTED = 3, WL_DISCONNECTED = 6 };
+
+// The station never associates
+class WiFiClass {
+ public:
+  IPAddress localIP() const { return IPAddress(); }
+  bool mode(wifi_mode_t) { return true; }
+  wl_status_t begin(const char* ssid, const char* password) { return WL_DISCONNECTED; }
+  bool disconnect(bool wifiOff = false) { return true; }
+  wl_status_t status() { return WL_DISCONNECTED; }
+};
+
+inline void configTzTime(const char* tz, const char* server) {}
+
+inline WiFiClass WiFi;
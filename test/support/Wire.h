@@ -0,0 +1,23 @@
+#pragma once
+
+/*
+ * Host stand-in for TwoWire with nothing on the bus: every transfer fails
+ * with a NACK. Tests drive sensor drivers through their bus interfaces.
+ */
+
+#include "Arduino.h"
+
+class TwoWire : public Stream {
+ public:
+  bool begin(int sda = -1, int scl = -1) { return true; }
+  void beginTransmission(uint8_t) {}
+  uint8_t endTransmission(bool = true) { return 2; }  // Address NACK
+  uint8_t requestFrom(uint8_t, uint8_t) { return 0; }
+  size_t write(uint8_t) override { return 1; }
+  using Print::write;
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+};
+
+inline TwoWire Wire;
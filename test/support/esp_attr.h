@@ -0,0 +1,5 @@
+#pragma once
+
+// Host stand-in: no RTC or IRAM sections on the host
+#define RTC_NOINIT_ATTR
+#define IRAM_ATTR
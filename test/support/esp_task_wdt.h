@@ -0,0 +1,10 @@
+#pragma once
+
+// Host stand-in for the ESP-IDF task watchdog: nothing to feed
+#include "freertos/FreeRTOS.h"
+
+typedef int esp_err_t;
+
+inline esp_err_t esp_task_wdt_init(uint32_t timeoutS, bool panic) { return 0; }
+inline esp_err_t esp_task_wdt_add(TaskHandle_t task) { return 0; }
+inline esp_err_t esp_task_wdt_reset() { return 0; }
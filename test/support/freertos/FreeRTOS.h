@@ -0,0 +1,24 @@
+#pragma once
+
+/*
+ * Host stand-in for the FreeRTOS types and critical sections the firmware
+ * uses. The host builds are single threaded, so a critical section is a
+ * no-op.
+ */
+
+#include <stdint.h>
+
+typedef void* TaskHandle_t;
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define pdPASS 1
+
+typedef struct {
+  int owner;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
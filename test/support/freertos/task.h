@@ -0,0 +1,13 @@
+#pragma once
+
+// Host stand-in for FreeRTOS tasks: creating one fails, as nothing would run it
+#include "FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void*);
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stack,
+                                          void* arg, UBaseType_t priority, TaskHandle_t* task,
+                                          BaseType_t core) {
+  return 0;
+}
+inline void vTaskDelay(TickType_t ticks) {}
@@ -0,0 +1,288 @@
+#include <unity.h>
+
+#include <math.h>
+#include <utility>
+#include <vector>
+#include "FS.h"
+#include "col_log.h"
+
+static HostFS card;
+static const char* path = "/envlog/20250615.ecl";
+static const uint32_t day = 1749945600;  // 2025-06-15 00:00 UTC
+
+typedef std::vector<std::pair<uint32_t, float>> Samples;
+
+static bool collect(uint32_t time, float value, void* ctx) {
+  ((Samples*)ctx)->push_back({time, value});
+  return true;
+}
+
+// A day of bins as the SD logger writes them: temperature and humidity
+// every 30 s, pressure every 5 min, appended in time order
+static void writeDay(ColLogWriter& w, uint32_t from, uint32_t to) {
+  for (uint32_t t = from; t < to; t += 30) {
+    uint32_t i = (t - day) / 30;
+    TEST_ASSERT_TRUE(w.append(0, t, 20.0f + (i % 200) * 0.01f));
+    TEST_ASSERT_TRUE(w.append(1, t, 40.0f + (i % 50)));
+    if (i % 10 == 0) TEST_ASSERT_TRUE(w.append(2, t, 1000.0f + i / 10));
+  }
+}
+
+static Samples query(ColLogReader& r, uint8_t series, uint32_t t0, uint32_t t1) {
+  Samples out;
+  TEST_ASSERT_EQUAL_INT(r.query(series, t0, t1, collect, &out), (int)out.size());
+  return out;
+}
+
+void setUp() {
+  card.clear();
+}
+
+void tearDown() {}
+
+void test_round_trip_per_series() {
+  ColLogWriter w;
+  TEST_ASSERT_TRUE(w.open(card, path));
+  writeDay(w, day, day + 86400);
+  TEST_ASSERT_TRUE(w.close());
+
+  ColLogReader r;
+  TEST_ASSERT_TRUE(r.open(card, path));
+  Samples temp = query(r, 0, day, day + 86400);
+  TEST_ASSERT_EQUAL(2880, temp.size());
+  for (uint32_t i = 0; i < temp.size(); i++) {
+    TEST_ASSERT_EQUAL_UINT32(day + i * 30, temp[i].first);
+    TEST_ASSERT_EQUAL_FLOAT(20.0f + (i % 200) * 0.01f, temp[i].second);
+  }
+  Samples pressure = query(r, 2, day, day + 86400);
+  TEST_ASSERT_EQUAL(288, pressure.size());
+  TEST_ASSERT_EQUAL_FLOAT(1287.0f, pressure.back().second);
+  TEST_ASSERT_EQUAL(0, query(r, 3, day, day + 86400).size());
+}
+
+void test_window_reads_only_the_blocks_it_needs() {
+  ColLogWriter w;
+  TEST_ASSERT_TRUE(w.open(card, path));
+  writeDay(w, day, day + 86400);
+  TEST_ASSERT_TRUE(w.close());
+
+  ColLogReader r;
+  TEST_ASSERT_TRUE(r.open(card, path));
+  // One hour of temperature: 120 samples, within 3 blocks of 64
+  Samples hour = query(r, 0, day + 36000, day + 36000 + 3599);
+  TEST_ASSERT_EQUAL(120, hour.size());
+  TEST_ASSERT_EQUAL_UINT32(day + 36000, hour.front().first);
+  TEST_ASSERT_EQUAL_UINT32(day + 36000 + 3570, hour.back().first);
+  TEST_ASSERT_TRUE(r.stats().blocksRead <= 3);
+}
+
+void test_range_answers_inner_blocks_from_zone_maps() {
+  ColLogWriter w;
+  TEST_ASSERT_TRUE(w.open(card, path));
+  writeDay(w, day, day + 86400);
+  TEST_ASSERT_TRUE(w.close());
+
+  ColLogReader r;
+  TEST_ASSERT_TRUE(r.open(card, path));
+  uint32_t t0 = day + 7 * 3600 + 15;  // Not on a block boundary
+  uint32_t t1 = day + 17 * 3600;
+  float lo, hi;
+  TEST_ASSERT_TRUE(r.range(1, t0, t1, lo, hi));
+  // Checked against the samples themselves
+  Samples all = query(r, 1, t0, t1);
+  float expectLo = all[0].second, expectHi = all[0].second;
+  for (auto& s : all) {
+    if (s.second < expectLo) expectLo = s.second;
+    if (s.second > expectHi) expectHi = s.second;
+  }
+  TEST_ASSERT_EQUAL_FLOAT(expectLo, lo);
+  TEST_ASSERT_EQUAL_FLOAT(expectHi, hi);
+
+  ColLogReader fresh;
+  TEST_ASSERT_TRUE(fresh.open(card, path));
+  TEST_ASSERT_TRUE(fresh.range(1, t0, t1, lo, hi));
+  // 1200 samples: the ~18 whole blocks come from their zone maps; only the
+  // two partly covered edge blocks are read
+  TEST_ASSERT_TRUE(fresh.stats().blocksSkipped >= 17);
+  TEST_ASSERT_TRUE(fresh.stats().blocksRead <= 2);
+  TEST_ASSERT_FALSE(fresh.range(1, day + 86400, day + 90000, lo, hi));
+}
+
+void test_footer_and_scan_give_the_same_zones() {
+  ColLogWriter w;
+  TEST_ASSERT_TRUE(w.open(card, path));
+  writeDay(w, day, day + 6 * 3600);
+  TEST_ASSERT_TRUE(w.close());
+
+  static ColLogZone fromFooter[colLogZoneMax];
+  static ColLogZone fromScan[colLogZoneMax];
+  File f = card.open(path, "r");
+  int n = colLogLoadZones(f, fromFooter, colLogZoneMax);
+  f.close();
+  // 720 + 720 + 72 samples in blocks of 64 (the last of each partial)
+  TEST_ASSERT_EQUAL_INT(12 + 12 + 2, n);
+
+  // Without the footer the same zones come from the block headers
+  std::vector<uint8_t>& bytes = card.bytes(path);
+  bytes.resize(bytes.size() - 8);
+  f = card.open(path, "r");
+  TEST_ASSERT_EQUAL_INT(n, colLogLoadZones(f, fromScan, colLogZoneMax));
+  f.close();
+  TEST_ASSERT_EQUAL_MEMORY(fromFooter, fromScan, n * sizeof(ColLogZone));
+
+  for (int i = 0; i < n; i++) {
+    TEST_ASSERT_TRUE(fromFooter[i].tMin <= fromFooter[i].tMax);
+    TEST_ASSERT_TRUE(fromFooter[i].vMin <= fromFooter[i].vMax);
+    TEST_ASSERT_TRUE(fromFooter[i].count >= 1 && fromFooter[i].count <= colLogBlockCapacity);
+  }
+}
+
+void test_reopened_file_continues_after_its_footer() {
+  ColLogWriter w;
+  TEST_ASSERT_TRUE(w.open(card, path));
+  writeDay(w, day, day + 3600);
+  TEST_ASSERT_TRUE(w.close());
+  TEST_ASSERT_TRUE(w.open(card, path));
+  writeDay(w, day + 3600, day + 7200);
+  TEST_ASSERT_TRUE(w.flush());  // Still open: no new footer yet
+
+  ColLogReader r;
+  TEST_ASSERT_TRUE(r.open(card, path));
+  Samples temp = query(r, 0, day, day + 7200);
+  TEST_ASSERT_EQUAL(240, temp.size());
+  for (uint32_t i = 0; i < temp.size(); i++) TEST_ASSERT_EQUAL_UINT32(day + i * 30, temp[i].first);
+  r.close();
+  TEST_ASSERT_TRUE(w.close());
+}
+
+void test_query_stops_when_the_callback_declines() {
+  ColLogWriter w;
+  TEST_ASSERT_TRUE(w.open(card, path));
+  writeDay(w, day, day + 7200);
+  TEST_ASSERT_TRUE(w.close());
+
+  ColLogReader r;
+  TEST_ASSERT_TRUE(r.open(card, path));
+  struct Limit {
+    int left;
+    uint32_t last;
+  } limit = {10, 0};
+  int n = r.query(0, day, day + 7200, [](uint32_t t, float, void* ctx) {
+    Limit& l = *(Limit*)ctx;
+    if (l.left == 0) return false;
+    l.left--;
+    l.last = t;
+    return true;
+  }, &limit);
+  TEST_ASSERT_EQUAL_INT(10, n);
+  TEST_ASSERT_EQUAL_UINT32(day + 9 * 30, limit.last);
+}
+
+void test_card_and_buffered_samples_join_without_a_flush() {
+  ColLogWriter w;
+  TEST_ASSERT_TRUE(w.open(card, path));
+  writeDay(w, day, day + 3600);  // 120 bins: one block on the card, 56 in RAM
+  uint32_t blocks = w.blocksWritten();
+
+  ColLogReader r;
+  TEST_ASSERT_TRUE(r.open(card, path));
+  Samples temp = query(r, 0, day, day + 3600);
+  r.close();
+  TEST_ASSERT_EQUAL(colLogBlockCapacity, temp.size());
+  TEST_ASSERT_EQUAL_INT(120 - colLogBlockCapacity, w.queryPending(0, day, day + 3600, collect, &temp));
+  TEST_ASSERT_EQUAL(120, temp.size());
+  for (uint32_t i = 0; i < temp.size(); i++) TEST_ASSERT_EQUAL_UINT32(day + i * 30, temp[i].first);
+  // Nothing was written to answer it
+  TEST_ASSERT_EQUAL_UINT32(blocks, w.blocksWritten());
+
+  Samples window;
+  TEST_ASSERT_EQUAL_INT(2, w.queryPending(0, day + 3000, day + 3030, collect, &window));
+  TEST_ASSERT_EQUAL_UINT32(day + 3000, window[0].first);
+  TEST_ASSERT_TRUE(w.close());
+}
+
+void test_foreign_file_is_left_alone() {
+  File f = card.open(path, "w");
+  f.print("time,temp\n");
+  f.close();
+  ColLogWriter w;
+  TEST_ASSERT_FALSE(w.open(card, path));
+  TEST_ASSERT_EQUAL(10, card.bytes(path).size());
+}
+
+// Temperature only, one block per 64 bins, for index tests
+static void writeBlocks(const char* logPath, int blocks) {
+  ColLogWriter w;
+  TEST_ASSERT_TRUE(w.open(card, logPath));
+  for (uint32_t i = 0; i < (uint32_t)blocks * colLogBlockCapacity; i++) {
+    TEST_ASSERT_TRUE(w.append(0, day + i * 30, 20.0f));
+  }
+  TEST_ASSERT_TRUE(w.close());
+}
+
+void test_seek_cost_stays_flat_as_the_log_grows() {
+  // Up to the largest file a writer fills before it asks to rotate
+  const int sizes[] = {8, 64, colLogZoneMax - colLogSeriesMax};
+  uint32_t worst[3] = {0, 0, 0};
+  unsigned long bytes[3] = {0, 0, 0};
+  for (int s = 0; s < 3; s++) {
+    char logPath[32];
+    snprintf(logPath, sizeof(logPath), "/envlog/size%d.ecl", sizes[s]);
+    writeBlocks(logPath, sizes[s]);
+    ColLogReader r;
+    TEST_ASSERT_TRUE(r.open(card, logPath));
+    uint32_t samples = sizes[s] * colLogBlockCapacity;
+    for (int k = 0; k < 50; k++) {
+      uint32_t t = day + samples * k / 50 * 30;
+      uint32_t before = r.stats().indexReads;
+      unsigned long read = hostBytesRead;
+      Samples one = query(r, 0, t, t);
+      TEST_ASSERT_EQUAL(1, one.size());
+      uint32_t reads = r.stats().indexReads - before;
+      if (reads > worst[s]) worst[s] = reads;
+      bytes[s] += hostBytesRead - read;
+    }
+    printf("  %3d blocks: at most %lu index reads per seek, %lu bytes per lookup\n", sizes[s],
+           (unsigned long)worst[s], bytes[s] / 50);
+  }
+  // Binary search: about log2(blocks) entries, plus the one block scanned
+  for (int s = 0; s < 3; s++) {
+    TEST_ASSERT_TRUE(worst[s] <= (uint32_t)(log2(sizes[s]) + 3));
+  }
+  // About 64 times the blocks costs a handful more entry reads, not 64 times the bytes
+  TEST_ASSERT_TRUE(bytes[2] < bytes[0] * 2);
+}
+
+void test_damaged_index_count_is_skipped() {
+  writeBlocks(path, 8);
+  // Entry 3 claims far more samples than a block holds; the last entry is
+  // intact, so opening keeps the index as it is
+  char idxPath[48];
+  colLogIndexPath(idxPath, sizeof(idxPath), path);
+  std::vector<uint8_t>& idx = card.bytes(idxPath);
+  const size_t entrySize = sizeof(ColLogIndexEntry);
+  idx[4 + 3 * entrySize + 13] = 0xFF;
+  idx[4 + 3 * entrySize + 14] = 0xFF;
+
+  ColLogReader r;
+  TEST_ASSERT_TRUE(r.open(card, path));
+  Samples all = query(r, 0, day, day + 86400);
+  TEST_ASSERT_EQUAL(7 * colLogBlockCapacity, all.size());
+  float lo, hi;
+  TEST_ASSERT_TRUE(r.range(0, day, day + 86400, lo, hi));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_round_trip_per_series);
+  RUN_TEST(test_window_reads_only_the_blocks_it_needs);
+  RUN_TEST(test_range_answers_inner_blocks_from_zone_maps);
+  RUN_TEST(test_footer_and_scan_give_the_same_zones);
+  RUN_TEST(test_reopened_file_continues_after_its_footer);
+  RUN_TEST(test_query_stops_when_the_callback_declines);
+  RUN_TEST(test_card_and_buffered_samples_join_without_a_flush);
+  RUN_TEST(test_foreign_file_is_left_alone);
+  RUN_TEST(test_seek_cost_stays_flat_as_the_log_grows);
+  RUN_TEST(test_damaged_index_count_is_skipped);
+  return UNITY_END();
+}
@@ -0,0 +1,179 @@
+#include <unity.h>
+
+#include <chrono>
+#include <stdio.h>
+#include "FS.h"
+#include "col_log.h"
+
+/*
+ * Columnar log against a CSV log of the same day, on the in-memory FS.
+ * Prints file size, bytes read and host time per query; bytes read is what
+ * costs time on the card. The CSV reader scans from the start of the file
+ * and stops once it is past the window, which is the best a plain CSV can
+ * do without an index.
+ */
+
+static HostFS card;
+static const char* eclPath = "/envlog/20250615.ecl";
+static const char* idxPath = "/envlog/20250615.idx";
+static const char* csvPath = "/envlog/20250615.csv";
+static const uint32_t day = 1749945600;  // 2025-06-15 00:00 UTC
+
+struct Cost {
+  unsigned long bytes;
+  double us;
+};
+
+static float valueOf(uint8_t series, uint32_t i) {
+  if (series == 0) return 20.0f + (i % 200) * 0.01f;
+  if (series == 1) return 40.0f + (i % 50);
+  return 1000.0f + i / 10;
+}
+
+static void writeBoth() {
+  ColLogWriter w;
+  TEST_ASSERT_TRUE(w.open(card, eclPath));
+  File csv = card.open(csvPath, "w");
+  csv.print("time,series,value\n");
+  for (uint32_t t = day; t < day + 86400; t += 30) {
+    uint32_t i = (t - day) / 30;
+    for (uint8_t s = 0; s < 3; s++) {
+      if (s == 2 && i % 10 != 0) continue;
+      TEST_ASSERT_TRUE(w.append(s, t, valueOf(s, i)));
+      csv.printf("%lu,%u,%.2f\n", (unsigned long)t, s, valueOf(s, i));
+    }
+  }
+  TEST_ASSERT_TRUE(w.close());
+  csv.close();
+}
+
+// Calls fn for each CSV row of the series in [t0, t1]; returns the count
+template <typename Fn>
+static int csvScan(uint8_t series, uint32_t t0, uint32_t t1, Fn fn) {
+  File f = card.open(csvPath, "r");
+  char line[48];
+  int len = 0;
+  int n = 0;
+  bool header = true;
+  uint8_t buf[512];
+  size_t got;
+  while ((got = f.read(buf, sizeof(buf))) > 0) {
+    for (size_t i = 0; i < got; i++) {
+      if (buf[i] != '\n') {
+        if (len < (int)sizeof(line) - 1) line[len++] = buf[i];
+        continue;
+      }
+      line[len] = '\0';
+      len = 0;
+      if (header) {
+        header = false;
+        continue;
+      }
+      unsigned long t;
+      unsigned s;
+      float v;
+      if (sscanf(line, "%lu,%u,%f", &t, &s, &v) != 3) continue;
+      if (t > t1) {
+        f.close();
+        return n;
+      }
+      if (s == series && t >= t0) {
+        fn(t, v);
+        n++;
+      }
+    }
+  }
+  f.close();
+  return n;
+}
+
+template <typename Fn>
+static Cost measure(Fn fn) {
+  const int reps = 20;
+  unsigned long before = hostBytesRead;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < reps; i++) fn();
+  auto end = std::chrono::steady_clock::now();
+  return {(hostBytesRead - before) / reps,
+          std::chrono::duration<double, std::micro>(end - start).count() / reps};
+}
+
+static bool countSample(uint32_t, float, void* ctx) {
+  (*(int*)ctx)++;
+  return true;
+}
+
+static void report(const char* what, int samples, Cost ecl, Cost csv) {
+  printf("  %-22s %5d samples  ecl %7lu B %8.1f us   csv %7lu B %8.1f us\n", what, samples,
+         ecl.bytes, ecl.us, csv.bytes, csv.us);
+}
+
+void setUp() {
+  card.clear();
+}
+
+void tearDown() {}
+
+void test_columnar_log_against_csv() {
+  writeBoth();
+  size_t eclBytes = card.bytes(eclPath).size() + card.bytes(idxPath).size();
+  size_t csvBytes = card.bytes(csvPath).size();
+  printf("\n  file size: ecl + idx %lu B, csv %lu B\n", (unsigned long)eclBytes, (unsigned long)csvBytes);
+  TEST_ASSERT_TRUE(eclBytes < csvBytes);
+
+  struct Window {
+    const char* name;
+    uint8_t series;
+    uint32_t t0;
+    uint32_t t1;
+  } windows[] = {
+      {"temp, 1 h at 18:00", 0, day + 18 * 3600, day + 19 * 3600 - 1},
+      {"humidity, 10 min", 1, day + 12 * 3600, day + 12 * 3600 + 599},
+      {"pressure, whole day", 2, day, day + 86399},
+  };
+  for (const Window& w : windows) {
+    int eclCount = 0;
+    int csvCount = 0;
+    ColLogReader reader;
+    Cost ecl = measure([&] {
+      eclCount = 0;
+      TEST_ASSERT_TRUE(reader.open(card, eclPath));
+      reader.query(w.series, w.t0, w.t1, countSample, &eclCount);
+      reader.close();
+    });
+    Cost csv = measure([&] { csvCount = csvScan(w.series, w.t0, w.t1, [](uint32_t, float) {}); });
+    TEST_ASSERT_EQUAL_INT(csvCount, eclCount);
+    report(w.name, eclCount, ecl, csv);
+    TEST_ASSERT_TRUE(ecl.bytes < csv.bytes);
+  }
+
+  // Min/max over 10 h: whole blocks are answered from their zone maps
+  uint32_t t0 = day + 6 * 3600 + 15;
+  uint32_t t1 = day + 16 * 3600;
+  float lo = 0, hi = 0, csvLo = 0, csvHi = 0;
+  ColLogReader reader;
+  Cost ecl = measure([&] {
+    TEST_ASSERT_TRUE(reader.open(card, eclPath));
+    TEST_ASSERT_TRUE(reader.range(0, t0, t1, lo, hi));
+    reader.close();
+  });
+  int n = 0;
+  Cost csv = measure([&] {
+    bool any = false;
+    n = csvScan(0, t0, t1, [&](uint32_t, float v) {
+      if (!any || v < csvLo) csvLo = v;
+      if (!any || v > csvHi) csvHi = v;
+      any = true;
+    });
+  });
+  report("temp min/max, 10 h", n, ecl, csv);
+  TEST_ASSERT_FLOAT_WITHIN(0.006f, csvLo, lo);
+  TEST_ASSERT_FLOAT_WITHIN(0.006f, csvHi, hi);
+  TEST_ASSERT_TRUE(ecl.bytes * 10 < csv.bytes);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_columnar_log_against_csv);
+  return UNITY_END();
+}
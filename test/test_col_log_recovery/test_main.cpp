@@ -0,0 +1,239 @@
+#include <unity.h>
+
+#include <stdlib.h>
+#include <utility>
+#include <vector>
+#include "FS.h"
+#include "col_log.h"
+
+/*
+ * Power-cut and card-corruption cases for colLogEnsureIndex() and the
+ * writer that depends on it. Each test damages the files on the in-memory
+ * FS the way an interrupted write would, then checks what recovery keeps.
+ */
+
+static HostFS card;
+static const char* path = "/envlog/20250615.ecl";
+static char idxPath[48];
+static const uint32_t day = 1749945600;  // 2025-06-15 00:00 UTC
+static const uint32_t blockBytes = 32 + colLogBlockCapacity * 8;  // Header and both columns
+
+typedef std::vector<std::pair<uint32_t, float>> Samples;
+
+static bool collect(uint32_t time, float value, void* ctx) {
+  ((Samples*)ctx)->push_back({time, value});
+  return true;
+}
+
+// Temperature only, one full block per 64 bins starting at bin `first`
+static void appendBlocks(ColLogWriter& w, uint32_t first, int blocks) {
+  for (uint32_t i = first; i < first + (uint32_t)blocks * colLogBlockCapacity; i++) {
+    TEST_ASSERT_TRUE(w.append(0, day + i * 30, 20.0f + i * 0.01f));
+  }
+}
+
+static void writeBlocks(int blocks) {
+  ColLogWriter w;
+  TEST_ASSERT_TRUE(w.open(card, path));
+  appendBlocks(w, 0, blocks);
+  TEST_ASSERT_TRUE(w.close());
+}
+
+// Every sample read back, checked to be in order with no repeats
+static Samples readAll() {
+  ColLogReader r;
+  TEST_ASSERT_TRUE(r.open(card, path));
+  Samples out;
+  r.query(0, day, day + 86400, collect, &out);
+  r.close();
+  for (size_t i = 1; i < out.size(); i++) TEST_ASSERT_TRUE(out[i - 1].first < out[i].first);
+  return out;
+}
+
+static size_t indexEntries() {
+  return (card.bytes(idxPath).size() - 4) / sizeof(ColLogIndexEntry);
+}
+
+void setUp() {
+  card.clear();
+  hostWriteBudget = -1;
+  colLogIndexPath(idxPath, sizeof(idxPath), path);
+}
+
+void tearDown() {
+  hostWriteBudget = -1;
+}
+
+void test_truncated_last_block_drops_its_entry() {
+  writeBlocks(8);
+  // Cut inside the last block: its footer and most of its payload are gone
+  std::vector<uint8_t>& log = card.bytes(path);
+  log.resize(8 + 7 * blockBytes + 100);
+
+  ColLogRecovery recovery;
+  TEST_ASSERT_EQUAL_INT(7, colLogEnsureIndex(card, path, &recovery));
+  TEST_ASSERT_EQUAL_INT(1, recovery.dropped);
+  TEST_ASSERT_EQUAL_INT(0, recovery.added);
+  TEST_ASSERT_EQUAL(7, indexEntries());
+  TEST_ASSERT_EQUAL(7 * colLogBlockCapacity, readAll().size());
+}
+
+void test_torn_index_entry_is_rebuilt_from_its_block() {
+  writeBlocks(8);
+  // The last entry was half written; its block is complete
+  std::vector<uint8_t>& idx = card.bytes(idxPath);
+  idx.resize(idx.size() - sizeof(ColLogIndexEntry) / 2);
+
+  ColLogRecovery recovery;
+  TEST_ASSERT_EQUAL_INT(8, colLogEnsureIndex(card, path, &recovery));
+  TEST_ASSERT_EQUAL_INT(0, recovery.dropped);
+  TEST_ASSERT_EQUAL_INT(1, recovery.added);
+  TEST_ASSERT_EQUAL(4 + 8 * sizeof(ColLogIndexEntry), card.bytes(idxPath).size());
+  Samples all = readAll();
+  TEST_ASSERT_EQUAL(8 * colLogBlockCapacity, all.size());
+  TEST_ASSERT_EQUAL_UINT32(day + (8 * colLogBlockCapacity - 1) * 30, all.back().first);
+}
+
+void test_garbage_tail_is_skipped_and_appended_after() {
+  writeBlocks(8);
+  // Stale sectors after the footer, including a fake block header
+  std::vector<uint8_t>& log = card.bytes(path);
+  srand(7);
+  for (int i = 0; i < 700; i++) log.push_back(rand() & 0xFF);
+  const uint8_t fake[] = {'B', 'L', 'K', '1', 0, 0, 64, 0, 99, 0, 0, 0};
+  log.insert(log.begin() + log.size() - 300, fake, fake + sizeof(fake));
+  size_t damaged = log.size();
+
+  ColLogRecovery recovery;
+  TEST_ASSERT_EQUAL_INT(8, colLogEnsureIndex(card, path, &recovery));
+  TEST_ASSERT_EQUAL_INT(0, recovery.dropped);
+  TEST_ASSERT_EQUAL_INT(0, recovery.added);
+  TEST_ASSERT_EQUAL(damaged, card.bytes(path).size());  // Left in place
+
+  // New blocks land after the garbage and read back with the old ones
+  ColLogWriter w;
+  TEST_ASSERT_TRUE(w.open(card, path));
+  appendBlocks(w, 8 * colLogBlockCapacity, 2);
+  TEST_ASSERT_TRUE(w.close());
+  TEST_ASSERT_EQUAL(10, indexEntries());
+  TEST_ASSERT_EQUAL(10 * colLogBlockCapacity, readAll().size());
+}
+
+void test_missing_index_is_rebuilt_from_the_log() {
+  writeBlocks(8);
+  card.remove(idxPath);
+
+  ColLogRecovery recovery;
+  TEST_ASSERT_EQUAL_INT(8, colLogEnsureIndex(card, path, &recovery));
+  TEST_ASSERT_EQUAL_INT(8, recovery.added);
+  TEST_ASSERT_EQUAL(8 * colLogBlockCapacity, readAll().size());
+}
+
+void test_short_header_starts_a_fresh_log() {
+  // Power cut while the header was being written
+  File f = card.open(path, "w");
+  f.write((const uint8_t*)"ECL", 3);
+  f.close();
+
+  ColLogWriter w;
+  TEST_ASSERT_TRUE(w.open(card, path));
+  appendBlocks(w, 0, 1);
+  TEST_ASSERT_TRUE(w.close());
+  TEST_ASSERT_EQUAL(colLogBlockCapacity, readAll().size());
+}
+
+void test_failed_header_write_is_reported() {
+  hostWriteBudget = 5;
+  ColLogWriter w;
+  TEST_ASSERT_FALSE(w.open(card, path));
+  hostWriteBudget = -1;
+  // The stub left behind is treated as fresh on the next try
+  TEST_ASSERT_TRUE(w.open(card, path));
+  TEST_ASSERT_TRUE(w.close());
+}
+
+void test_torn_block_write_leaves_no_duplicates() {
+  ColLogWriter w;
+  TEST_ASSERT_TRUE(w.open(card, path));
+  appendBlocks(w, 0, 2);
+  // The third block is cut short on the card; the writer keeps its samples
+  for (uint32_t i = 2 * colLogBlockCapacity; i < 3 * colLogBlockCapacity - 1; i++) {
+    TEST_ASSERT_TRUE(w.append(0, day + i * 30, 20.0f));
+  }
+  hostWriteBudget = 200;
+  TEST_ASSERT_FALSE(w.append(0, day + (3 * colLogBlockCapacity - 1) * 30, 20.0f));
+  hostWriteBudget = -1;
+  // The refused sample is offered again and the block is written after the
+  // torn copy
+  TEST_ASSERT_TRUE(w.append(0, day + (3 * colLogBlockCapacity - 1) * 30, 20.0f));
+  TEST_ASSERT_EQUAL(3, indexEntries());
+  // Power cut: the writer is never closed, so there is no footer
+
+  ColLogRecovery recovery;
+  TEST_ASSERT_EQUAL_INT(3, colLogEnsureIndex(card, path, &recovery));
+  TEST_ASSERT_EQUAL_INT(0, recovery.dropped);
+  TEST_ASSERT_EQUAL_INT(0, recovery.added);
+  TEST_ASSERT_EQUAL(3 * colLogBlockCapacity, readAll().size());
+}
+
+void test_lost_index_after_torn_block_skips_the_torn_copy() {
+  ColLogWriter w;
+  TEST_ASSERT_TRUE(w.open(card, path));
+  appendBlocks(w, 0, 1);
+  for (uint32_t i = colLogBlockCapacity; i < 2 * colLogBlockCapacity - 1; i++) {
+    TEST_ASSERT_TRUE(w.append(0, day + i * 30, 20.0f));
+  }
+  hostWriteBudget = 200;
+  TEST_ASSERT_FALSE(w.append(0, day + (2 * colLogBlockCapacity - 1) * 30, 20.0f));
+  hostWriteBudget = -1;
+  TEST_ASSERT_TRUE(w.append(0, day + (2 * colLogBlockCapacity - 1) * 30, 20.0f));
+  appendBlocks(w, 2 * colLogBlockCapacity, 1);
+  TEST_ASSERT_TRUE(w.close());
+  card.remove(idxPath);
+
+  // The rescan finds the three intact blocks and steps over the torn one
+  ColLogRecovery recovery;
+  TEST_ASSERT_EQUAL_INT(3, colLogEnsureIndex(card, path, &recovery));
+  TEST_ASSERT_EQUAL_INT(3, recovery.added);
+  TEST_ASSERT_EQUAL(3 * colLogBlockCapacity, readAll().size());
+}
+
+void test_full_file_refuses_and_keeps_room_for_close() {
+  ColLogWriter w;
+  TEST_ASSERT_TRUE(w.open(card, path));
+  // A partial block of a second series waits for close()
+  TEST_ASSERT_TRUE(w.append(1, day, 40.0f));
+  int blocks = colLogZoneMax - colLogSeriesMax;
+  appendBlocks(w, 0, blocks);
+  TEST_ASSERT_TRUE(w.full());
+  uint32_t t = day + blocks * colLogBlockCapacity * 30;
+  for (int i = 0; i < colLogBlockCapacity - 1; i++) TEST_ASSERT_TRUE(w.append(0, t + i * 30, 20.0f));
+  // The sample that would complete a block is refused, not lost
+  TEST_ASSERT_FALSE(w.append(0, t + (colLogBlockCapacity - 1) * 30, 20.0f));
+  TEST_ASSERT_EQUAL_UINT16(colLogBlockCapacity - 1, w.pending(0));
+  TEST_ASSERT_TRUE(w.close());
+  TEST_ASSERT_EQUAL_UINT16(0, w.pending(0));
+  TEST_ASSERT_EQUAL_UINT16(0, w.pending(1));
+  ColLogReader r;
+  TEST_ASSERT_TRUE(r.open(card, path));
+  Samples temp, humidity;
+  r.query(0, day, UINT32_MAX, collect, &temp);
+  r.query(1, day, UINT32_MAX, collect, &humidity);
+  r.close();
+  TEST_ASSERT_EQUAL((blocks + 1) * colLogBlockCapacity - 1, temp.size());
+  TEST_ASSERT_EQUAL(1, humidity.size());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_truncated_last_block_drops_its_entry);
+  RUN_TEST(test_torn_index_entry_is_rebuilt_from_its_block);
+  RUN_TEST(test_garbage_tail_is_skipped_and_appended_after);
+  RUN_TEST(test_missing_index_is_rebuilt_from_the_log);
+  RUN_TEST(test_short_header_starts_a_fresh_log);
+  RUN_TEST(test_failed_header_write_is_reported);
+  RUN_TEST(test_torn_block_write_leaves_no_duplicates);
+  RUN_TEST(test_lost_index_after_torn_block_skips_the_torn_copy);
+  RUN_TEST(test_full_file_refuses_and_keeps_room_for_close);
+  return UNITY_END();
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+/*
+ * Ten minutes of temperature and humidity at 1 Hz, rounded to 0.01 as the
+ * serial log prints them. Both drift slowly across display boundaries with
+ * sensor-sized noise on top: temperature through 22.05 and 22.15, humidity
+ * through 45.5. Generated once with a fixed seed (noise sd 0.015 C and
+ * 0.12 %RH, about what an SHT30 shows on a desk) so the replay is
+ * reproducible.
+ */
+
+const int seriesLength = 600;
+
+const float temperatureSeries[seriesLength] = {
+    22.04f, 22.01f, 22.03f, 21.99f, 22.04f, 21.98f, 22.00f, 22.06f, 22.01f, 22.03f,
+    22.02f, 22.05f, 21.99f, 22.04f, 22.04f, 22.04f, 22.04f, 22.03f, 22.03f, 22.04f,
+    22.03f, 22.06f, 22.05f, 22.01f, 22.01f, 22.04f, 22.04f, 22.04f, 22.04f, 22.02f,
+    22.04f, 22.05f, 22.03f, 22.04f, 22.05f, 22.02f, 22.06f, 22.05f, 22.02f, 22.02f,
+    22.01f, 22.02f, 22.05f, 22.04f, 22.05f, 22.02f, 22.03f, 22.05f, 22.04f, 22.04f,
+    22.04f, 22.05f, 22.04f, 22.06f, 22.05f, 22.04f, 22.06f, 22.01f, 22.03f, 22.04f,
+    22.05f, 22.02f, 22.05f, 22.04f, 22.05f, 22.03f, 22.04f, 22.01f, 22.03f, 22.04f,
+    22.06f, 22.05f, 22.03f, 22.04f, 22.03f, 22.02f, 22.04f, 22.04f, 22.03f, 22.07f,
+    22.08f, 22.07f, 22.07f, 22.06f, 22.07f, 22.02f, 22.04f, 22.03f, 22.04f, 22.07f,
+    22.05f, 22.06f, 22.05f, 22.04f, 22.06f, 22.05f, 22.06f, 22.06f, 22.05f, 22.06f,
+    22.03f, 22.03f, 22.04f, 22.06f, 22.04f, 22.05f, 22.06f, 22.06f, 22.09f, 22.05f,
+    22.03f, 22.04f, 22.03f, 22.04f, 22.05f, 22.03f, 22.01f, 22.03f, 22.07f, 22.02f,
+    22.04f, 22.03f, 22.06f, 22.03f, 22.05f, 22.04f, 22.04f, 22.07f, 22.06f, 22.04f,
+    22.06f, 22.05f, 22.05f, 22.04f, 22.06f, 22.06f, 22.02f, 22.08f, 22.04f, 22.03f,
+    22.04f, 22.02f, 22.02f, 22.05f, 22.02f, 22.03f, 22.07f, 22.02f, 22.03f, 22.04f,
+    22.06f, 22.05f, 22.04f, 22.04f, 22.04f, 22.04f, 22.04f, 22.06f, 22.03f, 22.02f,
+    22.07f, 22.05f, 22.03f, 22.04f, 22.05f, 22.03f, 22.06f, 22.08f, 22.05f, 22.05f,
+    22.04f, 22.02f, 22.04f, 22.05f, 22.07f, 22.07f, 22.05f, 22.05f, 22.05f, 22.04f,
+    22.06f, 22.04f, 22.03f, 22.06f, 22.05f, 22.07f, 22.04f, 22.04f, 22.05f, 22.05f,
+    22.06f, 22.06f, 22.05f, 22.06f, 22.04f, 22.05f, 22.06f, 22.05f, 22.05f, 22.06f,
+    22.05f, 22.06f, 22.07f, 22.07f, 22.08f, 22.06f, 22.06f, 22.07f, 22.04f, 22.07f,
+    22.05f, 22.07f, 22.08f, 22.06f, 22.05f, 22.08f, 22.08f, 22.05f, 22.07f, 22.05f,
+    22.08f, 22.08f, 22.07f, 22.07f, 22.09f, 22.10f, 22.09f, 22.03f, 22.06f, 22.04f,
+    22.07f, 22.06f, 22.07f, 22.06f, 22.02f, 22.09f, 22.07f, 22.09f, 22.08f, 22.07f,
+    22.10f, 22.09f, 22.06f, 22.08f, 22.05f, 22.09f, 22.10f, 22.09f, 22.07f, 22.11f,
+    22.09f, 22.08f, 22.09f, 22.05f, 22.08f, 22.10f, 22.07f, 22.09f, 22.09f, 22.06f,
+    22.07f, 22.09f, 22.08f, 22.10f, 22.07f, 22.12f, 22.10f, 22.07f, 22.09f, 22.10f,
+    22.09f, 22.07f, 22.10f, 22.12f, 22.08f, 22.10f, 22.09f, 22.09f, 22.10f, 22.08f,
+    22.09f, 22.08f, 22.07f, 22.08f, 22.09f, 22.09f, 22.11f, 22.10f, 22.07f, 22.10f,
+    22.11f, 22.11f, 22.13f, 22.09f, 22.08f, 22.09f, 22.11f, 22.10f, 22.07f, 22.10f,
+    22.08f, 22.10f, 22.12f, 22.10f, 22.08f, 22.11f, 22.10f, 22.09f, 22.11f, 22.09f,
+    22.10f, 22.12f, 22.12f, 22.10f, 22.12f, 22.08f, 22.11f, 22.09f, 22.10f, 22.10f,
+    22.11f, 22.11f, 22.10f, 22.10f, 22.11f, 22.15f, 22.10f, 22.10f, 22.09f, 22.09f,
+    22.10f, 22.07f, 22.12f, 22.07f, 22.12f, 22.10f, 22.11f, 22.12f, 22.09f, 22.14f,
+    22.09f, 22.10f, 22.13f, 22.11f, 22.09f, 22.09f, 22.09f, 22.12f, 22.11f, 22.13f,
+    22.13f, 22.12f, 22.11f, 22.10f, 22.12f, 22.09f, 22.10f, 22.09f, 22.10f, 22.12f,
+    22.11f, 22.11f, 22.11f, 22.09f, 22.12f, 22.10f, 22.13f, 22.09f, 22.13f, 22.11f,
+    22.12f, 22.10f, 22.09f, 22.10f, 22.11f, 22.09f, 22.11f, 22.12f, 22.09f, 22.11f,
+    22.09f, 22.11f, 22.10f, 22.11f, 22.12f, 22.12f, 22.10f, 22.11f, 22.08f, 22.11f,
+    22.11f, 22.10f, 22.10f, 22.10f, 22.10f, 22.14f, 22.11f, 22.13f, 22.12f, 22.11f,
+    22.10f, 22.11f, 22.13f, 22.12f, 22.07f, 22.09f, 22.13f, 22.08f, 22.12f, 22.14f,
+    22.09f, 22.11f, 22.10f, 22.12f, 22.11f, 22.12f, 22.11f, 22.12f, 22.10f, 22.11f,
+    22.13f, 22.12f, 22.11f, 22.10f, 22.11f, 22.12f, 22.11f, 22.07f, 22.13f, 22.11f,
+    22.10f, 22.12f, 22.13f, 22.13f, 22.11f, 22.14f, 22.11f, 22.13f, 22.11f, 22.12f,
+    22.11f, 22.11f, 22.13f, 22.11f, 22.11f, 22.12f, 22.14f, 22.11f, 22.14f, 22.10f,
+    22.13f, 22.12f, 22.10f, 22.13f, 22.11f, 22.12f, 22.11f, 22.13f, 22.10f, 22.10f,
+    22.12f, 22.11f, 22.12f, 22.11f, 22.09f, 22.13f, 22.11f, 22.13f, 22.12f, 22.13f,
+    22.11f, 22.10f, 22.15f, 22.13f, 22.13f, 22.15f, 22.12f, 22.16f, 22.11f, 22.15f,
+    22.13f, 22.13f, 22.10f, 22.12f, 22.12f, 22.13f, 22.12f, 22.14f, 22.13f, 22.12f,
+    22.12f, 22.11f, 22.14f, 22.13f, 22.13f, 22.10f, 22.13f, 22.12f, 22.16f, 22.13f,
+    22.13f, 22.15f, 22.14f, 22.17f, 22.14f, 22.17f, 22.12f, 22.12f, 22.14f, 22.15f,
+    22.13f, 22.14f, 22.15f, 22.15f, 22.13f, 22.18f, 22.12f, 22.11f, 22.18f, 22.18f,
+    22.14f, 22.17f, 22.14f, 22.16f, 22.14f, 22.14f, 22.16f, 22.16f, 22.15f, 22.13f,
+    22.16f, 22.17f, 22.12f, 22.16f, 22.17f, 22.15f, 22.16f, 22.13f, 22.16f, 22.18f,
+    22.14f, 22.18f, 22.14f, 22.15f, 22.16f, 22.15f, 22.16f, 22.14f, 22.15f, 22.17f,
+    22.15f, 22.15f, 22.14f, 22.16f, 22.16f, 22.15f, 22.18f, 22.14f, 22.20f, 22.16f,
+    22.15f, 22.18f, 22.16f, 22.16f, 22.14f, 22.15f, 22.12f, 22.15f, 22.18f, 22.16f,
+    22.17f, 22.14f, 22.18f, 22.20f, 22.18f, 22.15f, 22.17f, 22.15f, 22.18f, 22.16f,
+    22.16f, 22.18f, 22.17f, 22.16f, 22.18f, 22.17f, 22.20f, 22.18f, 22.17f, 22.18f,
+    22.14f, 22.16f, 22.14f, 22.15f, 22.15f, 22.17f, 22.16f, 22.17f, 22.15f, 22.17f,
+};
+
+const float humiditySeries[seriesLength] = {
+    45.15f, 45.18f, 45.34f, 45.29f, 45.35f, 45.34f, 45.44f, 45.35f, 45.37f, 45.10f,
+    45.17f, 45.12f, 45.43f, 45.17f, 45.43f, 45.40f, 45.59f, 45.23f, 45.34f, 45.15f,
+    45.42f, 45.39f, 45.43f, 45.34f, 45.39f, 45.32f, 45.46f, 45.31f, 45.42f, 45.22f,
+    45.17f, 45.35f, 45.42f, 45.14f, 45.19f, 45.38f, 45.29f, 45.43f, 45.12f, 45.45f,
+    45.58f, 45.12f, 45.19f, 45.45f, 45.43f, 45.35f, 45.28f, 45.54f, 45.27f, 45.33f,
+    45.50f, 45.41f, 45.49f, 45.38f, 45.26f, 45.22f, 45.36f, 45.23f, 45.57f, 45.34f,
+    45.55f, 45.39f, 45.44f, 45.33f, 45.47f, 45.45f, 45.58f, 45.29f, 45.40f, 45.25f,
+    45.17f, 45.35f, 45.51f, 45.39f, 45.48f, 45.50f, 45.54f, 45.32f, 45.02f, 45.44f,
+    45.29f, 45.20f, 45.42f, 45.43f, 45.36f, 45.38f, 45.58f, 45.36f, 45.18f, 45.34f,
+    45.28f, 45.40f, 45.45f, 45.55f, 45.44f, 45.54f, 45.35f, 45.42f, 45.41f, 45.24f,
+    45.42f, 45.46f, 45.24f, 45.52f, 45.28f, 45.30f, 45.36f, 45.43f, 45.43f, 45.52f,
+    45.39f, 45.37f, 45.51f, 45.63f, 45.42f, 45.57f, 45.51f, 45.35f, 45.45f, 45.37f,
+    45.32f, 45.42f, 45.38f, 45.41f, 45.34f, 45.41f, 45.51f, 45.56f, 45.23f, 45.65f,
+    45.45f, 45.31f, 45.32f, 45.26f, 45.45f, 45.42f, 45.36f, 45.42f, 45.32f, 45.34f,
+    45.50f, 45.54f, 45.51f, 45.41f, 45.37f, 45.45f, 45.39f, 45.34f, 45.30f, 45.28f,
+    45.53f, 45.29f, 45.36f, 45.58f, 45.43f, 45.57f, 45.67f, 45.42f, 45.29f, 45.36f,
+    45.63f, 45.37f, 45.64f, 45.23f, 45.15f, 45.53f, 45.62f, 45.46f, 45.45f, 45.48f,
+    45.64f, 45.32f, 45.43f, 45.49f, 45.47f, 45.39f, 45.48f, 45.40f, 45.38f, 45.47f,
+    45.37f, 45.57f, 45.44f, 45.49f, 45.60f, 45.44f, 45.41f, 45.38f, 45.44f, 45.26f,
+    45.23f, 45.37f, 45.55f, 45.40f, 45.29f, 45.52f, 45.52f, 45.57f, 45.37f, 45.53f,
+    45.42f, 45.68f, 45.40f, 45.47f, 45.41f, 45.68f, 45.45f, 45.45f, 45.31f, 45.58f,
+    45.49f, 45.52f, 45.62f, 45.62f, 45.34f, 45.55f, 45.25f, 45.72f, 45.27f, 45.63f,
+    45.44f, 45.51f, 45.58f, 45.38f, 45.54f, 45.23f, 45.64f, 45.49f, 45.33f, 45.33f,
+    45.49f, 45.61f, 45.36f, 45.28f, 45.51f, 45.55f, 45.50f, 45.23f, 45.66f, 45.29f,
+    45.45f, 45.46f, 45.46f, 45.59f, 45.51f, 45.57f, 45.41f, 45.37f, 45.46f, 45.50f,
+    45.69f, 45.62f, 45.52f, 45.51f, 45.50f, 45.39f, 45.33f, 45.53f, 45.49f, 45.44f,
+    45.30f, 45.47f, 45.56f, 45.71f, 45.65f, 45.53f, 45.55f, 45.43f, 45.47f, 45.58f,
+    45.38f, 45.48f, 45.57f, 45.60f, 45.51f, 45.65f, 45.59f, 45.24f, 45.54f, 45.72f,
+    45.67f, 45.23f, 45.33f, 45.51f, 45.59f, 45.53f, 45.61f, 45.37f, 45.54f, 45.32f,
+    45.57f, 45.46f, 45.50f, 45.31f, 45.48f, 45.62f, 45.56f, 45.65f, 45.52f, 45.67f,
+    45.65f, 45.65f, 45.51f, 45.50f, 45.56f, 45.64f, 45.61f, 45.75f, 45.63f, 45.57f,
+    45.83f, 45.74f, 45.79f, 45.53f, 45.52f, 45.71f, 45.65f, 45.45f, 45.49f, 45.77f,
+    45.43f, 45.57f, 45.50f, 45.51f, 45.53f, 45.47f, 45.79f, 45.48f, 45.52f, 45.46f,
+    45.49f, 45.43f, 45.37f, 45.62f, 45.53f, 45.39f, 45.74f, 45.54f, 45.57f, 45.54f,
+    45.44f, 45.44f, 45.50f, 45.78f, 45.58f, 45.48f, 45.56f, 45.58f, 45.51f, 45.54f,
+    45.68f, 45.60f, 45.45f, 45.61f, 45.46f, 45.61f, 45.57f, 45.47f, 45.67f, 45.63f,
+    45.65f, 45.80f, 45.65f, 45.52f, 45.37f, 45.78f, 45.55f, 45.71f, 45.53f, 45.70f,
+    45.62f, 45.50f, 45.84f, 45.44f, 45.54f, 45.61f, 45.56f, 45.63f, 45.57f, 45.54f,
+    45.52f, 45.58f, 45.70f, 45.75f, 45.69f, 45.47f, 45.71f, 45.64f, 45.70f, 45.65f,
+    45.54f, 45.72f, 45.64f, 45.60f, 45.39f, 45.50f, 45.53f, 45.76f, 45.65f, 45.62f,
+    45.55f, 45.61f, 45.57f, 45.64f, 45.84f, 45.76f, 45.37f, 45.57f, 45.57f, 45.50f,
+    45.54f, 45.61f, 45.76f, 45.70f, 45.73f, 45.76f, 45.58f, 45.49f, 45.64f, 45.71f,
+    45.76f, 45.57f, 45.74f, 45.68f, 45.72f, 45.67f, 45.65f, 45.67f, 45.68f, 45.71f,
+    45.70f, 45.57f, 45.60f, 45.65f, 45.56f, 45.65f, 45.51f, 45.77f, 45.72f, 45.80f,
+    45.56f, 45.64f, 45.65f, 45.61f, 45.72f, 45.69f, 45.84f, 45.45f, 45.72f, 45.65f,
+    45.57f, 45.63f, 45.75f, 45.79f, 45.76f, 45.62f, 45.81f, 45.65f, 45.61f, 45.75f,
+    45.44f, 45.86f, 45.62f, 45.78f, 45.93f, 46.05f, 45.77f, 45.74f, 45.84f, 45.56f,
+    45.68f, 45.44f, 45.80f, 45.70f, 45.59f, 45.70f, 45.81f, 45.64f, 45.60f, 45.84f,
+    45.87f, 45.56f, 45.70f, 45.68f, 45.75f, 45.85f, 45.59f, 45.85f, 45.86f, 45.72f,
+    45.79f, 45.88f, 45.61f, 45.72f, 45.65f, 45.83f, 45.71f, 45.66f, 45.85f, 45.69f,
+    45.70f, 45.83f, 45.82f, 45.64f, 45.72f, 45.43f, 45.71f, 45.64f, 45.75f, 45.75f,
+    45.84f, 45.63f, 45.56f, 45.61f, 45.69f, 45.63f, 45.85f, 45.79f, 45.78f, 45.78f,
+    45.72f, 45.58f, 45.78f, 45.88f, 45.76f, 45.79f, 45.67f, 45.62f, 46.01f, 45.86f,
+    45.74f, 45.64f, 45.65f, 45.64f, 45.79f, 45.82f, 45.67f, 45.84f, 45.77f, 45.67f,
+    45.73f, 45.78f, 45.74f, 45.59f, 45.68f, 45.81f, 45.67f, 45.66f, 45.83f, 45.90f,
+    45.65f, 45.74f, 45.84f, 45.99f, 45.80f, 45.70f, 45.95f, 45.50f, 45.70f, 45.92f,
+    45.52f, 45.88f, 45.60f, 45.96f, 45.84f, 45.81f, 45.68f, 45.63f, 45.76f, 45.86f,
+    45.88f, 46.02f, 45.81f, 45.77f, 45.75f, 45.79f, 45.74f, 45.64f, 45.66f, 45.89f,
+    45.51f, 45.87f, 45.68f, 45.81f, 45.57f, 45.78f, 45.76f, 45.82f, 45.87f, 45.69f,
+    45.91f, 45.85f, 45.65f, 45.93f, 45.63f, 45.74f, 45.88f, 45.71f, 45.81f, 46.10f,
+};
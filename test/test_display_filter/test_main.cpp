@@ -0,0 +1,107 @@
+#include <unity.h>
+
+#include <math.h>
+#include <stdio.h>
+#include "Arduino.h"
+#include "config.h"
+#include "display_filter.h"
+#include "noisy_series.h"
+
+/*
+ * Replays a noisy series through displayFilterUpdate() at 1 Hz the way the
+ * main loop calls it, and checks the redraws it asks for and the redraws
+ * it reports as avoided against the old 0.05 rule worked out here.
+ */
+
+struct Replay {
+  uint32_t redraws;
+  uint32_t legacy;       // Redraws the old rule would have done
+  uint32_t skipped;      // Of those, not done by the filter
+  uint32_t avoided;      // Counted by the filter
+  uint32_t flickers;     // Returned to the previous text within 10 s
+  float worstLag;        // Largest distance between value and text
+};
+
+static Replay replay(const float* series, float step) {
+  DisplayFilter f = {step, false, 0, 0};
+  Replay r = {0, 0, 0, 0, 0, 0};
+  uint32_t avoidedBefore = displayCountsTotal().avoided;
+  float legacyShown = 0;
+  float previous = NAN;
+  int lastChange = -100;
+  for (int i = 0; i < seriesLength; i++) {
+    float v = series[i];
+    bool legacy = i == 0 || fabsf(v - legacyShown) >= 0.05f;
+    if (legacy) {
+      legacyShown = v;
+      r.legacy++;
+    }
+    float before = f.shown;
+    bool redraw = displayFilterUpdate(f, v);
+    if (legacy && !redraw) r.skipped++;
+    if (redraw) {
+      r.redraws++;
+      if (i > 0) {
+        if (f.shown == previous && i - lastChange < 10) r.flickers++;
+        previous = before;
+        lastChange = i;
+      }
+    }
+    float lag = fabsf(v - f.shown);
+    if (lag > r.worstLag) r.worstLag = lag;
+    hostMillis += 1000;
+  }
+  r.avoided = displayCountsTotal().avoided - avoidedBefore;
+  return r;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_temperature_replay() {
+  Replay r = replay(temperatureSeries, 0.1f);
+  printf("  temperature: %lu redraws, %lu with the 0.05 rule, %lu avoided\n",
+         (unsigned long)r.redraws, (unsigned long)r.legacy, (unsigned long)r.avoided);
+  // 22.0 -> 22.1 -> 22.2 is the whole story
+  TEST_ASSERT_EQUAL_UINT32(3, r.redraws);
+  TEST_ASSERT_EQUAL_UINT32(0, r.flickers);
+  TEST_ASSERT_TRUE(r.legacy > 5 * r.redraws);
+  // Every legacy redraw the filter skipped is counted, and only those
+  TEST_ASSERT_EQUAL_UINT32(r.skipped, r.avoided);
+  // The text never trails the value by more than the hysteresis band
+  TEST_ASSERT_TRUE(r.worstLag < 0.1f * (0.5f + DISPLAY_HYSTERESIS) + 0.001f);
+}
+
+void test_humidity_replay() {
+  Replay r = replay(humiditySeries, 1.0f);
+  printf("  humidity:    %lu redraws, %lu with the 0.05 rule, %lu avoided\n",
+         (unsigned long)r.redraws, (unsigned long)r.legacy, (unsigned long)r.avoided);
+  // 45 -> 46 once, despite the noise straddling 45.5 for minutes
+  TEST_ASSERT_EQUAL_UINT32(2, r.redraws);
+  TEST_ASSERT_EQUAL_UINT32(0, r.flickers);
+  TEST_ASSERT_EQUAL_UINT32(r.skipped, r.avoided);
+  TEST_ASSERT_TRUE(r.avoided > 400);
+}
+
+void test_last_hour_counts_roll_over() {
+  // A fresh hour: nothing counted before this test's replay
+  hostMillis += 3600000;
+  DisplayFilter f = {0.1f, false, 0, 0};
+  displayFilterUpdate(f, 20.0f);
+  DisplayCounts start = displayCountsTotal();
+  Replay r = replay(temperatureSeries, 0.1f);
+  hostMillis += 3600000;
+  displayFilterUpdate(f, 20.0f);
+  const DisplayCounts& last = displayCountsLastHour();
+  TEST_ASSERT_EQUAL_UINT32(1 + r.redraws, last.redraws);
+  TEST_ASSERT_EQUAL_UINT32(r.avoided, last.avoided);
+  TEST_ASSERT_EQUAL_UINT32(start.redraws + r.redraws, displayCountsTotal().redraws);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_temperature_replay);
+  RUN_TEST(test_humidity_replay);
+  RUN_TEST(test_last_hour_counts_roll_over);
+  return UNITY_END();
+}
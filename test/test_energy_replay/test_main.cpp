@@ -0,0 +1,121 @@
+#include <unity.h>
+
+#include <stdio.h>
+#include "energy_model.h"
+
+/*
+ * Energy replay: one hour of each configuration, written as the counters
+ * the firmware would have collected, run through energyEstimate() with the
+ * default calibration. Prints the breakdown and the battery life.
+ *
+ * Inputs common to every configuration, from the host replays and the
+ * firmware's own rates:
+ *   CPU busy     0.8 % of the time in loop code (29 s/h)
+ *   I2C          590 transfers/h (adaptive sampling, test_sampler_replay)
+ *   SD           6 log blocks/h (three series, hourly flush)
+ *   Display SPI  value redraws only while the screen is on, ~2 KB each,
+ *                one every 4 s
+ */
+
+static const uint64_t hourMs = 3600000;
+static const float capacityMah = 1750;
+
+struct Scenario {
+  const char* name;
+  uint64_t screenOnMs;  // At 80 %, off for the rest of the hour
+  uint64_t wifiOnMs;
+  uint64_t bleOnMs;
+  float expectedMah;    // Total mAh/h
+};
+
+static const Scenario scenarios[] = {
+  // Always on
+  {"always on, 80 %, steady room", hourMs, 0, 0, 46.2f},
+  // Woken 5 times an hour, 30 s each
+  {"30 s timeout, steady", 5 * 30000, 0, 0, 32.8f},
+  // Wi-Fi up ~6 s per publish (associate, DHCP, connect, send)
+  {"30 s timeout + MQTT every 5 min", 5 * 30000, 12 * 6000, 0, 33.8f},
+  {"30 s timeout + BLE", 5 * 30000, 0, hourMs, 47.8f},
+  // Metrics endpoint: the link stays up
+  {"Wi-Fi always up (metrics)", 5 * 30000, hourMs, 0, 82.8f},
+};
+
+static EnergyCounters countersFor(const Scenario& s) {
+  EnergyCounters c = {};
+  c.awakeMs = hourMs;
+  c.cpuBusyUs = hourMs * 1000 * 8 / 1000;
+  c.backlightMs[energyBrightnessStep(80)] = s.screenOnMs;
+  c.backlightMs[0] = hourMs - s.screenOnMs;
+  c.spiBytes = s.screenOnMs / 4000 * 2048;
+  c.i2cTransactions = 590;
+  c.sdBlockWrites = 6;
+  c.wifiOnMs = s.wifiOnMs;
+  c.bleOnMs = s.bleOnMs;
+  return c;
+}
+
+static float total(const float mAh[ENERGY_PART_COUNT]) {
+  float sum = 0;
+  for (int i = 0; i < ENERGY_PART_COUNT; i++) sum += mAh[i];
+  return sum;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_configurations() {
+  printf("\n  %-34s", "");
+  for (int i = 0; i < ENERGY_PART_COUNT; i++) printf(" %11s", energyPartName((EnergyPart)i));
+  printf("   total   battery\n");
+  for (const Scenario& s : scenarios) {
+    float mAh[ENERGY_PART_COUNT];
+    energyEstimate(countersFor(s), energyDefaultCalibration, mAh);
+    printf("  %-34s", s.name);
+    for (int i = 0; i < ENERGY_PART_COUNT; i++) printf(" %11.3f", mAh[i]);
+    float hours = energyBatteryHours(mAh, capacityMah);
+    printf("  %6.1f  %5.0f h\n", total(mAh), hours);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, s.expectedMah, total(mAh));
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, capacityMah / s.expectedMah, hours);
+    // The CPU idling at 240 MHz outweighs everything but the radio
+    for (int i = ENERGY_BACKLIGHT; i < ENERGY_RADIO; i++) TEST_ASSERT_TRUE(mAh[ENERGY_CPU] > mAh[i]);
+  }
+}
+
+void test_device_counting_matches_the_replay() {
+  // The same hour as "30 s timeout + MQTT", counted through the device API
+  // at a 100 ms tick: screen on for the first 30 s of each 12 minutes, Wi-Fi
+  // for 6 s every 5 minutes
+  const int step80 = energyBrightnessStep(80);
+  energyTick(0, 0, false, false);
+  for (unsigned long t = 100; t <= hourMs; t += 100) {
+    unsigned long prev = t - 100;
+    bool screen = prev % 720000 < 30000;
+    bool wifi = prev % 300000 < 6000;
+    energyTick(t, screen ? step80 : 0, wifi, false);
+    if (t % 4000 == 0 && screen) energyAddSpiBytes(2048);
+  }
+  energyAddCpuBusy(hourMs * 8);
+  energyAddI2c(590);
+  energyAddSdBlocks(6);
+
+  float counted[ENERGY_PART_COUNT], replayed[ENERGY_PART_COUNT];
+  energyEstimate(energyCounters(), energyDefaultCalibration, counted);
+  energyEstimate(countersFor(scenarios[2]), energyDefaultCalibration, replayed);
+  for (int i = 0; i < ENERGY_PART_COUNT; i++) TEST_ASSERT_FLOAT_WITHIN(0.01f, replayed[i], counted[i]);
+}
+
+void test_no_time_counted_gives_zero() {
+  EnergyCounters c = {};
+  float mAh[ENERGY_PART_COUNT];
+  energyEstimate(c, energyDefaultCalibration, mAh);
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, total(mAh));
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, energyBatteryHours(mAh, capacityMah));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_configurations);
+  RUN_TEST(test_device_counting_matches_the_replay);
+  RUN_TEST(test_no_time_counted_gives_zero);
+  return UNITY_END();
+}
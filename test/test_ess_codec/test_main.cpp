@@ -0,0 +1,84 @@
+#include <unity.h>
+
+#include <math.h>
+#include "ess_codec.h"
+
+void setUp() {}
+void tearDown() {}
+
+void test_temperature_encoding() {
+  TEST_ASSERT_EQUAL_INT16(2150, essEncodeTemperature(21.5f));
+  TEST_ASSERT_EQUAL_INT16(-1234, essEncodeTemperature(-12.34f));
+  TEST_ASSERT_EQUAL_INT16(2001, essEncodeTemperature(20.005f + 0.0001f));
+  TEST_ASSERT_EQUAL_INT16(-27315, essEncodeTemperature(-300.0f));  // Absolute zero
+  TEST_ASSERT_EQUAL_INT16(INT16_MAX, essEncodeTemperature(400.0f));
+  TEST_ASSERT_EQUAL_INT16(INT16_MIN, essEncodeTemperature(NAN));  // Not known
+}
+
+void test_humidity_encoding() {
+  TEST_ASSERT_EQUAL_UINT16(4512, essEncodeHumidity(45.12f));
+  TEST_ASSERT_EQUAL_UINT16(0, essEncodeHumidity(-1.0f));
+  TEST_ASSERT_EQUAL_UINT16(10000, essEncodeHumidity(104.0f));
+  TEST_ASSERT_EQUAL_UINT16(0xFFFF, essEncodeHumidity(NAN));
+}
+
+void test_pressure_encoding() {
+  // hPa to 0.1 Pa
+  TEST_ASSERT_EQUAL_UINT32(1013250, essEncodePressure(1013.25f));
+  TEST_ASSERT_EQUAL_UINT32(0, essEncodePressure(-5.0f));
+  TEST_ASSERT_EQUAL_UINT32(0, essEncodePressure(NAN));
+}
+
+void test_records_per_chunk() {
+  TEST_ASSERT_EQUAL(1, essRecordsPerChunk(23));   // Default ATT MTU
+  TEST_ASSERT_EQUAL(0, essRecordsPerChunk(16));
+  TEST_ASSERT_EQUAL(1, essRecordsPerChunk(17));
+  TEST_ASSERT_EQUAL(20, essRecordsPerChunk(247));
+  TEST_ASSERT_EQUAL(42, essRecordsPerChunk(517));
+}
+
+void test_chunk_header() {
+  uint8_t out[2];
+  essPutChunkHeader(out, 0x1234, false);
+  TEST_ASSERT_EQUAL_HEX8(0x34, out[0]);
+  TEST_ASSERT_EQUAL_HEX8(0x12, out[1]);
+  essPutChunkHeader(out, 7, true);
+  TEST_ASSERT_EQUAL_HEX8(0x07, out[0]);
+  TEST_ASSERT_EQUAL_HEX8(0x80, out[1]);
+  // A sequence number that reaches bit 15 does not fake the last flag
+  essPutChunkHeader(out, 0x8001, false);
+  TEST_ASSERT_EQUAL_HEX8(0x00, out[1]);
+}
+
+void test_record_layout_is_little_endian() {
+  uint8_t out[essRecordSize + 1];
+  out[essRecordSize] = 0xEE;
+  essPutRecord(out, 0x01020304, -1.5f, 50.0f, 1000.0f);
+  const uint8_t expected[essRecordSize] = {
+      0x04, 0x03, 0x02, 0x01,  // time
+      0x6A, 0xFF,              // -150
+      0x88, 0x13,              // 5000
+      0x40, 0x42, 0x0F, 0x00,  // 1000000
+  };
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, out, essRecordSize);
+  TEST_ASSERT_EQUAL_HEX8(0xEE, out[essRecordSize]);
+}
+
+void test_crossed_threshold() {
+  TEST_ASSERT_FALSE(essCrossed(21.04f, 21.0f, 0.1f));
+  TEST_ASSERT_TRUE(essCrossed(21.1f, 21.0f, 0.1f));
+  TEST_ASSERT_TRUE(essCrossed(20.9f, 21.0f, 0.1f));
+  TEST_ASSERT_FALSE(essCrossed(20.96f, 21.0f, 0.1f));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_temperature_encoding);
+  RUN_TEST(test_humidity_encoding);
+  RUN_TEST(test_pressure_encoding);
+  RUN_TEST(test_records_per_chunk);
+  RUN_TEST(test_chunk_header);
+  RUN_TEST(test_record_layout_is_little_endian);
+  RUN_TEST(test_crossed_threshold);
+  return UNITY_END();
+}
@@ -0,0 +1,190 @@
+#include <unity.h>
+
+#include "FS.h"
+#include "flash_queue.h"
+
+static HostFS flash;
+static const char* path = "/queue.bin";
+static const uint16_t slots = 4;
+static const uint16_t slotSize = 16;
+static const size_t headerBytes = 28;     // One header copy
+static const size_t slotHeaderBytes = 10;  // Length, sequence, CRC
+
+void setUp() {
+  flash.clear();
+  hostWriteBudget = -1;
+}
+
+void tearDown() {
+  hostWriteBudget = -1;
+}
+
+static bool pushNumber(FlashQueue& q, uint32_t n) {
+  char msg[slotSize];
+  int len = snprintf(msg, sizeof(msg), "msg %lu", (unsigned long)n);
+  return q.push((const uint8_t*)msg, len);
+}
+
+static void assertNext(FlashQueue& q, uint32_t n) {
+  char expected[slotSize];
+  int len = snprintf(expected, sizeof(expected), "msg %lu", (unsigned long)n);
+  uint8_t buf[slotSize];
+  TEST_ASSERT_EQUAL_INT(len, q.peek(buf, sizeof(buf)));
+  TEST_ASSERT_EQUAL_MEMORY(expected, buf, len);
+  TEST_ASSERT_TRUE(q.pop());
+}
+
+void test_fifo_order_survives_reboot() {
+  FlashQueue q;
+  TEST_ASSERT_TRUE(q.begin(flash, path, slots, slotSize));
+  TEST_ASSERT_TRUE(q.empty());
+  for (uint32_t i = 0; i < 3; i++) TEST_ASSERT_TRUE(pushNumber(q, i));
+  assertNext(q, 0);
+
+  FlashQueue rebooted;
+  TEST_ASSERT_TRUE(rebooted.begin(flash, path, slots, slotSize));
+  TEST_ASSERT_EQUAL_UINT32(2, rebooted.size());
+  assertNext(rebooted, 1);
+  assertNext(rebooted, 2);
+  TEST_ASSERT_TRUE(rebooted.empty());
+  TEST_ASSERT_EQUAL_INT(flashQueueRetry, rebooted.peek(nullptr, 0));
+}
+
+void test_wraparound_drops_oldest() {
+  FlashQueue q;
+  TEST_ASSERT_TRUE(q.begin(flash, path, slots, slotSize));
+  for (uint32_t i = 0; i < 10; i++) TEST_ASSERT_TRUE(pushNumber(q, i));
+  TEST_ASSERT_EQUAL_UINT32(slots, q.size());
+  TEST_ASSERT_EQUAL_UINT32(6, q.dropped());
+  // The file never grows past its slots
+  TEST_ASSERT_TRUE(flash.bytes(path).size() <= 2 * headerBytes + slots * (slotHeaderBytes + slotSize));
+
+  FlashQueue rebooted;
+  TEST_ASSERT_TRUE(rebooted.begin(flash, path, slots, slotSize));
+  TEST_ASSERT_EQUAL_UINT32(6, rebooted.dropped());
+  for (uint32_t i = 6; i < 10; i++) assertNext(rebooted, i);
+  TEST_ASSERT_TRUE(rebooted.empty());
+
+  // Counters keep running past the slot count
+  for (uint32_t i = 10; i < 13; i++) TEST_ASSERT_TRUE(pushNumber(rebooted, i));
+  for (uint32_t i = 10; i < 13; i++) assertNext(rebooted, i);
+}
+
+void test_oversized_message_is_refused() {
+  FlashQueue q;
+  TEST_ASSERT_TRUE(q.begin(flash, path, slots, slotSize));
+  uint8_t big[slotSize + 1] = {0};
+  TEST_ASSERT_FALSE(q.push(big, sizeof(big)));
+  TEST_ASSERT_TRUE(q.empty());
+}
+
+void test_torn_header_rolls_forward() {
+  FlashQueue q;
+  TEST_ASSERT_TRUE(q.begin(flash, path, slots, slotSize));
+  for (uint32_t i = 0; i < 3; i++) TEST_ASSERT_TRUE(pushNumber(q, i));
+
+  // Power is lost half way through the header write after the slot is done
+  hostWriteBudget = slotHeaderBytes + 5 + headerBytes / 2;
+  TEST_ASSERT_FALSE(pushNumber(q, 3));
+  hostWriteBudget = -1;
+  TEST_ASSERT_EQUAL_UINT32(3, q.size());
+
+  // The other header copy is the checkpoint and the slot is found after it
+  FlashQueue rebooted;
+  TEST_ASSERT_TRUE(rebooted.begin(flash, path, slots, slotSize));
+  TEST_ASSERT_EQUAL_UINT32(4, rebooted.size());
+  TEST_ASSERT_EQUAL_UINT32(0, rebooted.dropped());
+  for (uint32_t i = 0; i < 4; i++) assertNext(rebooted, i);
+}
+
+void test_torn_slot_is_not_counted() {
+  FlashQueue q;
+  TEST_ASSERT_TRUE(q.begin(flash, path, slots, slotSize));
+  for (uint32_t i = 0; i < 2; i++) TEST_ASSERT_TRUE(pushNumber(q, i));
+  hostWriteBudget = slotHeaderBytes + 2;
+  TEST_ASSERT_FALSE(pushNumber(q, 2));
+  hostWriteBudget = -1;
+  TEST_ASSERT_EQUAL_UINT32(2, q.size());
+
+  FlashQueue rebooted;
+  TEST_ASSERT_TRUE(rebooted.begin(flash, path, slots, slotSize));
+  TEST_ASSERT_EQUAL_UINT32(2, rebooted.size());
+  assertNext(rebooted, 0);
+  assertNext(rebooted, 1);
+  TEST_ASSERT_TRUE(rebooted.empty());
+}
+
+void test_failed_push_when_full_does_not_count_a_drop() {
+  FlashQueue q;
+  TEST_ASSERT_TRUE(q.begin(flash, path, slots, slotSize));
+  for (uint32_t i = 0; i < slots; i++) TEST_ASSERT_TRUE(pushNumber(q, i));
+  hostWriteBudget = 0;
+  TEST_ASSERT_FALSE(pushNumber(q, slots));
+  hostWriteBudget = -1;
+  TEST_ASSERT_EQUAL_UINT32(slots, q.size());
+  TEST_ASSERT_EQUAL_UINT32(0, q.dropped());
+}
+
+void test_read_error_keeps_the_message() {
+  FlashQueue q;
+  TEST_ASSERT_TRUE(q.begin(flash, path, slots, slotSize));
+  for (uint32_t i = 0; i < 2; i++) TEST_ASSERT_TRUE(pushNumber(q, i));
+  // The file cannot be opened for a moment
+  std::vector<uint8_t> saved = flash.bytes(path);
+  flash.remove(path);
+  uint8_t buf[slotSize];
+  TEST_ASSERT_EQUAL_INT(flashQueueRetry, q.peek(buf, sizeof(buf)));
+  TEST_ASSERT_EQUAL_UINT32(2, q.size());
+  flash.bytes(path) = saved;
+  assertNext(q, 0);
+  assertNext(q, 1);
+}
+
+void test_corrupt_slot_is_reported_as_bad() {
+  FlashQueue q;
+  TEST_ASSERT_TRUE(q.begin(flash, path, slots, slotSize));
+  for (uint32_t i = 0; i < 2; i++) TEST_ASSERT_TRUE(pushNumber(q, i));
+  // A flipped payload byte in the oldest slot
+  flash.bytes(path)[2 * headerBytes + slotHeaderBytes + 1] ^= 0xFF;
+  uint8_t buf[slotSize];
+  TEST_ASSERT_EQUAL_INT(flashQueueBadSlot, q.peek(buf, sizeof(buf)));
+  TEST_ASSERT_TRUE(q.pop());
+  assertNext(q, 1);
+}
+
+void test_both_headers_corrupt_starts_empty() {
+  FlashQueue q;
+  TEST_ASSERT_TRUE(q.begin(flash, path, slots, slotSize));
+  for (uint32_t i = 0; i < 2; i++) TEST_ASSERT_TRUE(pushNumber(q, i));
+  std::vector<uint8_t>& bytes = flash.bytes(path);
+  bytes[8] ^= 0xFF;
+  bytes[headerBytes + 8] ^= 0xFF;
+
+  FlashQueue rebooted;
+  TEST_ASSERT_TRUE(rebooted.begin(flash, path, slots, slotSize));
+  TEST_ASSERT_TRUE(rebooted.empty());
+}
+
+void test_different_layout_starts_empty() {
+  FlashQueue q;
+  TEST_ASSERT_TRUE(q.begin(flash, path, slots, slotSize));
+  TEST_ASSERT_TRUE(pushNumber(q, 0));
+  FlashQueue resized;
+  TEST_ASSERT_TRUE(resized.begin(flash, path, slots * 2, slotSize));
+  TEST_ASSERT_TRUE(resized.empty());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_fifo_order_survives_reboot);
+  RUN_TEST(test_wraparound_drops_oldest);
+  RUN_TEST(test_oversized_message_is_refused);
+  RUN_TEST(test_torn_header_rolls_forward);
+  RUN_TEST(test_torn_slot_is_not_counted);
+  RUN_TEST(test_failed_push_when_full_does_not_count_a_drop);
+  RUN_TEST(test_read_error_keeps_the_message);
+  RUN_TEST(test_corrupt_slot_is_reported_as_bad);
+  RUN_TEST(test_both_headers_corrupt_starts_empty);
+  RUN_TEST(test_different_layout_starts_empty);
+  return UNITY_END();
+}
@@ -0,0 +1,102 @@
+#include <unity.h>
+
+#include <algorithm>
+#include <math.h>
+#include "hampel.h"
+
+void setUp() {
+  hampelReset();
+}
+
+void tearDown() {}
+
+void test_median_network_on_every_binary_input() {
+  // 0-1 principle: a comparator network that picks the median of every
+  // 0/1 input picks the median of any input
+  for (int bits = 0; bits < 128; bits++) {
+    float v[hampelWindow];
+    int ones = 0;
+    for (int i = 0; i < hampelWindow; i++) {
+      v[i] = (bits >> i) & 1;
+      ones += (bits >> i) & 1;
+    }
+    TEST_ASSERT_EQUAL_FLOAT(ones >= 4 ? 1.0f : 0.0f, hampelMedian7(v));
+  }
+}
+
+void test_median_network_on_every_permutation() {
+  float p[hampelWindow] = {-3.5f, -1.0f, 0.0f, 2.25f, 7.0f, 100.0f, 1e6f};
+  int n = 0;
+  do {
+    float v[hampelWindow];
+    std::copy(p, p + hampelWindow, v);
+    TEST_ASSERT_EQUAL_FLOAT(2.25f, hampelMedian7(v));
+    n++;
+  } while (std::next_permutation(p, p + hampelWindow));
+  TEST_ASSERT_EQUAL_INT(5040, n);
+
+  float ties[hampelWindow] = {5, 1, 5, 5, 1, 9, 1};
+  TEST_ASSERT_EQUAL_FLOAT(5.0f, hampelMedian7(ties));
+}
+
+void test_spike_is_replaced_by_the_median() {
+  for (int i = 0; i < 10; i++) hampelFilter(METRIC_TEMP, 22.0f + (i % 2) * 0.02f);
+  uint32_t before = hampelRejected(METRIC_TEMP);
+  float out = hampelFilter(METRIC_TEMP, 30.0f);
+  TEST_ASSERT_FLOAT_WITHIN(0.021f, 22.01f, out);
+  TEST_ASSERT_EQUAL_UINT32(before + 1, hampelRejected(METRIC_TEMP));
+}
+
+void test_mad_floor_keeps_noise_on_a_flat_signal() {
+  // Readings with almost no spread: the raw MAD is 0, so without the floor
+  // any change at all would count as a spike. The temperature floor of
+  // 0.1 C lets through anything within 3 x 1.4826 x 0.1 = 0.44 C.
+  for (int i = 0; i < hampelWindow; i++) hampelFilter(METRIC_TEMP, 22.0f);
+  uint32_t before = hampelRejected(METRIC_TEMP);
+  TEST_ASSERT_EQUAL_FLOAT(22.4f, hampelFilter(METRIC_TEMP, 22.4f));
+  TEST_ASSERT_EQUAL_FLOAT(21.6f, hampelFilter(METRIC_TEMP, 21.6f));
+  TEST_ASSERT_EQUAL_UINT32(before, hampelRejected(METRIC_TEMP));
+  TEST_ASSERT_EQUAL_FLOAT(22.0f, hampelFilter(METRIC_TEMP, 22.5f));
+  TEST_ASSERT_EQUAL_UINT32(before + 1, hampelRejected(METRIC_TEMP));
+
+  // Each metric has its own floor: 0.5 %RH passes 2 %RH, not 2.5
+  for (int i = 0; i < hampelWindow; i++) hampelFilter(METRIC_HUMIDITY, 45.0f);
+  TEST_ASSERT_EQUAL_FLOAT(47.0f, hampelFilter(METRIC_HUMIDITY, 47.0f));
+  TEST_ASSERT_EQUAL_FLOAT(45.0f, hampelFilter(METRIC_HUMIDITY, 47.5f));
+}
+
+void test_wide_spread_raises_the_threshold_above_the_floor() {
+  // A noisy window (MAD 1 C) lets through a reading 3 C off its median
+  // that the floor alone would reject
+  const float noisy[hampelWindow] = {20, 22, 19, 21, 23, 20, 22};
+  for (float v : noisy) hampelFilter(METRIC_TEMP, v);
+  TEST_ASSERT_EQUAL_FLOAT(25.0f, hampelFilter(METRIC_TEMP, 25.0f));
+}
+
+void test_step_passes_after_half_a_window() {
+  for (int i = 0; i < hampelWindow; i++) hampelFilter(METRIC_PRESSURE, 1000.0f);
+  int held = 0;
+  while (hampelFilter(METRIC_PRESSURE, 1005.0f) != 1005.0f) held++;
+  TEST_ASSERT_EQUAL_INT(hampelWindow / 2, held);
+}
+
+void test_nan_is_counted_and_never_enters_the_window() {
+  TEST_ASSERT_TRUE(isnan(hampelFilter(METRIC_PRESSURE, NAN)));  // Nothing to fall back on
+  for (int i = 0; i < hampelWindow; i++) hampelFilter(METRIC_PRESSURE, 1000.0f);
+  uint32_t before = hampelRejected(METRIC_PRESSURE);
+  for (int i = 0; i < 10; i++) TEST_ASSERT_EQUAL_FLOAT(1000.0f, hampelFilter(METRIC_PRESSURE, NAN));
+  TEST_ASSERT_EQUAL_UINT32(before + 10, hampelRejected(METRIC_PRESSURE));
+  TEST_ASSERT_EQUAL_FLOAT(1000.1f, hampelFilter(METRIC_PRESSURE, 1000.1f));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_median_network_on_every_binary_input);
+  RUN_TEST(test_median_network_on_every_permutation);
+  RUN_TEST(test_spike_is_replaced_by_the_median);
+  RUN_TEST(test_mad_floor_keeps_noise_on_a_flat_signal);
+  RUN_TEST(test_wide_spread_raises_the_threshold_above_the_floor);
+  RUN_TEST(test_step_passes_after_half_a_window);
+  RUN_TEST(test_nan_is_counted_and_never_enters_the_window);
+  return UNITY_END();
+}
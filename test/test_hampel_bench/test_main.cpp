@@ -0,0 +1,89 @@
+#include <unity.h>
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include "hampel.h"
+
+/*
+ * hampelFilter() against the same filter written the obvious way (copy the
+ * window, std::sort it twice), on a noisy series with spikes. Prints host
+ * ns per reading; the point is the ratio and the fixed cost, since the
+ * network's 32 compare-exchanges take the same time on any input.
+ */
+
+static const int readings = 200000;
+static float series[readings];
+
+static void makeSeries() {
+  uint32_t seed = 99;
+  for (int i = 0; i < readings; i++) {
+    seed = seed * 1664525u + 1013904223u;
+    float noise = ((seed >> 8) / 16777216.0f - 0.5f) * 0.1f;
+    series[i] = 22.0f + sinf(i / 500.0f) + noise;
+    if (seed % 97 == 0) series[i] += 8.0f;  // About 1 % spikes
+  }
+}
+
+// Reference: same window, threshold and floor as the temperature filter
+struct SortedHampel {
+  float window[hampelWindow];
+  int next = 0;
+  bool primed = false;
+
+  float filter(float raw) {
+    if (!primed) std::fill(window, window + hampelWindow, raw);
+    primed = true;
+    window[next] = raw;
+    next = (next + 1) % hampelWindow;
+    float v[hampelWindow];
+    std::copy(window, window + hampelWindow, v);
+    std::sort(v, v + hampelWindow);
+    float median = v[hampelWindow / 2];
+    for (int i = 0; i < hampelWindow; i++) v[i] = fabsf(window[i] - median);
+    std::sort(v, v + hampelWindow);
+    float sigma = 1.4826f * fmaxf(v[hampelWindow / 2], 0.1f);
+    return fabsf(raw - median) > hampelSigmas * sigma ? median : raw;
+  }
+};
+
+template <typename Fn>
+static double nsPerReading(Fn fn) {
+  auto start = std::chrono::steady_clock::now();
+  fn();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() / readings;
+}
+
+void setUp() {
+  hampelReset();
+}
+
+void tearDown() {}
+
+void test_network_against_sort() {
+  makeSeries();
+  static float network[readings];
+  static float sorted[readings];
+  SortedHampel reference;
+  double networkNs = nsPerReading([] {
+    for (int i = 0; i < readings; i++) network[i] = hampelFilter(METRIC_TEMP, series[i]);
+  });
+  double sortNs = nsPerReading([&] {
+    for (int i = 0; i < readings; i++) sorted[i] = reference.filter(series[i]);
+  });
+  printf("\n  hampelFilter %.1f ns/reading, std::sort version %.1f ns/reading, %lu spikes\n",
+         networkNs, sortNs, (unsigned long)hampelRejected(METRIC_TEMP));
+  // Same answers on every reading
+  int differ = 0;
+  for (int i = 0; i < readings; i++) differ += sorted[i] != network[i];
+  TEST_ASSERT_EQUAL_INT(0, differ);
+  TEST_ASSERT_TRUE(hampelRejected(METRIC_TEMP) > readings / 200);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_network_against_sort);
+  return UNITY_END();
+}
@@ -0,0 +1,187 @@
+#include <unity.h>
+
+#include <string>
+#include "HTTPClient.h"
+#include "history.h"
+#include "wallclock.h"
+#include "wifi_link.h"
+
+// Built here with uploads enabled; the native build leaves them out
+#define ENABLE_INFLUX 1
+#define INFLUX_URL "http://influx.test:8086/api/v2/write?org=lab&bucket=env&precision=s"
+#define INFLUX_TOKEN "secret"
+#include "../../src/influx_writer.cpp"
+
+static const uint32_t bootTime = 1700000000;
+static bool clockIsSet = true;
+static WifiLinkState linkState = WIFI_LINK_UP;
+static int holders = 0;
+
+bool clockValid() { return clockIsSet; }
+uint32_t clockFromUptime(uint32_t uptimeSec) { return bootTime + uptimeSec; }
+void wifiAcquire() { holders++; }
+void wifiRelease() { holders--; }
+void wifiPoll() {}
+WifiLinkState wifiState() { return linkState; }
+
+// One bin per 30 s for each metric, as the sensor loop records them
+static void addBins(uint32_t from, int count) {
+  for (int i = 0; i < count; i++) {
+    uint32_t t = (from + i) * 30;
+    historyAdd(METRIC_TEMP, t, 20.0f + (from + i) * 0.01f);
+    historyAdd(METRIC_HUMIDITY, t, 45.0f);
+    if (t % 300 == 0) historyAdd(METRIC_PRESSURE, t, 1005.0f);
+  }
+  hostMillis = ((from + count - 1) * 30 + 1) * 1000UL;
+}
+
+static int countLines(const std::string& body) {
+  int n = 0;
+  for (char c : body) n += c == '\n';
+  return n;
+}
+
+// Unix timestamps of every line in every request, in order
+static std::vector<uint32_t> uploadedTimes() {
+  std::vector<uint32_t> times;
+  for (const HostHttpRequest& r : hostHttpRequests) {
+    size_t start = 0;
+    while (start < r.body.size()) {
+      size_t end = r.body.find('\n', start);
+      size_t space = r.body.rfind(' ', end);
+      times.push_back(strtoul(r.body.c_str() + space + 1, nullptr, 10));
+      start = end + 1;
+    }
+  }
+  return times;
+}
+
+void setUp() {
+  historyClear();
+  hostHttpRequests.clear();
+  hostHttpStatus = 204;
+  hostMillis = 0;
+  clockIsSet = true;
+  linkState = WIFI_LINK_UP;
+  holders = 0;
+  batchLen = 0;
+  linkHeld = false;
+  failedOnce = false;
+  influxBegin();
+}
+
+void tearDown() {}
+
+void test_waits_for_the_clock() {
+  clockIsSet = false;
+  addBins(0, 40);
+  hostMillis += INFLUX_FLUSH_AGE_MS;
+  influxPoll();
+  TEST_ASSERT_EQUAL(0, hostHttpRequests.size());
+  TEST_ASSERT_EQUAL_INT(0, holders);
+}
+
+void test_partial_batch_is_sent_once_old_enough() {
+  addBins(0, 5);
+  influxPoll();
+  TEST_ASSERT_EQUAL(0, hostHttpRequests.size());
+  TEST_ASSERT_EQUAL_INT(0, holders);
+
+  hostMillis = INFLUX_FLUSH_AGE_MS;
+  influxPoll();
+  TEST_ASSERT_EQUAL(1, hostHttpRequests.size());
+  const HostHttpRequest& r = hostHttpRequests[0];
+  TEST_ASSERT_EQUAL_STRING(INFLUX_URL, r.url.c_str());
+  TEST_ASSERT_EQUAL_INT(5, countLines(r.body));
+  TEST_ASSERT_EQUAL(0, r.body.find("environment,device=cardenv temp=20.00,humidity=45.00,pressure=1005.00,"));
+  bool auth = false;
+  for (const std::string& h : r.headers) auth |= h == "Authorization: Token secret";
+  TEST_ASSERT_TRUE(auth);
+  // Connect and response waits are set explicitly and fit, with a DNS
+  // lookup that gets no answer, well inside LOOP_HANG_MS
+  TEST_ASSERT_EQUAL_INT32(2000, r.connectTimeoutMs);
+  TEST_ASSERT_EQUAL_UINT16(3000, r.timeoutMs);
+  TEST_ASSERT_TRUE(14000 + r.connectTimeoutMs + r.timeoutMs < LOOP_HANG_MS * 3 / 4);
+
+  std::vector<uint32_t> times = uploadedTimes();
+  for (int i = 0; i < 5; i++) TEST_ASSERT_EQUAL_UINT32(bootTime + i * 30, times[i]);
+
+  // Nothing new: the link is let go and nothing is resent
+  influxPoll();
+  TEST_ASSERT_EQUAL(1, hostHttpRequests.size());
+  TEST_ASSERT_EQUAL_INT(0, holders);
+}
+
+void test_backlog_drains_in_full_batches_without_gaps() {
+  const int bins = 300;
+  addBins(0, bins);
+  for (int poll = 0; poll < 20; poll++) influxPoll();
+  hostMillis += INFLUX_FLUSH_AGE_MS;
+  influxPoll();
+  TEST_ASSERT_TRUE(hostHttpRequests.size() >= 2);
+  for (size_t i = 0; i + 1 < hostHttpRequests.size(); i++) {
+    TEST_ASSERT_TRUE(hostHttpRequests[i].body.size() <= batchMax);
+    TEST_ASSERT_TRUE(hostHttpRequests[i].body.size() > batchMax - 128);
+  }
+  std::vector<uint32_t> times = uploadedTimes();
+  TEST_ASSERT_EQUAL(bins, times.size());
+  for (int i = 0; i < bins; i++) TEST_ASSERT_EQUAL_UINT32(bootTime + i * 30, times[i]);
+}
+
+void test_failed_post_is_retried_after_delay() {
+  addBins(0, 5);
+  hostMillis = INFLUX_FLUSH_AGE_MS;
+  hostHttpStatus = 500;
+  influxPoll();
+  TEST_ASSERT_EQUAL(1, hostHttpRequests.size());
+
+  hostHttpStatus = 204;
+  hostMillis += retryDelay - 1;
+  influxPoll();
+  TEST_ASSERT_EQUAL(1, hostHttpRequests.size());
+
+  hostMillis += 1;
+  influxPoll();
+  TEST_ASSERT_EQUAL(2, hostHttpRequests.size());
+  TEST_ASSERT_TRUE(hostHttpRequests[0].body == hostHttpRequests[1].body);
+}
+
+void test_link_failure_releases_and_backs_off() {
+  addBins(0, 5);
+  hostMillis = INFLUX_FLUSH_AGE_MS;
+  linkState = WIFI_LINK_CONNECTING;
+  influxPoll();
+  TEST_ASSERT_EQUAL_INT(1, holders);
+  linkState = WIFI_LINK_FAILED;
+  influxPoll();
+  TEST_ASSERT_EQUAL_INT(0, holders);
+
+  linkState = WIFI_LINK_UP;
+  influxPoll();
+  TEST_ASSERT_EQUAL(0, hostHttpRequests.size());
+  hostMillis += retryDelay;
+  influxPoll();
+  TEST_ASSERT_EQUAL(1, hostHttpRequests.size());
+}
+
+void test_bins_lost_before_upload_are_skipped() {
+  addBins(0, historySizes[METRIC_TEMP] + 50);
+  for (int poll = 0; poll < 200; poll++) influxPoll();
+  hostMillis += INFLUX_FLUSH_AGE_MS;  // The tail goes once it is old enough
+  influxPoll();
+  std::vector<uint32_t> times = uploadedTimes();
+  // influxBegin() pointed at bin 0; the first 50 were overwritten
+  TEST_ASSERT_EQUAL(historySizes[METRIC_TEMP], times.size());
+  TEST_ASSERT_EQUAL_UINT32(bootTime + 50 * 30, times.front());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_waits_for_the_clock);
+  RUN_TEST(test_partial_batch_is_sent_once_old_enough);
+  RUN_TEST(test_backlog_drains_in_full_batches_without_gaps);
+  RUN_TEST(test_failed_post_is_retried_after_delay);
+  RUN_TEST(test_link_failure_releases_and_backs_off);
+  RUN_TEST(test_bins_lost_before_upload_are_skipped);
+  return UNITY_END();
+}
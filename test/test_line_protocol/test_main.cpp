@@ -0,0 +1,89 @@
+#include <unity.h>
+
+#include <stdio.h>
+#include <string.h>
+#include "line_protocol.h"
+
+void setUp() {}
+void tearDown() {}
+
+static const char* series = "environment,device=cardenv";
+
+void test_dew_point_matches_magnus() {
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 9.255f, dewPoint(20.0f, 50.0f));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, -8.405f, dewPoint(-5.5f, 80.0f));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 28.178f, dewPoint(30.0f, 90.0f));
+  // Zero humidity is clamped instead of taking log(0)
+  TEST_ASSERT_FALSE(isinf(dewPoint(20.0f, 0.0f)));
+}
+
+void test_line_format() {
+  char buf[256];
+  size_t len = lineProtocolAppend(buf, 0, sizeof(buf), series, 1700000000, 20.0f, 50.0f, 1013.25f);
+  buf[len] = '\0';
+  TEST_ASSERT_EQUAL_STRING(
+      "environment,device=cardenv temp=20.00,humidity=50.00,pressure=1013.25,dewpoint=9.26 1700000000\n",
+      buf);
+}
+
+void test_negative_and_rounded_values() {
+  char buf[256];
+  size_t len = lineProtocolAppend(buf, 0, sizeof(buf), "s", 0, -5.5f, 60.004f, 999.996f);
+  buf[len] = '\0';
+  TEST_ASSERT_EQUAL_STRING("s temp=-5.50,humidity=60.00,pressure=1000.00,dewpoint=-12.05 0\n", buf);
+}
+
+void test_fields_are_within_half_a_hundredth() {
+  char buf[256];
+  for (int i = 0; i < 2000; i++) {
+    float v[3] = {-40.0f + i * 0.0437f, 5.0f + i * 0.0471f, 900.0f + i * 0.0913f};
+    size_t len = lineProtocolAppend(buf, 0, sizeof(buf), "s", i, v[0], v[1], v[2]);
+    buf[len] = '\0';
+    float parsed[4];
+    unsigned long time;
+    TEST_ASSERT_EQUAL_INT(5, sscanf(buf, "s temp=%f,humidity=%f,pressure=%f,dewpoint=%f %lu",
+                                    &parsed[0], &parsed[1], &parsed[2], &parsed[3], &time));
+    for (int f = 0; f < 3; f++) TEST_ASSERT_FLOAT_WITHIN(0.0051f, v[f], parsed[f]);
+    TEST_ASSERT_FLOAT_WITHIN(0.0051f, dewPoint(v[0], v[1]), parsed[3]);
+    TEST_ASSERT_EQUAL_UINT32(i, time);
+  }
+}
+
+void test_appends_until_full() {
+  char buf[300];
+  size_t len = 0;
+  int lines = 0;
+  for (;;) {
+    size_t next = lineProtocolAppend(buf, len, sizeof(buf), series, 1700000000 + lines, 21.0f, 45.0f, 1000.0f);
+    if (next == len) break;
+    TEST_ASSERT_EQUAL_HEX8('\n', buf[next - 1]);
+    len = next;
+    lines++;
+  }
+  TEST_ASSERT_EQUAL_INT(3, lines);
+  TEST_ASSERT_TRUE(len <= sizeof(buf));
+  TEST_ASSERT_EQUAL_MEMORY(series, buf, strlen(series));
+}
+
+void test_overlong_series_is_refused() {
+  char name[100];
+  memset(name, 'x', sizeof(name) - 1);
+  name[sizeof(name) - 1] = '\0';
+  char buf[512];
+  TEST_ASSERT_EQUAL(7, lineProtocolAppend(buf, 7, sizeof(buf), name, 0, 20.0f, 50.0f, 1000.0f));
+  // The longest allowed series still fits
+  name[lineProtocolSeriesMax] = '\0';
+  TEST_ASSERT_TRUE(lineProtocolAppend(buf, 0, sizeof(buf), name, 0, 20.0f, 50.0f, 1000.0f) >
+                   lineProtocolSeriesMax);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_dew_point_matches_magnus);
+  RUN_TEST(test_line_format);
+  RUN_TEST(test_negative_and_rounded_values);
+  RUN_TEST(test_fields_are_within_half_a_hundredth);
+  RUN_TEST(test_appends_until_full);
+  RUN_TEST(test_overlong_series_is_refused);
+  return UNITY_END();
+}
@@ -0,0 +1,164 @@
+#include <unity.h>
+
+#include <string>
+#include "history.h"
+#include "serial_proto.h"
+#include "wifi_link.h"
+
+// Built here with the endpoint enabled; the native build leaves it out
+#define ENABLE_METRICS 1
+#include "../../src/metrics_server.cpp"
+
+static WifiLinkState linkState = WIFI_LINK_UP;
+static uint32_t rxFrames = 0;
+
+void wifiAcquire() {}
+void wifiRelease() {}
+void wifiPoll() {}
+WifiLinkState wifiState() { return linkState; }
+
+void protoFillStats(ProtoStats& s) {
+  memset(&s, 0, sizeof(s));
+  s.freeHeap = 200 * 1024;
+  s.rxFrames = rxFrames;
+}
+
+static const MetricsInputs indoor = {21.5f, 40.0f, 1013.2f, 80, false};
+
+// Polls until the connection is closed; returns the number of polls
+static int serve(const MetricsInputs& inputs, int limit = 100) {
+  int polls = 0;
+  while (polls < limit) {
+    metricsPoll(inputs);
+    polls++;
+    if (clientState == CLIENT_NONE && server.pending.empty()) break;
+  }
+  return polls;
+}
+
+static std::string scrape(const MetricsInputs& inputs, const char* path = "/metrics") {
+  auto c = server.connect(std::string("GET ") + path + " HTTP/1.1\r\nHost: cardenv\r\n\r\n");
+  serve(inputs);
+  TEST_ASSERT_TRUE(c->stopped);
+  return c->sent;
+}
+
+static std::string body(const std::string& response) {
+  size_t end = response.find("\r\n\r\n");
+  TEST_ASSERT_TRUE(end != std::string::npos);
+  return response.substr(end + 4);
+}
+
+void setUp() {
+  historyClear();
+  linkState = WIFI_LINK_UP;
+  rxFrames = 0;
+  hostMillis = 0;
+  everRendered = false;
+}
+
+void tearDown() {}
+
+void test_scrape_returns_current_readings() {
+  std::string response = scrape(indoor);
+  TEST_ASSERT_EQUAL(0, response.find("HTTP/1.1 200 OK\r\n"));
+  std::string b = body(response);
+  char length[40];
+  snprintf(length, sizeof(length), "Content-Length: %u\r\n", (unsigned)b.size());
+  TEST_ASSERT_TRUE(response.find(length) != std::string::npos);
+  TEST_ASSERT_TRUE(b.find("cardenv_temperature_celsius 21.50\n") != std::string::npos);
+  TEST_ASSERT_TRUE(b.find("cardenv_pressure_hpa 1013.20\n") != std::string::npos);
+  TEST_ASSERT_TRUE(b.find("cardenv_free_heap_kb 200.00\n") != std::string::npos);
+  TEST_ASSERT_TRUE(b.find("# TYPE cardenv_serial_rx_frames_total counter\n") != std::string::npos);
+  // No history yet, so no aggregates
+  TEST_ASSERT_TRUE(b.find("cardenv_history_min") == std::string::npos);
+}
+
+void test_unchanged_inputs_reuse_the_rendered_body() {
+  std::string first = scrape(indoor);
+  uint32_t renders = renderCount;
+  std::string second = scrape(indoor);
+  TEST_ASSERT_EQUAL_UINT32(renders, renderCount);
+  TEST_ASSERT_TRUE(first == second);
+
+  rxFrames++;
+  std::string third = scrape(indoor);
+  TEST_ASSERT_EQUAL_UINT32(renders + 1, renderCount);
+  TEST_ASSERT_TRUE(third.find("cardenv_serial_rx_frames_total 1\n") != std::string::npos);
+
+  MetricsInputs warmer = indoor;
+  warmer.temp = 22.0f;
+  TEST_ASSERT_TRUE(body(scrape(warmer)).find("cardenv_temperature_celsius 22.00\n") != std::string::npos);
+  TEST_ASSERT_EQUAL_UINT32(renders + 2, renderCount);
+}
+
+void test_polls_without_scrapes_do_not_render() {
+  scrape(indoor);
+  uint32_t renders = renderCount;
+  MetricsInputs changing = indoor;
+  for (int i = 0; i < 100; i++) {
+    changing.temp += 0.01f;
+    metricsPoll(changing);
+  }
+  TEST_ASSERT_EQUAL_UINT32(renders, renderCount);
+}
+
+void test_history_aggregates() {
+  for (int i = 0; i < 10; i++) {
+    historyAdd(METRIC_TEMP, i * 30, 20.0f + i);
+    historyAdd(METRIC_HUMIDITY, i * 30, 50.0f);
+  }
+  historyAdd(METRIC_PRESSURE, 0, 1000.0f);
+  std::string b = body(scrape(indoor));
+  TEST_ASSERT_TRUE(b.find("cardenv_history_min{metric=\"temperature\"} 20.00\n") != std::string::npos);
+  TEST_ASSERT_TRUE(b.find("cardenv_history_max{metric=\"temperature\"} 29.00\n") != std::string::npos);
+  TEST_ASSERT_TRUE(b.find("cardenv_history_mean{metric=\"temperature\"} 24.50\n") != std::string::npos);
+  TEST_ASSERT_TRUE(b.find("cardenv_history_mean{metric=\"pressure\"} 1000.00\n") != std::string::npos);
+}
+
+void test_response_is_written_in_chunks_as_the_socket_accepts() {
+  std::string expected = scrape(indoor);
+  auto c = server.connect("GET /metrics HTTP/1.1\r\n\r\n");
+  c->writeRoom = 100;
+  int polls = serve(indoor);
+  TEST_ASSERT_TRUE(c->sent == expected);
+  // Accept, request, then one poll per 100 bytes
+  TEST_ASSERT_TRUE(polls >= (int)expected.size() / 100);
+}
+
+void test_other_paths_get_404() {
+  std::string response = scrape(indoor, "/");
+  TEST_ASSERT_EQUAL(0, response.find("HTTP/1.1 404 Not Found\r\n"));
+}
+
+void test_stalled_request_times_out() {
+  auto c = server.connect("GET /metrics HTTP/1.1\r\n");  // Headers never end
+  metricsPoll(indoor);
+  metricsPoll(indoor);
+  TEST_ASSERT_FALSE(c->stopped);
+  hostMillis += clientTimeout;
+  metricsPoll(indoor);
+  TEST_ASSERT_TRUE(c->stopped);
+  TEST_ASSERT_EQUAL(0, c->sent.size());
+}
+
+void test_link_down_closes_client() {
+  auto c = server.connect("GET /metrics HTTP/1.1\r\n");
+  metricsPoll(indoor);
+  linkState = WIFI_LINK_CONNECTING;
+  metricsPoll(indoor);
+  TEST_ASSERT_TRUE(c->stopped);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_scrape_returns_current_readings);
+  RUN_TEST(test_unchanged_inputs_reuse_the_rendered_body);
+  RUN_TEST(test_polls_without_scrapes_do_not_render);
+  RUN_TEST(test_history_aggregates);
+  RUN_TEST(test_response_is_written_in_chunks_as_the_socket_accepts);
+  RUN_TEST(test_other_paths_get_404);
+  RUN_TEST(test_stalled_request_times_out);
+  RUN_TEST(test_link_down_closes_client);
+  return UNITY_END();
+}
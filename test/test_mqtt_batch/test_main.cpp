@@ -0,0 +1,165 @@
+#include <unity.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "history.h"
+#include "mqtt_batch.h"
+
+static const int cap = 1000;  // The publisher's batchMax
+
+struct Bin {
+  unsigned long time;
+  float temp, humidity, pressure;
+};
+
+struct Batch {
+  bool ok;  // Parsed to the closing "]}" and nothing after it
+  unsigned long up, ts;
+  float temp, humidity, pressure;
+  std::vector<Bin> bins;
+};
+
+static Batch decode(const uint8_t* buf, int len) {
+  std::string text((const char*)buf, len);
+  Batch b = {};
+  int n = 0;
+  if (sscanf(text.c_str(), "{\"up\":%lu,\"ts\":%lu,\"temp\":%f,\"hum\":%f,\"press\":%f,\"bins\":[%n",
+             &b.up, &b.ts, &b.temp, &b.humidity, &b.pressure, &n) != 5 || n == 0) {
+    return b;
+  }
+  const char* p = text.c_str() + n;
+  while (*p == '[') {
+    Bin bin;
+    int m = 0;
+    if (sscanf(p, "[%lu,%f,%f,%f]%n", &bin.time, &bin.temp, &bin.humidity, &bin.pressure, &m) != 4 ||
+        m == 0) {
+      return b;
+    }
+    b.bins.push_back(bin);
+    p += m;
+    if (*p == ',') p++;
+  }
+  b.ok = strcmp(p, "]}") == 0;
+  return b;
+}
+
+// Temperature and humidity every 30 s, pressure every 5 min, from second 0
+static void fillHistory(int bins) {
+  for (int i = 0; i < bins; i++) {
+    uint32_t t = i * 30;
+    historyAdd(METRIC_TEMP, t, 20.0f + (i % 50) * 0.01f);
+    historyAdd(METRIC_HUMIDITY, t, 40.0f + (i % 7) * 0.5f);
+    if (i % 10 == 0) historyAdd(METRIC_PRESSURE, t, 1000.0f + (i / 10) * 0.25f);
+  }
+}
+
+void setUp() {
+  historyClear();
+}
+
+void tearDown() {}
+
+void test_batch_decodes_to_the_history_bins() {
+  fillHistory(20);
+  uint8_t buf[cap];
+  uint32_t nextSeq = 0;
+  int len = mqttBuildBatch(buf, cap, nextSeq, 600, 1700000000, 21.5f, 45.25f, 1013.2f);
+  TEST_ASSERT_TRUE(len <= cap);
+  Batch b = decode(buf, len);
+  TEST_ASSERT_TRUE(b.ok);
+  TEST_ASSERT_EQUAL_UINT32(600, b.up);
+  TEST_ASSERT_EQUAL_UINT32(1700000000, b.ts);
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, 21.5f, b.temp);
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, 45.25f, b.humidity);
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, 1013.2f, b.pressure);
+
+  TEST_ASSERT_EQUAL(20, b.bins.size());
+  for (int i = 0; i < 20; i++) {
+    const Bin& bin = b.bins[i];
+    TEST_ASSERT_EQUAL_UINT32(i * 30, bin.time);
+    TEST_ASSERT_FLOAT_WITHIN(0.005f, historyValue(METRIC_TEMP, i), bin.temp);
+    TEST_ASSERT_FLOAT_WITHIN(0.005f, historyValue(METRIC_HUMIDITY, i), bin.humidity);
+    // The 5 min pressure bin at or before the temperature bin
+    TEST_ASSERT_FLOAT_WITHIN(0.005f, 1000.0f + (i / 10) * 0.25f, bin.pressure);
+  }
+  TEST_ASSERT_EQUAL_UINT32(historySeq(METRIC_TEMP), nextSeq);
+
+  // Nothing new: the next batch has the reading only
+  len = mqttBuildBatch(buf, cap, nextSeq, 630, 1700000030, 21.5f, 45.25f, 1013.2f);
+  b = decode(buf, len);
+  TEST_ASSERT_TRUE(b.ok);
+  TEST_ASSERT_EQUAL(0, b.bins.size());
+}
+
+void test_backlog_is_split_across_batches_without_gaps() {
+  fillHistory(500);
+  uint8_t buf[cap];
+  uint32_t nextSeq = 0;
+  std::vector<Bin> all;
+  int batches = 0;
+  while (nextSeq < historySeq(METRIC_TEMP)) {
+    int len = mqttBuildBatch(buf, cap, nextSeq, 15000, 0, 20, 40, 1000);
+    TEST_ASSERT_TRUE(len <= cap);
+    Batch b = decode(buf, len);
+    TEST_ASSERT_TRUE(b.ok);
+    TEST_ASSERT_TRUE(b.bins.size() > 0);
+    all.insert(all.end(), b.bins.begin(), b.bins.end());
+    batches++;
+  }
+  TEST_ASSERT_TRUE(batches > 1);
+  TEST_ASSERT_EQUAL(500, all.size());
+  for (int i = 0; i < 500; i++) TEST_ASSERT_EQUAL_UINT32(i * 30, all[i].time);
+}
+
+void test_bins_gone_from_the_ring_are_skipped() {
+  fillHistory(historySizes[METRIC_TEMP] + 100);
+  uint8_t buf[cap];
+  uint32_t nextSeq = 0;
+  int len = mqttBuildBatch(buf, cap, nextSeq, 0, 0, 20, 40, 1000);
+  Batch b = decode(buf, len);
+  TEST_ASSERT_TRUE(b.ok);
+  // Starts at the oldest bin still held
+  TEST_ASSERT_EQUAL_UINT32(100 * 30, b.bins[0].time);
+  uint32_t oldestSeq = historySeq(METRIC_TEMP) - historyCount(METRIC_TEMP);
+  TEST_ASSERT_EQUAL_UINT32(oldestSeq + b.bins.size(), nextSeq);
+}
+
+void test_one_batch_per_interval_opens_the_window_once() {
+  MqttSchedule s = {300000, 30000, 0, false, 0};
+  TEST_ASSERT_FALSE(mqttBatchDue(s, 299999));
+  TEST_ASSERT_EQUAL(MQTT_WINDOW_IDLE, mqttWindowStep(s, 299999, false, WIFI_LINK_OFF));
+
+  TEST_ASSERT_TRUE(mqttBatchDue(s, 300000));
+  TEST_ASSERT_TRUE(s.windowOpen);
+  TEST_ASSERT_EQUAL_UINT32(300000, s.windowStart);
+  TEST_ASSERT_FALSE(mqttBatchDue(s, 300050));
+
+  // A batch due while the window is still open leaves its start alone
+  s.lastBatch = 0;
+  TEST_ASSERT_TRUE(mqttBatchDue(s, 310000));
+  TEST_ASSERT_EQUAL_UINT32(300000, s.windowStart);
+  TEST_ASSERT_EQUAL_UINT32(310000, s.lastBatch);
+}
+
+void test_window_steps() {
+  MqttSchedule s = {300000, 30000, 0, false, 0};
+  TEST_ASSERT_TRUE(mqttBatchDue(s, 300000));
+  TEST_ASSERT_EQUAL(MQTT_WINDOW_WAIT, mqttWindowStep(s, 301000, false, WIFI_LINK_CONNECTING));
+  TEST_ASSERT_EQUAL(MQTT_WINDOW_SEND, mqttWindowStep(s, 305000, false, WIFI_LINK_UP));
+  // Drained, out of time, or no Wi-Fi to be had
+  TEST_ASSERT_EQUAL(MQTT_WINDOW_CLOSE, mqttWindowStep(s, 305000, true, WIFI_LINK_UP));
+  TEST_ASSERT_EQUAL(MQTT_WINDOW_CLOSE, mqttWindowStep(s, 330000, false, WIFI_LINK_UP));
+  TEST_ASSERT_EQUAL(MQTT_WINDOW_CLOSE, mqttWindowStep(s, 301000, false, WIFI_LINK_FAILED));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_batch_decodes_to_the_history_bins);
+  RUN_TEST(test_backlog_is_split_across_batches_without_gaps);
+  RUN_TEST(test_bins_gone_from_the_ring_are_skipped);
+  RUN_TEST(test_one_batch_per_interval_opens_the_window_once);
+  RUN_TEST(test_window_steps);
+  return UNITY_END();
+}
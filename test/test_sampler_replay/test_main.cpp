@@ -0,0 +1,117 @@
+#include <unity.h>
+
+#include <math.h>
+#include <stdio.h>
+#include "adaptive_sampler.h"
+
+/*
+ * Host replay of the adaptive sampler: 24 h of simulated room temperature
+ * at 1 s resolution (daily drift, HVAC cycles, door openings, sensor
+ * noise), read whenever the sampler's interval is up, against reading every
+ * second. Readings are held until the next one, as the firmware does, and
+ * the error is the held value against the true one, every second. Prints
+ * reads per hour and the RMS and worst error for both.
+ */
+
+static const int day = 86400;
+static uint32_t seed;
+
+static float uniform() {
+  seed = seed * 1664525u + 1013904223u;
+  return ((seed >> 8) + 0.5f) / 16777216.0f;
+}
+
+static float gaussian(float sd) {
+  float u1 = uniform(), u2 = uniform();
+  return sd * sqrtf(-2.0f * logf(u1)) * cosf(6.2831853f * u2);
+}
+
+// True temperature at second t
+static float room(int t) {
+  float v = 21.0f + 1.5f * sinf(6.2831853f * (t - 6 * 3600) / day);
+  // Heating runs 5 of every 20 minutes during the day: +0.4 C, then decays
+  if (t > 7 * 3600 && t < 22 * 3600) {
+    int phase = t % 1200;
+    v += phase < 300 ? 0.4f * phase / 300 : 0.4f * expf(-(phase - 300) / 240.0f);
+  }
+  // A door opened for a minute at a few times of day: -1 C, recovering
+  static const int doors[] = {8 * 3600 + 600, 12 * 3600 + 1800, 17 * 3600 + 300, 19 * 3600 + 2400};
+  for (int d : doors) {
+    if (t >= d && t < d + 60) v -= 1.0f * (t - d) / 60;
+    else if (t >= d + 60) v -= 1.0f * expf(-(t - d - 60) / 300.0f);
+  }
+  return v;
+}
+
+struct Result {
+  long reads;
+  double rmsError;
+  float worstError;
+};
+
+static Result replay(bool adaptive) {
+  seed = 4242;
+  samplerSetBounds(METRIC_TEMP, 1000, 15000);
+  Result r = {0, 0, 0};
+  float held = 0;
+  long lastRead = -1000000;
+  double sq = 0;
+  for (int t = 0; t < day; t++) {
+    float truth = room(t);
+    if (!adaptive || (t - lastRead) * 1000L >= (long)samplerIntervalMs(METRIC_TEMP)) {
+      held = truth + gaussian(0.015f);
+      samplerAdd(METRIC_TEMP, held);
+      lastRead = t;
+      r.reads++;
+    }
+    float error = fabsf(held - truth);
+    sq += (double)error * error;
+    if (error > r.worstError) r.worstError = error;
+  }
+  r.rmsError = sqrt(sq / day);
+  return r;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_adaptive_against_fixed_rate() {
+  Result fixed = replay(false);
+  Result adaptive = replay(true);
+  printf("\n  fixed 1 s: %ld reads/h, RMS error %.3f C, worst %.3f C\n", fixed.reads / 24,
+         fixed.rmsError, fixed.worstError);
+  printf("  adaptive:  %ld reads/h, RMS error %.3f C, worst %.3f C\n", adaptive.reads / 24,
+         adaptive.rmsError, adaptive.worstError);
+  // A small fraction of the reads (and I2C transfers) for an error that
+  // stays well inside one display step
+  TEST_ASSERT_TRUE(adaptive.reads * 5 < fixed.reads);
+  TEST_ASSERT_TRUE(adaptive.rmsError < 0.05);
+  // At worst, one slow interval of a door opening before the sampler sees it
+  TEST_ASSERT_TRUE(adaptive.worstError < 0.3f);
+}
+
+void test_intervals_stay_within_bounds() {
+  // Pressure with the low-power profile: never faster than its 10 s period
+  samplerSetBounds(METRIC_PRESSURE, 10000, 60000);
+  seed = 1;
+  uint32_t lo = UINT32_MAX, hi = 0;
+  for (int i = 0; i < 2000; i++) {
+    // Flat, then a lift ride (3 hPa over a few readings), then flat again
+    float v = 1013.0f + gaussian(0.03f) + (i > 1000 && i < 1006 ? (i - 1000) * 0.6f : 0) +
+              (i >= 1006 ? 3.0f : 0);
+    samplerAdd(METRIC_PRESSURE, v);
+    uint32_t interval = samplerIntervalMs(METRIC_PRESSURE);
+    if (interval < lo) lo = interval;
+    if (interval > hi) hi = interval;
+    if (i == 1002) TEST_ASSERT_EQUAL_UINT32(10000, interval);  // Back to the fast bound
+  }
+  TEST_ASSERT_EQUAL_UINT32(10000, lo);
+  TEST_ASSERT_EQUAL_UINT32(60000, hi);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_adaptive_against_fixed_rate);
+  RUN_TEST(test_intervals_stay_within_bounds);
+  return UNITY_END();
+}
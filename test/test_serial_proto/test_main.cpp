@@ -0,0 +1,377 @@
+#include <unity.h>
+
+#include <vector>
+#include "crc32.h"
+#include "history.h"
+#include "sd_logger.h"
+#include "serial_proto.h"
+
+// Not in the native build: it needs the application hooks defined below
+#include "../../src/serial_proto.cpp"
+
+// Both directions of a USB CDC port: the test writes requests into rx and
+// reads responses from tx, with a limit on TX room like a full buffer
+class LoopbackPort : public Stream {
+ public:
+  std::vector<uint8_t> rx;
+  std::vector<uint8_t> tx;
+  size_t rxPos = 0;
+  int txRoom = 4096;
+
+  size_t write(uint8_t b) override { return write(&b, 1); }
+  size_t write(const uint8_t* buf, size_t len) override {
+    if ((int)len > txRoom) len = txRoom;
+    tx.insert(tx.end(), buf, buf + len);
+    txRoom -= len;
+    return len;
+  }
+  using Print::write;
+  int availableForWrite() override { return txRoom; }
+  int available() override { return rx.size() - rxPos; }
+  int read() override { return rxPos < rx.size() ? rx[rxPos++] : -1; }
+  int peek() override { return rxPos < rx.size() ? rx[rxPos] : -1; }
+};
+
+struct Frame {
+  uint8_t type;
+  std::vector<uint8_t> payload;
+};
+
+static LoopbackPort usb;
+static int32_t appliedBrightness = 0;
+static uint32_t hostClock = 0;
+
+// Application hooks and wall clock, as main.cpp and wallclock.cpp provide them
+void protoFillReading(ProtoReading& r) {
+  r.uptime = 42;
+  r.temp = 21.5f;
+  r.humidity = 40.0f;
+  r.pressure = 1013.0f;
+  r.battery = 80;
+  r.charging = 0;
+}
+
+bool protoApplySetting(uint8_t key, int32_t value) {
+  if (key != SETTING_BRIGHTNESS || value < 20 || value > 100) return false;
+  appliedBrightness = value;
+  return true;
+}
+
+void clockSet(uint32_t unixTime) { hostClock = unixTime; }
+bool clockValid() { return hostClock >= 1700000000; }
+
+// SD log with one sample a minute; the value encodes the metric
+static const uint32_t sdStart = 1750000000;
+static bool sdReady = true;
+static int sdQueries = 0;
+
+bool sdLogReady() { return sdReady; }
+
+int sdLogQuery(uint8_t metric, uint32_t t0, uint32_t t1,
+               bool (*fn)(uint32_t time, float value, void* ctx), void* ctx) {
+  sdQueries++;
+  int n = 0;
+  for (uint32_t i = 0; i < 100; i++) {
+    uint32_t t = sdStart + i * 60;
+    if (t < t0 || t > t1) continue;
+    if (!fn(t, metric * 1000.0f + i, ctx)) break;
+    n++;
+  }
+  return n;
+}
+
+static std::vector<uint8_t> encode(uint8_t type, const void* payload, uint16_t len) {
+  std::vector<uint8_t> f = {PROTO_SYNC, type, (uint8_t)(len & 0xFF), (uint8_t)(len >> 8)};
+  f.insert(f.end(), (const uint8_t*)payload, (const uint8_t*)payload + len);
+  uint32_t crc = crc32(f.data() + 1, 3 + len);
+  f.insert(f.end(), (const uint8_t*)&crc, (const uint8_t*)&crc + 4);
+  return f;
+}
+
+static void request(uint8_t type, const void* payload = nullptr, uint16_t len = 0) {
+  std::vector<uint8_t> f = encode(type, payload, len);
+  usb.rx.insert(usb.rx.end(), f.begin(), f.end());
+}
+
+// Splits everything sent so far into frames, checking sync, length and CRC
+static std::vector<Frame> sentFrames() {
+  std::vector<Frame> frames;
+  size_t i = 0;
+  while (i < usb.tx.size()) {
+    TEST_ASSERT_EQUAL_HEX8(PROTO_SYNC, usb.tx[i]);
+    TEST_ASSERT_TRUE(i + 8 <= usb.tx.size());
+    uint16_t len = usb.tx[i + 2] | usb.tx[i + 3] << 8;
+    TEST_ASSERT_TRUE(i + 8 + len <= usb.tx.size());
+    uint32_t crc;
+    memcpy(&crc, &usb.tx[i + 4 + len], 4);
+    TEST_ASSERT_EQUAL_HEX32(crc32(&usb.tx[i + 1], 3 + len), crc);
+    frames.push_back({usb.tx[i + 1], std::vector<uint8_t>(&usb.tx[i + 4], &usb.tx[i + 4 + len])});
+    i += 8 + len;
+  }
+  return frames;
+}
+
+static ProtoStats stats() {
+  ProtoStats s;
+  protoFillStats(s);
+  return s;
+}
+
+void setUp() {
+  usb = LoopbackPort();
+  hostClock = sdStart;
+  sdReady = true;
+  sdQueries = 0;
+  historyClear();
+  protoBegin(usb);
+}
+
+void tearDown() {}
+
+void test_reading_frame_round_trip() {
+  request(CMD_GET_READING);
+  protoPoll();
+  std::vector<Frame> frames = sentFrames();
+  TEST_ASSERT_EQUAL(1, frames.size());
+  TEST_ASSERT_EQUAL_HEX8(RSP_READING, frames[0].type);
+  TEST_ASSERT_EQUAL(sizeof(ProtoReading), frames[0].payload.size());
+  ProtoReading r;
+  memcpy(&r, frames[0].payload.data(), sizeof(r));
+  TEST_ASSERT_EQUAL_UINT32(42, r.uptime);
+  TEST_ASSERT_EQUAL_FLOAT(21.5f, r.temp);
+  TEST_ASSERT_EQUAL_FLOAT(1013.0f, r.pressure);
+  TEST_ASSERT_EQUAL_INT(80, r.battery);
+}
+
+void test_bad_crc_is_rejected_and_counted() {
+  std::vector<uint8_t> f = encode(CMD_GET_READING, nullptr, 0);
+  f.back() ^= 0x01;
+  usb.rx = f;
+  uint32_t errorsBefore = stats().rxErrors;
+  protoPoll();
+  TEST_ASSERT_EQUAL(0, usb.tx.size());
+  TEST_ASSERT_EQUAL_UINT32(errorsBefore + 1, stats().rxErrors);
+
+  // The parser is back in sync for the next frame
+  request(CMD_GET_READING);
+  protoPoll();
+  TEST_ASSERT_EQUAL_HEX8(RSP_READING, sentFrames().at(0).type);
+}
+
+void test_log_text_between_frames_is_skipped() {
+  const char* text = "SHT30 OK!\r\nHistory: 3 points\n";
+  usb.rx.assign(text, text + strlen(text));
+  request(CMD_GET_STATS);
+  protoPoll();
+  std::vector<Frame> frames = sentFrames();
+  TEST_ASSERT_EQUAL(1, frames.size());
+  TEST_ASSERT_EQUAL_HEX8(RSP_STATS, frames[0].type);
+  TEST_ASSERT_EQUAL(sizeof(ProtoStats), frames[0].payload.size());
+}
+
+void test_oversized_length_is_rejected() {
+  uint32_t errorsBefore = stats().rxErrors;
+  uint8_t header[] = {PROTO_SYNC, CMD_GET_READING, 0xFF, 0x7F};
+  usb.rx.assign(header, header + sizeof(header));
+  protoPoll();
+  TEST_ASSERT_EQUAL(0, usb.tx.size());
+  TEST_ASSERT_EQUAL_UINT32(errorsBefore + 1, stats().rxErrors);
+}
+
+void test_errors_for_unknown_command_and_bad_length() {
+  request(0x42);
+  protoPoll();
+  uint8_t shortSetting[2] = {SETTING_BRIGHTNESS, 60};
+  request(CMD_SET_SETTING, shortSetting, sizeof(shortSetting));
+  protoPoll();
+  std::vector<Frame> frames = sentFrames();
+  TEST_ASSERT_EQUAL(2, frames.size());
+  TEST_ASSERT_EQUAL_HEX8(RSP_ERROR, frames[0].type);
+  TEST_ASSERT_EQUAL_UINT8(PROTO_ERR_UNKNOWN_CMD, frames[0].payload.at(0));
+  TEST_ASSERT_EQUAL_HEX8(RSP_ERROR, frames[1].type);
+  TEST_ASSERT_EQUAL_UINT8(PROTO_ERR_BAD_LENGTH, frames[1].payload.at(0));
+}
+
+void test_setting_is_applied_and_echoed() {
+  uint8_t payload[5] = {SETTING_BRIGHTNESS};
+  int32_t value = 60;
+  memcpy(payload + 1, &value, 4);
+  request(CMD_SET_SETTING, payload, sizeof(payload));
+  protoPoll();
+  value = 5;  // Out of range
+  memcpy(payload + 1, &value, 4);
+  request(CMD_SET_SETTING, payload, sizeof(payload));
+  protoPoll();
+  std::vector<Frame> frames = sentFrames();
+  TEST_ASSERT_EQUAL(2, frames.size());
+  TEST_ASSERT_EQUAL_HEX8(RSP_SETTING, frames[0].type);
+  TEST_ASSERT_EQUAL_MEMORY(payload, frames[0].payload.data(), 1);
+  TEST_ASSERT_EQUAL_INT32(60, appliedBrightness);
+  TEST_ASSERT_EQUAL_UINT8(PROTO_ERR_BAD_SETTING, frames[1].payload.at(0));
+}
+
+void test_set_time_rejects_unset_clock_values() {
+  uint32_t t = 1000;
+  request(CMD_SET_TIME, &t, 4);
+  protoPoll();
+  t = 1750000000;
+  request(CMD_SET_TIME, &t, 4);
+  protoPoll();
+  std::vector<Frame> frames = sentFrames();
+  TEST_ASSERT_EQUAL(2, frames.size());
+  TEST_ASSERT_EQUAL_UINT8(PROTO_ERR_BAD_TIME, frames[0].payload.at(0));
+  TEST_ASSERT_EQUAL_HEX8(RSP_TIME, frames[1].type);
+  TEST_ASSERT_EQUAL_UINT32(1750000000, hostClock);
+}
+
+void test_history_dump_streams_every_record_through_a_small_tx_buffer() {
+  const int bins = 50;
+  for (int i = 0; i < bins; i++) {
+    historyAdd(METRIC_TEMP, i * 30, 20.0f + i * 0.1f);
+    historyAdd(METRIC_HUMIDITY, i * 30, 40.0f);
+  }
+  historyAdd(METRIC_PRESSURE, 0, 1000.0f);
+
+  uint8_t dump[9] = {0};
+  uint32_t t1 = 0xFFFFFFFF;
+  memcpy(dump + 5, &t1, 4);
+  request(CMD_DUMP_HISTORY, dump, sizeof(dump));
+  // Only part of a frame fits per poll; the rest waits for room
+  for (int poll = 0; poll < 1000; poll++) {
+    usb.txRoom = 40;
+    protoPoll();
+    if (!protoBusy()) break;
+  }
+  TEST_ASSERT_FALSE(protoBusy());
+
+  std::vector<Frame> frames = sentFrames();
+  TEST_ASSERT_EQUAL_HEX8(RSP_DUMP_BEGIN, frames.front().type);
+  uint16_t count;
+  memcpy(&count, &frames.front().payload[1], 2);
+  TEST_ASSERT_EQUAL_UINT16(bins, count);
+  TEST_ASSERT_EQUAL_UINT8(sizeof(ProtoHistoryRecord), frames.front().payload[3]);
+
+  int records = 0;
+  for (size_t i = 1; i + 1 < frames.size(); i++) {
+    TEST_ASSERT_EQUAL_HEX8(RSP_DUMP_DATA, frames[i].type);
+    TEST_ASSERT_EQUAL(0, frames[i].payload.size() % sizeof(ProtoHistoryRecord));
+    for (size_t off = 0; off < frames[i].payload.size(); off += sizeof(ProtoHistoryRecord)) {
+      ProtoHistoryRecord r;
+      memcpy(&r, &frames[i].payload[off], sizeof(r));
+      TEST_ASSERT_EQUAL_UINT32(records * 30, r.time);
+      TEST_ASSERT_FLOAT_WITHIN(0.001f, 20.0f + records * 0.1f, r.temp);
+      TEST_ASSERT_EQUAL_FLOAT(1000.0f, r.pressure);
+      records++;
+    }
+  }
+  TEST_ASSERT_EQUAL(bins, records);
+  TEST_ASSERT_EQUAL_HEX8(RSP_DUMP_END, frames.back().type);
+  uint16_t sent, skipped;
+  memcpy(&sent, &frames.back().payload[0], 2);
+  memcpy(&skipped, &frames.back().payload[2], 2);
+  TEST_ASSERT_EQUAL_UINT16(bins, sent);
+  TEST_ASSERT_EQUAL_UINT16(0, skipped);
+}
+
+void test_second_dump_while_streaming_is_busy() {
+  historyAdd(METRIC_TEMP, 0, 20.0f);
+  uint8_t dump[9] = {0};
+  uint32_t t1 = 0xFFFFFFFF;
+  memcpy(dump + 5, &t1, 4);
+  request(CMD_DUMP_HISTORY, dump, sizeof(dump));
+  usb.txRoom = 0;  // Nothing goes out yet
+  protoPoll();
+  request(CMD_DUMP_HISTORY, dump, sizeof(dump));
+  for (int poll = 0; poll < 100; poll++) {
+    usb.txRoom = 4096;
+    protoPoll();
+  }
+  std::vector<Frame> frames = sentFrames();
+  bool busy = false;
+  for (const Frame& f : frames) {
+    if (f.type == RSP_ERROR && f.payload.at(0) == PROTO_ERR_BUSY) busy = true;
+  }
+  TEST_ASSERT_TRUE(busy);
+}
+
+void test_trace_dump_without_tracing_reports_error() {
+  request(CMD_DUMP_TRACE);
+  protoPoll();
+  std::vector<Frame> frames = sentFrames();
+  TEST_ASSERT_EQUAL(1, frames.size());
+  TEST_ASSERT_EQUAL_UINT8(PROTO_ERR_NO_TRACE, frames[0].payload.at(0));
+}
+
+static void requestSdDump(uint8_t metric, uint32_t t0, uint32_t t1) {
+  uint8_t payload[9] = {metric};
+  memcpy(payload + 1, &t0, 4);
+  memcpy(payload + 5, &t1, 4);
+  request(CMD_DUMP_SD, payload, sizeof(payload));
+}
+
+void test_sd_dump_streams_a_window_one_query_per_frame() {
+  requestSdDump(METRIC_HUMIDITY, sdStart + 10 * 60, sdStart + 80 * 60);
+  for (int poll = 0; poll < 100 && (protoBusy() || poll == 0); poll++) protoPoll();
+  TEST_ASSERT_FALSE(protoBusy());
+
+  std::vector<Frame> frames = sentFrames();
+  TEST_ASSERT_EQUAL_HEX8(RSP_SD_BEGIN, frames.front().type);
+  TEST_ASSERT_EQUAL_UINT8(METRIC_HUMIDITY, frames.front().payload.at(0));
+  TEST_ASSERT_EQUAL_UINT8(sizeof(ProtoSdRecord), frames.front().payload.at(1));
+  uint32_t expected = 10;
+  for (size_t i = 1; i + 1 < frames.size(); i++) {
+    TEST_ASSERT_EQUAL_HEX8(RSP_SD_DATA, frames[i].type);
+    for (size_t off = 0; off < frames[i].payload.size(); off += sizeof(ProtoSdRecord)) {
+      ProtoSdRecord r;
+      memcpy(&r, &frames[i].payload[off], sizeof(r));
+      TEST_ASSERT_EQUAL_UINT32(sdStart + expected * 60, r.time);
+      TEST_ASSERT_EQUAL_FLOAT(1000.0f + expected, r.value);
+      expected++;
+    }
+  }
+  TEST_ASSERT_EQUAL_UINT32(81, expected);
+  TEST_ASSERT_EQUAL_HEX8(RSP_SD_END, frames.back().type);
+  uint32_t sent;
+  memcpy(&sent, frames.back().payload.data(), 4);
+  TEST_ASSERT_EQUAL_UINT32(71, sent);
+  // 71 samples at 24 per frame; the last frame comes up short, so no empty query
+  TEST_ASSERT_EQUAL_INT(3, sdQueries);
+}
+
+void test_sd_dump_errors() {
+  requestSdDump(METRIC_COUNT, 0, 0xFFFFFFFF);
+  protoPoll();
+  sdReady = false;
+  requestSdDump(METRIC_TEMP, 0, 0xFFFFFFFF);
+  protoPoll();
+  std::vector<Frame> frames = sentFrames();
+  TEST_ASSERT_EQUAL(2, frames.size());
+  TEST_ASSERT_EQUAL_UINT8(PROTO_ERR_BAD_METRIC, frames[0].payload.at(0));
+  TEST_ASSERT_EQUAL_UINT8(PROTO_ERR_NO_SD, frames[1].payload.at(0));
+}
+
+void test_sd_dump_of_an_empty_window() {
+  requestSdDump(METRIC_TEMP, sdStart + 100 * 60, 0xFFFFFFFF);
+  for (int poll = 0; poll < 10; poll++) protoPoll();
+  std::vector<Frame> frames = sentFrames();
+  TEST_ASSERT_EQUAL(2, frames.size());
+  TEST_ASSERT_EQUAL_HEX8(RSP_SD_END, frames[1].type);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_reading_frame_round_trip);
+  RUN_TEST(test_bad_crc_is_rejected_and_counted);
+  RUN_TEST(test_log_text_between_frames_is_skipped);
+  RUN_TEST(test_oversized_length_is_rejected);
+  RUN_TEST(test_errors_for_unknown_command_and_bad_length);
+  RUN_TEST(test_setting_is_applied_and_echoed);
+  RUN_TEST(test_set_time_rejects_unset_clock_values);
+  RUN_TEST(test_history_dump_streams_every_record_through_a_small_tx_buffer);
+  RUN_TEST(test_second_dump_while_streaming_is_busy);
+  RUN_TEST(test_trace_dump_without_tracing_reports_error);
+  RUN_TEST(test_sd_dump_streams_a_window_one_query_per_frame);
+  RUN_TEST(test_sd_dump_errors);
+  RUN_TEST(test_sd_dump_of_an_empty_window);
+  return UNITY_END();
+}
@@ -0,0 +1,125 @@
+#include <unity.h>
+
+#include "sht30_periodic.h"
+
+/*
+ * Sht30Periodic against Sht30SimBus, with the driver polled every 50 ms
+ * the way the sensor task does. Times are driver clock milliseconds.
+ */
+
+static Sht30SimBus sim;
+static Sht30Periodic sht;
+static unsigned long now;
+
+// Poll until `until`, with the sensor's clock running at `sensorRate`
+// of the driver's; returns the readings taken
+static int run(unsigned long until, float sensorRate = 1.0f) {
+  int readings = 0;
+  for (; now < until; now += 50) {
+    sim.nowMs = (unsigned long)(now * sensorRate);
+    if (sht.poll(now)) readings++;
+  }
+  return readings;
+}
+
+void setUp() {
+  sim = Sht30SimBus();
+  sht = Sht30Periodic();
+  now = 0;
+  TEST_ASSERT_TRUE(sht.begin(sim, SHT30_MPS_1, now));
+}
+
+void tearDown() {}
+
+void test_crc_matches_the_datasheet_example() {
+  const uint8_t word[2] = {0xBE, 0xEF};
+  TEST_ASSERT_EQUAL_HEX8(0x92, sht30Crc(word, 2));
+}
+
+void test_one_reading_per_period() {
+  sim.temperature = 23.25f;
+  sim.humidity = 51.0f;
+  TEST_ASSERT_EQUAL_INT(10, run(10050));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 23.25f, sht.cTemp);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 51.0f, sht.humidity);
+  const Sht30Stats& s = sht.stats();
+  TEST_ASSERT_EQUAL_UINT32(10, s.samples);
+  TEST_ASSERT_EQUAL_UINT32(0, s.notReady);
+  // Break and start, then one fetch and one read per reading
+  TEST_ASSERT_EQUAL_UINT32(2 + 10 * 2, s.transfers);
+}
+
+void test_not_ready_fetch_is_retried() {
+  // A sensor running 5 % slow has no new result when the period is up:
+  // the read is NACKed, counted and retried on the following polls
+  int readings = run(20050, 0.95f);
+  const Sht30Stats& s = sht.stats();
+  TEST_ASSERT_TRUE(s.notReady > 0);
+  TEST_ASSERT_EQUAL_UINT32(0, s.restarts);
+  TEST_ASSERT_EQUAL_UINT32(0, s.crcErrors);
+  // Every result the sensor produced was collected, once
+  TEST_ASSERT_EQUAL_INT(19, readings);
+}
+
+void test_crc_error_keeps_the_last_reading() {
+  sim.temperature = 20.0f;
+  run(1050);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 20.0f, sht.cTemp);
+
+  sim.temperature = 30.0f;
+  sim.corrupt = true;
+  run(2050);
+  const Sht30Stats& s = sht.stats();
+  TEST_ASSERT_EQUAL_UINT32(1, s.crcErrors);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 20.0f, sht.cTemp);
+  // The next measurement comes through
+  run(3050);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 30.0f, sht.cTemp);
+  TEST_ASSERT_EQUAL_UINT32(2, s.samples);
+  TEST_ASSERT_EQUAL_UINT32(0, s.restarts);
+}
+
+void test_restart_after_unplug() {
+  run(3050);
+  TEST_ASSERT_EQUAL_UINT32(3, sht.stats().samples);
+
+  // Unplugged for 10 s, then back; it powers up idle, so fetches are NACKed
+  // until periodic mode is started again
+  sim.present = false;
+  run(13050);
+  sim.present = true;
+  sim.command(0x3093);
+  TEST_ASSERT_TRUE(sht.stats().restarts >= 1);
+  uint32_t restarts = sht.stats().restarts;
+  uint32_t before = sht.stats().samples;
+
+  sim.temperature = 18.0f;
+  run(23050);
+  const Sht30Stats& s = sht.stats();
+  // Silent for four periods after the first failed fetch, restarted, and
+  // reading again within the next period
+  TEST_ASSERT_EQUAL_UINT32(restarts + 1, s.restarts);
+  TEST_ASSERT_TRUE(s.samples >= before + 5);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 18.0f, sht.cTemp);
+  // Restarts are spaced by the silent spell, not attempted on every poll
+  TEST_ASSERT_TRUE(s.restarts <= 3);
+}
+
+void test_stop_sends_break() {
+  run(2050);
+  sht.stop();
+  TEST_ASSERT_FALSE(sht.poll(now + 5000));
+  // The sensor is idle: a fetch is not acknowledged
+  TEST_ASSERT_FALSE(sim.command(0xE000));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_crc_matches_the_datasheet_example);
+  RUN_TEST(test_one_reading_per_period);
+  RUN_TEST(test_not_ready_fetch_is_retried);
+  RUN_TEST(test_crc_error_keeps_the_last_reading);
+  RUN_TEST(test_restart_after_unplug);
+  RUN_TEST(test_stop_sends_break);
+  return UNITY_END();
+}
@@ -0,0 +1,134 @@
+#include <unity.h>
+
+#include <math.h>
+#include <stdio.h>
+#include "smoothing.h"
+
+/*
+ * What each smoothing mode trades: how much of the sensor noise it removes
+ * and how long it takes to follow a real change. Readings come every second
+ * like the sensor task takes them.
+ */
+
+static uint32_t seed;
+
+// Gaussian noise from a fixed LCG (Box-Muller), the same on every run
+static float noise(float sd) {
+  auto uniform = [] {
+    seed = seed * 1664525u + 1013904223u;
+    return ((seed >> 8) + 0.5f) / 16777216.0f;
+  };
+  float u1 = uniform(), u2 = uniform();
+  return sd * sqrtf(-2.0f * logf(u1)) * cosf(6.2831853f * u2);
+}
+
+struct Spread {
+  float inVar;
+  float outVar;
+};
+
+// Variance of the input noise and of the output, once settled
+static Spread spread(SmoothMode mode, int tauIndex) {
+  smoothConfigure(mode, tauIndex);
+  smoothReset();
+  seed = 12345;
+  const int warmup = 600, samples = 4000;
+  double inSum = 0, inSq = 0, outSum = 0, outSq = 0;
+  for (int i = 0; i < warmup + samples; i++) {
+    float raw = 22.0f + noise(0.04f);
+    float out = smoothUpdate(METRIC_TEMP, raw, i * 1000UL);
+    if (i < warmup) continue;
+    inSum += raw;
+    inSq += (double)raw * raw;
+    outSum += out;
+    outSq += (double)out * out;
+  }
+  return {(float)(inSq / samples - (inSum / samples) * (inSum / samples)),
+          (float)(outSq / samples - (outSum / samples) * (outSum / samples))};
+}
+
+// Seconds after a 1 C step until the output covers 63 % of it
+static float stepLag(SmoothMode mode, int tauIndex) {
+  smoothConfigure(mode, tauIndex);
+  smoothReset();
+  unsigned long t = 0;
+  for (int i = 0; i < 600; i++, t += 1000) smoothUpdate(METRIC_TEMP, 20.0f, t);
+  for (int i = 1; i <= 1200; i++, t += 1000) {
+    if (smoothUpdate(METRIC_TEMP, 21.0f, t) >= 20.632f) return i;
+  }
+  return INFINITY;
+}
+
+void setUp() {}
+
+void tearDown() {
+  smoothConfigure(SMOOTH_OFF, 1);
+  smoothReset();
+}
+
+void test_off_passes_readings_through() {
+  smoothConfigure(SMOOTH_OFF, 1);
+  TEST_ASSERT_EQUAL_FLOAT(21.0f, smoothUpdate(METRIC_TEMP, 21.0f, 0));
+  TEST_ASSERT_EQUAL_FLOAT(25.0f, smoothUpdate(METRIC_TEMP, 25.0f, 1000));
+  // The bank keeps running underneath, ready for a mode change
+  TEST_ASSERT_TRUE(smoothEma(METRIC_TEMP, 0) > 21.0f && smoothEma(METRIC_TEMP, 0) < 25.0f);
+}
+
+void test_ema_variance_reduction() {
+  for (int i = 0; i < smoothTauCount; i++) {
+    Spread s = spread(SMOOTH_EMA, i);
+    float ratio = s.outVar / s.inVar;
+    // A first-order filter at one sample per second passes about
+    // 1 / (2 tau) of white noise variance
+    float expected = 1.0f / (2.0f * smoothTaus[i]);
+    printf("  EMA    tau %3.0f s: variance x %.4f (expected ~%.4f)\n", smoothTaus[i], ratio, expected);
+    TEST_ASSERT_TRUE(ratio < expected * 1.6f);
+    TEST_ASSERT_TRUE(ratio > expected * 0.4f);
+  }
+}
+
+void test_kalman_variance_reduction() {
+  for (int i = 0; i < smoothTauCount; i++) {
+    float ema = spread(SMOOTH_EMA, i).outVar;
+    Spread s = spread(SMOOTH_KALMAN, i);
+    printf("  Kalman tau %3.0f s: variance x %.4f\n", smoothTaus[i], s.outVar / s.inVar);
+    // Tuned to behave like the EMA of the same time constant once settled
+    TEST_ASSERT_TRUE(s.outVar < s.inVar / 10);
+    TEST_ASSERT_TRUE(s.outVar < ema * 2.0f && s.outVar > ema * 0.5f);
+  }
+}
+
+void test_step_response_lag() {
+  for (int i = 0; i < smoothTauCount; i++) {
+    float ema = stepLag(SMOOTH_EMA, i);
+    float kalman = stepLag(SMOOTH_KALMAN, i);
+    printf("  tau %3.0f s: 63 %% of a step after %.0f s (EMA), %.0f s (Kalman)\n", smoothTaus[i],
+           ema, kalman);
+    // The EMA reaches 63 % after one time constant
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, smoothTaus[i], ema);
+    TEST_ASSERT_TRUE(kalman >= smoothTaus[i] * 0.5f && kalman <= smoothTaus[i] * 1.5f);
+  }
+  TEST_ASSERT_EQUAL_FLOAT(1.0f, stepLag(SMOOTH_OFF, 1));
+}
+
+void test_kalman_settles_from_the_first_reading() {
+  // Started on a reading 0.5 C off: the EMA creeps from it, the Kalman
+  // estimate is pulled to the true level within a few samples
+  smoothConfigure(SMOOTH_KALMAN, 2);
+  smoothReset();
+  smoothUpdate(METRIC_TEMP, 22.5f, 0);
+  float out = 0;
+  for (int i = 1; i <= 10; i++) out = smoothUpdate(METRIC_TEMP, 22.0f, i * 1000UL);
+  TEST_ASSERT_FLOAT_WITHIN(0.1f, 22.0f, out);
+  TEST_ASSERT_TRUE(smoothEma(METRIC_TEMP, 2) > 22.4f);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_off_passes_readings_through);
+  RUN_TEST(test_ema_variance_reduction);
+  RUN_TEST(test_kalman_variance_reduction);
+  RUN_TEST(test_step_response_lag);
+  RUN_TEST(test_kalman_settles_from_the_first_reading);
+  return UNITY_END();
+}
@@ -0,0 +1,223 @@
+#!/usr/bin/env python3
+"""Host client for the CardENV serial command protocol (see include/serial_proto.h).
+
+    tools/envctl.py /dev/ttyACM0 reading
+    tools/envctl.py /dev/ttyACM0 stats
+    tools/envctl.py /dev/ttyACM0 dump --tier 0 --from 0 --to 3600 > history.csv
+    tools/envctl.py /dev/ttyACM0 sdlog temp --from 1760000000 --to 1760086400 > day.csv
+    tools/envctl.py /dev/ttyACM0 set brightness 60
+    tools/envctl.py /dev/ttyACM0 settime
+
+Log text sharing the port is skipped; only CRC-valid frames are accepted.
+"""
+
+import argparse
+import struct
+import sys
+import time
+import zlib
+
+import serial  # pyserial
+
+SYNC = 0xA5
+
+CMD_GET_READING = 0x01
+CMD_DUMP_HISTORY = 0x02
+CMD_GET_STATS = 0x03
+CMD_SET_SETTING = 0x04
+CMD_SET_TIME = 0x05
+CMD_DUMP_TRACE = 0x06
+CMD_DUMP_SD = 0x07
+
+RSP_READING = 0x81
+RSP_DUMP_BEGIN = 0x82
+RSP_DUMP_DATA = 0x83
+RSP_DUMP_END = 0x84
+RSP_STATS = 0x85
+RSP_SETTING = 0x86
+RSP_TIME = 0x87
+RSP_TRACE_BEGIN = 0x88
+RSP_TRACE_DATA = 0x89
+RSP_TRACE_END = 0x8A
+RSP_SD_BEGIN = 0x8B
+RSP_SD_DATA = 0x8C
+RSP_SD_END = 0x8D
+RSP_ERROR = 0xFF
+
+ERRORS = {1: "unknown command", 2: "bad length", 3: "bad tier", 4: "bad setting", 5: "busy",
+          6: "bad time", 7: "built without tracing", 8: "no SD log (card or clock missing)", 9: "bad metric"}
+METRICS = {"temp": 0, "humidity": 1, "pressure": 2}
+SETTINGS = {"brightness": 1, "fahrenheit": 2, "timeout": 3, "smoothing": 4, "smooth_time": 5, "pressure_profile": 6}
+
+RECORD = struct.Struct("<Ifff")
+SD_RECORD = struct.Struct("<If")
+READING = struct.Struct("<IfffbB")
+TRACE_EVENT = struct.Struct("<IBBH")
+STATS = struct.Struct("<IIHIIIII")
+
+
+class ProtocolError(Exception):
+    pass
+
+
+class Client:
+    def __init__(self, port, baud=115200, timeout=2.0):
+        self.ser = serial.Serial(port, baud, timeout=timeout)
+        self.timeout = timeout
+
+    def send(self, ftype, payload=b""):
+        body = struct.pack("<BH", ftype, len(payload)) + payload
+        self.ser.write(bytes([SYNC]) + body + struct.pack("<I", zlib.crc32(body)))
+
+    def _read_exact(self, n):
+        data = self.ser.read(n)
+        if len(data) != n:
+            raise ProtocolError("timed out")
+        return data
+
+    def recv(self):
+        deadline = time.monotonic() + self.timeout
+        while time.monotonic() < deadline:
+            b = self.ser.read(1)
+            if not b or b[0] != SYNC:
+                continue
+            header = self._read_exact(3)
+            ftype, length = struct.unpack("<BH", header)
+            if length > 256:
+                continue
+            payload = self._read_exact(length)
+            (crc,) = struct.unpack("<I", self._read_exact(4))
+            if crc != zlib.crc32(header + payload):
+                continue
+            if ftype == RSP_ERROR:
+                raise ProtocolError(ERRORS.get(payload[0], "error %d" % payload[0]))
+            return ftype, payload
+        raise ProtocolError("timed out")
+
+    def expect(self, ftype):
+        got, payload = self.recv()
+        if got != ftype:
+            raise ProtocolError("unexpected frame 0x%02X" % got)
+        return payload
+
+    def reading(self):
+        self.send(CMD_GET_READING)
+        return READING.unpack(self.expect(RSP_READING))
+
+    def stats(self):
+        self.send(CMD_GET_STATS)
+        return STATS.unpack(self.expect(RSP_STATS))
+
+    def set(self, key, value):
+        self.send(CMD_SET_SETTING, struct.pack("<Bi", key, value))
+        return struct.unpack("<Bi", self.expect(RSP_SETTING))
+
+    def settime(self, unix_time):
+        self.send(CMD_SET_TIME, struct.pack("<I", unix_time))
+        return struct.unpack("<I", self.expect(RSP_TIME))[0]
+
+    def dump(self, tier, t0, t1):
+        self.send(CMD_DUMP_HISTORY, struct.pack("<BII", tier, t0, t1))
+        _, count, record_size = struct.unpack("<BHB", self.expect(RSP_DUMP_BEGIN))
+        if record_size != RECORD.size:
+            raise ProtocolError("record size %d, expected %d" % (record_size, RECORD.size))
+        while True:
+            ftype, payload = self.recv()
+            if ftype == RSP_DUMP_DATA:
+                for off in range(0, len(payload), RECORD.size):
+                    yield RECORD.unpack_from(payload, off)
+            elif ftype == RSP_DUMP_END:
+                sent, skipped = struct.unpack("<HH", payload)
+                if skipped:
+                    print("warning: %d records overwritten during dump" % skipped, file=sys.stderr)
+                return
+            else:
+                raise ProtocolError("unexpected frame 0x%02X" % ftype)
+
+    def sdlog(self, metric, t0, t1):
+        """Yields (unix_time, value) for one metric from the SD card log."""
+        self.send(CMD_DUMP_SD, struct.pack("<BII", metric, t0, t1))
+        _, record_size = struct.unpack("<BB", self.expect(RSP_SD_BEGIN))
+        if record_size != SD_RECORD.size:
+            raise ProtocolError("record size %d, expected %d" % (record_size, SD_RECORD.size))
+        while True:
+            ftype, payload = self.recv()
+            if ftype == RSP_SD_DATA:
+                for off in range(0, len(payload), SD_RECORD.size):
+                    yield SD_RECORD.unpack_from(payload, off)
+            elif ftype == RSP_SD_END:
+                return
+            else:
+                raise ProtocolError("unexpected frame 0x%02X" % ftype)
+
+    def trace(self):
+        """Returns (cpu_mhz, [(cycles, id, phase), ...]), oldest event first."""
+        self.send(CMD_DUMP_TRACE)
+        mhz, count, record_size = struct.unpack("<HHB", self.expect(RSP_TRACE_BEGIN))
+        if record_size != TRACE_EVENT.size:
+            raise ProtocolError("record size %d, expected %d" % (record_size, TRACE_EVENT.size))
+        events = []
+        while True:
+            ftype, payload = self.recv()
+            if ftype == RSP_TRACE_DATA:
+                for off in range(0, len(payload), TRACE_EVENT.size):
+                    cycles, tid, phase, _ = TRACE_EVENT.unpack_from(payload, off)
+                    events.append((cycles, tid, phase))
+            elif ftype == RSP_TRACE_END:
+                return mhz, events
+            else:
+                raise ProtocolError("unexpected frame 0x%02X" % ftype)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("port")
+    ap.add_argument("--baud", type=int, default=115200)
+    sub = ap.add_subparsers(dest="cmd", required=True)
+    sub.add_parser("reading")
+    sub.add_parser("stats")
+    d = sub.add_parser("dump")
+    d.add_argument("--tier", type=int, default=0)
+    d.add_argument("--from", dest="t0", type=int, default=0)
+    d.add_argument("--to", dest="t1", type=int, default=0xFFFFFFFF)
+    l = sub.add_parser("sdlog")
+    l.add_argument("metric", choices=sorted(METRICS))
+    l.add_argument("--from", dest="t0", type=int, default=0, help="Unix time")
+    l.add_argument("--to", dest="t1", type=int, default=0xFFFFFFFF, help="Unix time")
+    s = sub.add_parser("set")
+    s.add_argument("key", choices=sorted(SETTINGS))
+    s.add_argument("value", type=int)
+    t = sub.add_parser("settime")
+    t.add_argument("unix_time", type=int, nargs="?", help="default: this host's clock")
+    args = ap.parse_args()
+
+    client = Client(args.port, args.baud)
+    try:
+        if args.cmd == "reading":
+            uptime, temp, hum, press, batt, charging = client.reading()
+            print("uptime=%d temp=%.2f humidity=%.2f pressure=%.2f battery=%d charging=%d"
+                  % (uptime, temp, hum, press, batt, charging))
+        elif args.cmd == "stats":
+            names = ("uptime", "free_heap", "history_count", "history_seq", "rx_frames", "rx_errors", "tx_frames",
+                     "log_dropped")
+            print(" ".join("%s=%d" % kv for kv in zip(names, client.stats())))
+        elif args.cmd == "dump":
+            print("time,temp,humidity,pressure")
+            for t, temp, hum, press in client.dump(args.tier, args.t0, args.t1):
+                print("%d,%.2f,%.2f,%.2f" % (t, temp, hum, press))
+        elif args.cmd == "sdlog":
+            print("time,%s" % args.metric)
+            for t, value in client.sdlog(METRICS[args.metric], args.t0, args.t1):
+                print("%d,%.2f" % (t, value))
+        elif args.cmd == "set":
+            key, value = client.set(SETTINGS[args.key], args.value)
+            print("%s=%d" % (args.key, value))
+        elif args.cmd == "settime":
+            unix_time = args.unix_time if args.unix_time is not None else int(time.time())
+            print("time=%d" % client.settime(unix_time))
+    except ProtocolError as e:
+        sys.exit("error: %s" % e)
+
+
+if __name__ == "__main__":
+    main()
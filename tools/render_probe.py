@@ -0,0 +1,163 @@
+#!/usr/bin/env python3
+"""Capture render probe output and compare it against golden images and a baseline.
+
+The probe runs either on a unit (flash the `render-probe` environment) or on
+the host (`pio run -e render-host`, which draws the same pages with M5GFX
+built for the host):
+
+    tools/render_probe.py /dev/ttyACM0 --out probe_out --golden golden --baseline baseline.json
+    tools/render_probe.py --host .pio/build/render-host/program --golden golden
+
+Each page is written to <out>/<page>.ppm. With --golden, every page is compared
+pixel-by-pixel against <golden>/<page>.ppm; a page without a golden image, or
+one whose image did not arrive, fails the run. --save-golden writes this run's
+images as the new goldens. With --baseline, the per-page primitive/pixel/time
+counts are printed as deltas against the saved baseline, and pages in the
+baseline that did not report fail the run; --save-baseline writes the current
+run as the new baseline. Draw times are only meaningful on a unit (the host
+build reports 0).
+
+Goldens and baseline are kept in test/render_probe/ and generated with the
+host build, so they can be regenerated and checked without a unit:
+
+    pio run -e render-host
+    tools/render_probe.py --host .pio/build/render-host/program \
+        --golden test/render_probe/golden --save-golden \
+        --baseline test/render_probe/baseline.json --save-baseline
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+
+
+def read_probe(stream):
+    """Parses the probe output from a serial port or the host program's stdout"""
+    stats = {}
+    images = {}
+    started = False
+    while True:
+        line = stream.readline()
+        if not line:
+            sys.exit("no probe output (timed out, or reset the device?)")
+        line = line.decode("ascii", "replace").strip()
+        if line == "probe begin":
+            started = True
+        elif not started:
+            continue
+        elif line == "probe end":
+            return stats, images
+        elif line.startswith("probe "):
+            fields = dict(kv.split("=", 1) for kv in line.split()[1:])
+            page = fields.pop("page")
+            stats[page] = {k: int(v, 16) if k == "crc" else int(v) for k, v in fields.items()}
+        elif line.startswith("ppm "):
+            _, page, size = line.split()
+            data = stream.read(int(size))
+            if len(data) == int(size):  # A short read is a lost image
+                images[page] = data
+
+
+def run_host(program):
+    proc = subprocess.Popen([program], stdout=subprocess.PIPE)
+    try:
+        return read_probe(proc.stdout)
+    finally:
+        proc.stdout.close()
+        proc.wait()
+
+
+def run_serial(port, baud, timeout):
+    import serial  # pyserial
+
+    with serial.Serial(port, baud, timeout=timeout) as ser:
+        return read_probe(ser)
+
+
+def parse_ppm(data):
+    # P6 header: magic, width, height, maxval, then one whitespace byte
+    parts = data.split(maxsplit=4)
+    width, height = int(parts[1]), int(parts[2])
+    return width, height, parts[4]
+
+
+def diff_pixels(a, b):
+    wa, ha, pa = parse_ppm(a)
+    wb, hb, pb = parse_ppm(b)
+    if (wa, ha) != (wb, hb):
+        return None
+    return sum(1 for i in range(0, len(pa), 3) if pa[i:i + 3] != pb[i:i + 3])
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("port", nargs="?", help="serial port of a unit running the render-probe build")
+    ap.add_argument("--host", metavar="PROGRAM", help="run the render-host build instead of reading a port")
+    ap.add_argument("--baud", type=int, default=115200)
+    ap.add_argument("--timeout", type=float, default=15.0)
+    ap.add_argument("--out", default="probe_out")
+    ap.add_argument("--golden", help="directory of golden <page>.ppm images")
+    ap.add_argument("--baseline", help="JSON file with per-page counts from a previous run")
+    ap.add_argument("--save-golden", action="store_true", help="write this run's images into --golden")
+    ap.add_argument("--save-baseline", action="store_true", help="overwrite --baseline with this run")
+    args = ap.parse_args()
+    if bool(args.port) == bool(args.host):
+        ap.error("give either a port or --host")
+
+    if args.host:
+        stats, images = run_host(args.host)
+    else:
+        stats, images = run_serial(args.port, args.baud, args.timeout)
+    os.makedirs(args.out, exist_ok=True)
+    for page, data in images.items():
+        with open(os.path.join(args.out, page + ".ppm"), "wb") as f:
+            f.write(data)
+
+    baseline = {}
+    if args.baseline and os.path.exists(args.baseline) and not args.save_baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+
+    if args.golden and args.save_golden:
+        os.makedirs(args.golden, exist_ok=True)
+        for page, data in images.items():
+            with open(os.path.join(args.golden, page + ".ppm"), "wb") as f:
+                f.write(data)
+
+    failed = False
+    print("%-10s %8s %8s %8s  %s" % ("page", "prims", "pixels", "us", "image"))
+    for page, s in stats.items():
+        image = "-"
+        if page not in images:
+            image = "image missing"
+            failed = True
+        elif args.golden and not args.save_golden:
+            golden_path = os.path.join(args.golden, page + ".ppm")
+            if not os.path.exists(golden_path):
+                image = "no golden"
+                failed = True
+            else:
+                with open(golden_path, "rb") as f:
+                    changed = diff_pixels(f.read(), images[page])
+                image = "size mismatch" if changed is None else ("match" if changed == 0 else "%d px differ" % changed)
+                failed |= changed != 0
+        cols = []
+        for key in ("prims", "pixels", "us"):
+            value = s[key]
+            base = baseline.get(page, {}).get(key)
+            cols.append("%d" % value if base is None else "%d(%+d)" % (value, value - base))
+        print("%-10s %8s %8s %8s  %s" % (page, cols[0], cols[1], cols[2], image))
+    for page in sorted(set(baseline) - set(stats)):
+        print("%-10s %8s %8s %8s  %s" % (page, "-", "-", "-", "not reported"))
+        failed = True
+
+    if args.baseline and args.save_baseline:
+        with open(args.baseline, "w") as f:
+            json.dump(stats, f, indent=2, sort_keys=True)
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+"""Tests for envctl.py against a device emulator on a pseudo-terminal.
+
+    python3 tools/test_envctl.py
+
+The emulator answers frames the way src/serial_proto.cpp does, and mixes in
+log text and a corrupted frame to check that the client skips them.
+"""
+
+import os
+import struct
+import sys
+import threading
+import tty
+import unittest
+import zlib
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+
+try:
+    import envctl
+except ImportError:  # pyserial missing
+    envctl = None
+
+
+def frame(ftype, payload=b""):
+    body = struct.pack("<BH", ftype, len(payload)) + payload
+    return bytes([0xA5]) + body + struct.pack("<I", zlib.crc32(body))
+
+
+class DeviceEmulator(threading.Thread):
+    """Reads request frames from the pty master and writes responses."""
+
+    def __init__(self, fd, history):
+        super().__init__(daemon=True)
+        self.fd = fd
+        self.history = history
+        self.sd_log = [(1750000000 + i * 60, float(i)) for i in range(100)]
+        self.buf = b""
+        self.requests = []
+
+    def _read(self, n):
+        while len(self.buf) < n:
+            try:
+                chunk = os.read(self.fd, 4096)
+            except OSError:
+                return None
+            if not chunk:
+                return None
+            self.buf += chunk
+        data, self.buf = self.buf[:n], self.buf[n:]
+        return data
+
+    def run(self):
+        while True:
+            sync = self._read(1)
+            if sync is None:
+                return
+            if sync[0] != 0xA5:
+                continue
+            header = self._read(3)
+            ftype, length = struct.unpack("<BH", header)
+            payload = self._read(length)
+            (crc,) = struct.unpack("<I", self._read(4))
+            if crc != zlib.crc32(header + payload):
+                continue
+            self.requests.append((ftype, payload))
+            os.write(self.fd, self.respond(ftype, payload))
+
+    def respond(self, ftype, payload):
+        # Log lines share the port with frames
+        out = b"SHT30 OK!\r\n"
+        if ftype == envctl.CMD_GET_READING:
+            reading = envctl.READING.pack(42, 21.5, 40.0, 1013.0, 80, 0)
+            # A damaged copy first: the client must drop it on CRC
+            bad = bytearray(frame(envctl.RSP_READING, envctl.READING.pack(1, 0.0, 0.0, 0.0, 0, 0)))
+            bad[-1] ^= 0xFF
+            out += bytes(bad) + frame(envctl.RSP_READING, reading)
+        elif ftype == envctl.CMD_GET_STATS:
+            out += frame(envctl.RSP_STATS, envctl.STATS.pack(3600, 200000, 25, 1, 2, 3, 4, 5))
+        elif ftype == envctl.CMD_SET_SETTING:
+            key, value = struct.unpack("<Bi", payload)
+            if key == envctl.SETTINGS["brightness"] and 20 <= value <= 100:
+                out += frame(envctl.RSP_SETTING, payload)
+            else:
+                out += frame(envctl.RSP_ERROR, bytes([4]))
+        elif ftype == envctl.CMD_SET_TIME:
+            out += frame(envctl.RSP_TIME, payload)
+        elif ftype == envctl.CMD_DUMP_SD:
+            metric, t0, t1 = struct.unpack("<BII", payload)
+            samples = [(t, v + metric) for t, v in self.sd_log if t0 <= t <= t1]
+            out += frame(envctl.RSP_SD_BEGIN, struct.pack("<BB", metric, envctl.SD_RECORD.size))
+            for i in range(0, len(samples), 24):
+                chunk = b"".join(envctl.SD_RECORD.pack(*r) for r in samples[i:i + 24])
+                out += frame(envctl.RSP_SD_DATA, chunk)
+            out += frame(envctl.RSP_SD_END, struct.pack("<I", len(samples)))
+        elif ftype == envctl.CMD_DUMP_HISTORY:
+            _, t0, t1 = struct.unpack("<BII", payload)
+            records = [r for r in self.history if t0 <= r[0] <= t1]
+            out += frame(envctl.RSP_DUMP_BEGIN, struct.pack("<BHB", 0, len(records), envctl.RECORD.size))
+            per_frame = 256 // envctl.RECORD.size
+            for i in range(0, len(records), per_frame):
+                chunk = b"".join(envctl.RECORD.pack(*r) for r in records[i:i + per_frame])
+                out += frame(envctl.RSP_DUMP_DATA, chunk)
+            out += frame(envctl.RSP_DUMP_END, struct.pack("<HH", len(records), 0))
+        else:
+            out += frame(envctl.RSP_ERROR, bytes([1]))
+        return out
+
+
+@unittest.skipIf(envctl is None, "pyserial not installed")
+class EnvctlTest(unittest.TestCase):
+    def setUp(self):
+        master, slave = os.openpty()
+        tty.setraw(slave)
+        tty.setraw(master)
+        self.master = master
+        self.slave = slave
+        self.history = [(t * 30, 20.0 + t * 0.5, 40.0, 1000.0) for t in range(40)]
+        self.device = DeviceEmulator(master, self.history)
+        self.device.start()
+        self.client = envctl.Client(os.ttyname(slave), timeout=2.0)
+
+    def tearDown(self):
+        self.client.ser.close()
+        os.close(self.slave)
+        os.close(self.master)
+        self.device.join(1.0)
+
+    def test_reading_skips_log_text_and_bad_crc(self):
+        uptime, temp, humidity, pressure, battery, charging = self.client.reading()
+        self.assertEqual(uptime, 42)
+        self.assertEqual(temp, 21.5)
+        self.assertEqual(pressure, 1013.0)
+        self.assertEqual(battery, 80)
+
+    def test_stats(self):
+        stats = self.client.stats()
+        self.assertEqual(stats[0], 3600)
+        self.assertEqual(stats[2], 25)
+
+    def test_set_echoes_and_reports_errors(self):
+        self.assertEqual(self.client.set(envctl.SETTINGS["brightness"], 60), (1, 60))
+        with self.assertRaisesRegex(envctl.ProtocolError, "bad setting"):
+            self.client.set(envctl.SETTINGS["brightness"], 5)
+
+    def test_settime(self):
+        self.assertEqual(self.client.settime(1750000000), 1750000000)
+        self.assertEqual(self.device.requests[-1], (envctl.CMD_SET_TIME, struct.pack("<I", 1750000000)))
+
+    def test_dump_reassembles_records_across_frames(self):
+        records = list(self.client.dump(0, 0, 600))
+        self.assertEqual(len(records), 21)
+        self.assertEqual(records[0], self.history[0])
+        self.assertEqual(records[-1], self.history[20])
+
+    def test_sdlog_reassembles_samples_across_frames(self):
+        samples = list(self.client.sdlog(envctl.METRICS["pressure"], 1750000000 + 600, 1750000000 + 4800))
+        self.assertEqual(len(samples), 71)
+        self.assertEqual(samples[0], (1750000600, 12.0))
+        self.assertEqual(samples[-1], (1750004800, 82.0))
+
+    def test_unknown_command_raises(self):
+        self.client.send(0x42)
+        with self.assertRaisesRegex(envctl.ProtocolError, "unknown command"):
+            self.client.recv()
+
+
+if __name__ == "__main__":
+    unittest.main()
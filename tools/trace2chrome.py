@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+"""Pull the firmware trace ring and write it as Chrome trace JSON.
+
+Build with -DENABLE_TRACE=1, let the device run for a few seconds, then:
+
+    tools/trace2chrome.py /dev/ttyACM0 trace.json
+
+and open trace.json in https://ui.perfetto.dev (or chrome://tracing).
+Timestamps are CPU cycles converted at the clock reported by the device;
+the 32-bit cycle counter wrapping (every ~18 s at 240 MHz) is undone, so a
+ring spanning more than one wrap between two events would be misplaced.
+Begin/end pairs cut off by the start of the ring are dropped.
+"""
+
+import argparse
+import json
+import sys
+
+from envctl import Client, ProtocolError
+
+# TraceId in include/trace.h
+NAMES = [
+    "loop",
+    "handleKeyboard",
+    "readSensors",
+    "updateHistory",
+    "drawBattery",
+    "drawMainPageStatic",
+    "updateMainPageValues",
+    "drawGraphPageStatic",
+    "updateGraphValue",
+    "drawSettingsPageStatic",
+    "drawYearPageStatic",
+    "drawWeekPageStatic",
+    "drawDensityPageStatic",
+    "drawDiagPageStatic",
+    "updateDiagPage",
+]
+
+
+def to_chrome(mhz, events):
+    out = []
+    depth = 0
+    offset = -events[0][0] if events else 0  # Trace starts at 0
+    prev = None
+    for cycles, tid, phase in events:
+        if prev is not None and cycles < prev:
+            offset += 1 << 32
+        prev = cycles
+        if phase == 0:
+            depth += 1
+        elif depth == 0:
+            continue  # End of a span that began before the oldest event
+        else:
+            depth -= 1
+        name = NAMES[tid] if tid < len(NAMES) else "id%d" % tid
+        out.append({
+            "name": name,
+            "cat": "firmware",
+            "ph": "B" if phase == 0 else "E",
+            "ts": (cycles + offset) / mhz,  # microseconds
+            "pid": 1,
+            "tid": 1,
+        })
+    return {"traceEvents": out, "displayTimeUnit": "ns",
+            "otherData": {"cpu_mhz": mhz, "events": len(events)}}
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("port")
+    ap.add_argument("out", help="JSON file to write")
+    ap.add_argument("--baud", type=int, default=115200)
+    args = ap.parse_args()
+
+    try:
+        mhz, events = Client(args.port, args.baud).trace()
+    except ProtocolError as e:
+        sys.exit("error: %s" % e)
+    if not events:
+        sys.exit("trace ring is empty")
+    trace = to_chrome(mhz, events)
+    with open(args.out, "w") as f:
+        json.dump(trace, f)
+    span = (trace["traceEvents"][-1]["ts"] - trace["traceEvents"][0]["ts"]) / 1000 if trace["traceEvents"] else 0
+    print("%d events over %.1f ms at %d MHz -> %s" % (len(events), span, mhz, args.out))
+
+
+if __name__ == "__main__":
+    main()